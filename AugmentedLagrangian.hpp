@@ -0,0 +1,316 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#include "GradientDescent.hpp"
+#include "LBFGSDescent.hpp"
+#include "ConjugateGradientDescent.hpp"
+#include "Evaluator.hpp"
+#include "Bounds.hpp"
+
+namespace tpr {
+	/**
+	 * @brief augmented Lagrangian (Powell-Hestenes-Rockafellar) algorithm
+	 * min(f(x))
+	 * with contraints
+	 * gi(x) <= 0
+	 * L(x, lambda, c) = f(x) + 1 / (2 * c) * sum( max( 0, lambda[i] + c * gi(x) )^2 - lambda[i]^2 )
+	 * grad( L ) = grad( f(x) ) + sum( max( 0, lambda[i] + c * gi(x) ) * grad( gi(x) ) )
+	 *
+	 * while true
+	 * do
+	 *     x_opt = min( L(x, lambda, c) )
+	 *     lambda[i] = max( 0, lambda[i] + c * gi(x_opt) )
+	 *
+	 *     if max( | lambda_new[i] - lambda[i] | ) / c <= FeasibilityEpsilon
+	 *     then
+	 *        return x_opt
+	 *     end
+	 *
+	 *     if max( 0, gi(x_opt) ) <= FeasibilityEpsilon and | f( x_opt ) - f( x_prev ) | / | f( x_opt ) | <= Epsilon
+	 *     then
+	 *        return x_opt
+	 *     end
+	 *
+	 *     if max( 0, gi(x_opt) ) did not shrink by Contraction
+	 *     then
+	 *        if c = MaxC
+	 *        then
+	 *           return x_opt // no feasible x in reach
+	 *        end
+	 *        c = min( Beta * c, MaxC )
+	 *     end
+	 * done
+	 *
+	 * Multipliers carry the constraint forces between outer iterations,
+	 * so c stays bounded and the inner problem does not become ill-conditioned as with PenaltyFunction.
+	 */
+	template<
+		typename FT, //minimizing function
+		typename IndexType,
+		typename ... GiFuncTypes
+	>
+	class AugmentedLagrangian {
+	public: // == TYPES ==
+		using TargetF	= FT;
+		using ValueType = typename TargetF::ValueType;
+		using VectorT	= typename TargetF::VectorT;
+		using ThisT		= AugmentedLagrangian<FT, IndexType, GiFuncTypes ...>;
+		using MultipliersT = std::array<ValueType, sizeof...(GiFuncTypes)>;
+
+	public: // == CONSTANTS ==
+		static constexpr ValueType	Beta				= 2.0;			//!< growth factor of c.
+		static constexpr ValueType	Epsilon				= 1e-5;			//!< relative accuracy of f( x )
+		static constexpr ValueType	FeasibilityEpsilon	= 1e-4;			//!< max( 0, gi(x) ) accepted as feasible
+		static constexpr ValueType	Contraction			= 0.25;			//!< required shrink of violation per outer iteration
+		static constexpr ValueType	DefaultC			= 1.0;			//!< positive constant
+		static constexpr ValueType	MaxC				= 1e6;			//!< upper bound of c
+		static constexpr IndexType	N					= TargetF::N;	//!< sizeof Xopt vector
+		static constexpr IndexType	M					= sizeof...(GiFuncTypes);	//!< number of constraints
+		static constexpr IndexType	MaxPIterations		= 1'000;
+
+	public: // == TYPES ==
+		/**
+		 * term of the i-th constraint
+		 * 1 / (2 * c) * ( max( 0, lambda[i] + c * gi(x) )^2 - lambda[i]^2 )
+		 */
+		template<size_t I, typename G, typename... GiTail>
+		struct LagrangeTerm {
+			using Head = LagrangeTerm< I, G >;
+			using Tail = LagrangeTerm< I + 1, GiTail ... >;
+
+			static ValueType apply(ValueType c, const MultipliersT& lambda, const VectorT& xArgs) {
+				return Head::apply(c, lambda, xArgs) + Tail::apply(c, lambda, xArgs);
+			}
+
+			static void accumulate(ValueType c, const MultipliersT& lambda, const VectorT& xArgs, ValueType& value, VectorT& grad) {
+				Head::accumulate(c, lambda, xArgs, value, grad);
+				Tail::accumulate(c, lambda, xArgs, value, grad);
+			}
+
+			/**
+			 * lambda[i] = max( 0, lambda[i] + c * gi(x) ),
+			 * returns max( | lambda_new[i] - lambda[i] | / c ) = max( | max( gi(x), -lambda[i] / c ) | ),
+			 * infeasibility = max( max( 0, gi(x) ) )
+			 */
+			static ValueType update(ValueType c, MultipliersT& lambda, const VectorT& xArgs, ValueType& infeasibility) {
+				ValueType head = Head::update(c, lambda, xArgs, infeasibility);
+				return std::max(head, Tail::update(c, lambda, xArgs, infeasibility));
+			}
+		};
+
+		// end of recursion.
+		template<size_t I, typename G>
+		struct LagrangeTerm<I, G> {
+			static ValueType apply(ValueType c, const MultipliersT& lambda, const VectorT& xArgs) {
+				ValueType shifted = std::max(0.0, lambda[I] + c * G::apply(xArgs));
+				return (shifted * shifted - lambda[I] * lambda[I]) / (2.0 * c);
+			}
+
+			static void accumulate(ValueType c, const MultipliersT& lambda, const VectorT& xArgs, ValueType& value, VectorT& grad) {
+				using GiEvaluator = SparseEvaluator<G>;
+				ValueType g = G::apply(xArgs);
+				ValueType shifted = std::max(0.0, lambda[I] + c * g);
+				value += (shifted * shifted - lambda[I] * lambda[I]) / (2.0 * c);
+
+				// the gradient pass only runs for a term that contributes to grad( L )
+				if (shifted > 0) {
+					typename GiEvaluator::GradientT gGrad;
+					GiEvaluator::evaluate(xArgs, g, gGrad);
+					GiEvaluator::scatter(shifted, gGrad, grad);
+				}
+			}
+
+			static ValueType update(ValueType c, MultipliersT& lambda, const VectorT& xArgs, ValueType& infeasibility) {
+				ValueType old = lambda[I];
+				ValueType g = G::apply(xArgs);
+				lambda[I] = std::max(0.0, old + c * g);
+				infeasibility = std::max(infeasibility, g);
+				// zero when gi(x) <= 0 and lambda[i] * gi(x) = 0: feasible and complementary
+				return std::fabs(lambda[I] - old) / c;
+			}
+		};
+
+		using Terms = LagrangeTerm<0, GiFuncTypes ...>;
+
+		/**
+		 * L(x, lambda, c) for fixed lambda and c,
+		 * both are held by reference, the solver updates them between inner solves, as are the bounds of x.
+		 */
+		struct LagrangianFunction {
+			using ValueType = typename ThisT::ValueType;
+			using VectorT	= typename ThisT::VectorT;
+			static constexpr int N = ThisT::N;
+
+			const ValueType&		c;
+			const MultipliersT&		lambda;
+			const Box<ValueType>*	bounds = nullptr;
+
+			LagrangianFunction(const ValueType& cRef, const MultipliersT& lambdaRef) : c(cRef), lambda(lambdaRef) {}
+
+			LagrangianFunction(const ValueType& cRef, const MultipliersT& lambdaRef, const Box<ValueType>& boundsRef)
+				: c(cRef), lambda(lambdaRef), bounds(&boundsRef) {}
+
+			/**
+			 * box the projecting descents keep x in, empty when there is none
+			 */
+			const Box<ValueType>& box() const {
+				static const Box<ValueType> none;
+				return bounds ? *bounds : none;
+			}
+
+			ValueType apply(const VectorT& xArgs) const {
+				return TargetF::apply(xArgs) + Terms::apply(c, lambda, xArgs);
+			}
+
+			void evaluate(const VectorT& xArgs, ValueType& value, VectorT& grad) const {
+				Evaluator<TargetF>::evaluate(xArgs, value, grad);
+				Terms::accumulate(c, lambda, xArgs, value, grad);
+			}
+
+			VectorT gradient(const VectorT& xArgs) const {
+				ValueType value;
+				VectorT rval;
+				evaluate(xArgs, value, rval);
+				return rval;
+			}
+		};
+
+	private: // == MEMBERS ==
+		ValueType		mC					= DefaultC;		//!< c
+		MultipliersT	mMultipliers		= {};			//!< lambda[i], one per gi
+		Box<ValueType>	mBounds;							//!< bounds of x, enforced by the descent
+		ValueType		mLambda				= ValueType();	//!< step of the last inner solve
+		IndexType		mOuterIterations	= 0;			//!< inner solves done
+		IndexType		mInnerIterations	= 0;			//!< descent iterations over all inner solves
+		IndexType		mTruncatedSolves	= 0;			//!< inner solves the descent ended at its MaxIterations
+
+	public: // == METHODS ==
+		/**
+		 * max( 0, max( gi(x) ) ), zero for a feasible x
+		 */
+		static ValueType infeasibility(const VectorT& xArgs) {
+			ValueType values[] = { ValueType(), GiFuncTypes::apply(xArgs) ... };
+			return *std::max_element(std::begin(values), std::end(values));
+		}
+
+		/**
+		 * solves with a solver object of its own, see solve.
+		 */
+		template<template<typename, typename> class GradientDescentT = StepSplitGradientDescent>
+		static VectorT evaluate(const VectorT& x0) {
+			ThisT solver;
+			return solver.template solve<GradientDescentT>(x0);
+		}
+
+		/**
+		 * lower <= x <= upper, kept by projection as in PenaltyFunction::setBounds.
+		 * Without them the inner problem of a model whose f is bounded below only by x >= 0, as subj_17, has no minimum
+		 * and the inner descent runs until its own step rule stops it.
+		 * @param bounds	N entries or empty to drop them
+		 */
+		void setBounds(const Box<ValueType>& bounds) {
+			assert(bounds.empty() || bounds.size() == N);
+			mBounds = bounds;
+		}
+
+		const Box<ValueType>& bounds() const {
+			return mBounds;
+		}
+
+		/**
+		 * The state of a solve lives in this object, so separate objects may solve concurrently.
+		 * Each inner solve starts with the step the previous one ended with, never below GradientDescent::Lambda:
+		 * L changes only by the shifted multipliers between them.
+		 * A model with no feasible x returns once c reached MaxC and the violation stopped shrinking, infeasibility( x ) > 0 then.
+		 * @tparam GradientDescentT	minimizer of L(x, lambda, c), see PenaltyFunction::solve
+		 */
+		template<template<typename, typename> class GradientDescentT = StepSplitGradientDescent>
+		VectorT solve(const VectorT& x0) {
+			mC = DefaultC;
+			mMultipliers.fill(ValueType());
+			mOuterIterations = 0;
+			mInnerIterations = 0;
+			mTruncatedSolves = 0;
+			VectorT xArgs = x0;
+			const LagrangianFunction lagrangian(mC, mMultipliers, mBounds);
+			using GradientDescent = GradientDescentT<LagrangianFunction, IndexType>;
+			requireProjection<GradientDescent>(mBounds);
+			mBounds.project(xArgs);
+			ValueType oldInfeasibility = HUGE_VAL;
+			mLambda = GradientDescent::Lambda;
+			IndexType idx = 0;
+
+			for (; idx < MaxPIterations; idx++) {
+				IndexType it = 0;
+
+				// find min( L(x, lambda, c) ), warm started with the last step
+				mLambda = std::max(mLambda, ValueType(GradientDescent::Lambda));
+				VectorT xOptLoc = GradientDescent::calculate(lagrangian, xArgs, mLambda, it);
+				mOuterIterations++;
+				mInnerIterations += it;
+				mTruncatedSolves += it >= GradientDescent::MaxIterations ? 1 : 0;
+				ValueType infeasibility = 0.0;
+				ValueType residual = Terms::update(mC, mMultipliers, xOptLoc, infeasibility);
+				ValueType fOpt = TargetF::apply(xOptLoc);
+				ValueType eps = std::fabs(fOpt - TargetF::apply(xArgs)) / std::max(ValueType(1.0), std::fabs(fOpt));
+
+				xArgs = xOptLoc;
+
+				// feasible, and the multipliers did not move: x_opt is a KKT point
+				if (residual <= FeasibilityEpsilon)
+					return xOptLoc;
+
+				// feasible, and f( x_opt ) stalled: an inexact inner solve will not get closer
+				if (infeasibility <= FeasibilityEpsilon && eps <= Epsilon)
+					return xOptLoc;
+
+				// the multipliers alone do not pull x into the feasible set fast enough
+				if (infeasibility > Contraction * oldInfeasibility) {
+					// nor does the largest c: the constraints can not be met from here
+					if (mC >= MaxC)
+						return xOptLoc;
+
+					mC = std::min(mC * ThisT::Beta, ValueType(MaxC));
+				}
+
+				oldInfeasibility = infeasibility;
+			}
+
+			if (idx >= MaxPIterations) {
+				assert(0 && "Failure");
+			}
+
+			return xArgs;
+		}
+
+		ValueType coefficient() const {
+			return mC;
+		}
+
+		const MultipliersT& multipliers() const {
+			return mMultipliers;
+		}
+
+		ValueType lambda() const {
+			return mLambda;
+		}
+
+		IndexType outerIterations() const {
+			return mOuterIterations;
+		}
+
+		IndexType innerIterations() const {
+			return mInnerIterations;
+		}
+
+		/**
+		 * inner solves of the last solve that ran out of descent iterations, a bounded descent returns its best x then
+		 */
+		IndexType truncatedSolves() const {
+			return mTruncatedSolves;
+		}
+	};
+}// namespace tpr
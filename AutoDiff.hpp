@@ -0,0 +1,306 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+#include "Evaluator.hpp"
+
+/**
+ * Dual arithmetic only pays off when every operation is inlined into apply,
+ * otherwise the lanes go through memory and the seeds cannot be folded.
+ */
+#if defined(_MSC_VER)
+#define TPR_FORCEINLINE __forceinline
+#else
+#define TPR_FORCEINLINE inline __attribute__((always_inline))
+#endif
+
+namespace tpr {
+	/**
+	 * @brief forward mode dual number: a value and its derivatives along Lanes directions.
+	 * A constraint written once as a template
+	 *
+	 * template<typename VecT>
+	 * static auto apply(const VecT& args) {
+	 *     using std::sqrt;
+	 *     return 1.5 * args[x111] + 1.282 * sqrt( 0.083 * sqr(args[x111]) ) - 250;
+	 * }
+	 *
+	 * runs on plain doubles for gi(x) and on Dual for gi(x) together with its gradient, see AutoGradient.
+	 * Every operation is expanded over the lanes at compile time, apply becomes straight-line code
+	 * the compiler vectorizes, and lanes holding constants (seeds, linear terms) are folded.
+	 * Math functions are friends found by argument dependent lookup,
+	 * call them unqualified: sqrt(x), sqr(x), pow(x, 2), max(x, y).
+	 */
+	template<typename T, size_t Lanes>
+	struct Dual {
+	public: // == TYPES ==
+		using ValueType = T;
+		using TangentT	= std::array<T, Lanes>;
+		using ThisT		= Dual<T, Lanes>;
+
+	public: // == MEMBERS ==
+		T			value;		//!< f(x)
+		TangentT	tangent;	//!< tangent[k] = df/dx along lane k
+
+	public: // == METHODS ==
+		Dual() : value(), tangent() {}
+
+		/**
+		 * constant, all derivatives are zero
+		 */
+		explicit Dual(T v) : value(v), tangent() {}
+
+		Dual(T v, const TangentT& t) : value(v), tangent(t) {}
+
+		TPR_FORCEINLINE ThisT& operator+=(const ThisT& rhs) { return *this = *this + rhs; }
+		TPR_FORCEINLINE ThisT& operator-=(const ThisT& rhs) { return *this = *this - rhs; }
+		TPR_FORCEINLINE ThisT& operator*=(const ThisT& rhs) { return *this = *this * rhs; }
+		TPR_FORCEINLINE ThisT& operator/=(const ThisT& rhs) { return *this = *this / rhs; }
+		TPR_FORCEINLINE ThisT& operator+=(T rhs) { return *this = *this + rhs; }
+		TPR_FORCEINLINE ThisT& operator-=(T rhs) { return *this = *this - rhs; }
+		TPR_FORCEINLINE ThisT& operator*=(T rhs) { return *this = *this * rhs; }
+		TPR_FORCEINLINE ThisT& operator/=(T rhs) { return *this = *this / rhs; }
+
+		friend TPR_FORCEINLINE ThisT operator-(const ThisT& u) {
+			return ThisT(-u.value, Negate(u.tangent, Seq()));
+		}
+
+		friend TPR_FORCEINLINE ThisT operator+(const ThisT& u, const ThisT& v) {
+			return ThisT(u.value + v.value, Add(u.tangent, v.tangent, Seq()));
+		}
+
+		friend TPR_FORCEINLINE ThisT operator+(const ThisT& u, T v) { return ThisT(u.value + v, u.tangent); }
+		friend TPR_FORCEINLINE ThisT operator+(T u, const ThisT& v) { return ThisT(u + v.value, v.tangent); }
+
+		friend TPR_FORCEINLINE ThisT operator-(const ThisT& u, const ThisT& v) {
+			return ThisT(u.value - v.value, Subtract(u.tangent, v.tangent, Seq()));
+		}
+
+		friend TPR_FORCEINLINE ThisT operator-(const ThisT& u, T v) { return ThisT(u.value - v, u.tangent); }
+		friend TPR_FORCEINLINE ThisT operator-(T u, const ThisT& v) { return ThisT(u - v.value, Negate(v.tangent, Seq())); }
+
+		/**
+		 * ( u * v )' = u' * v + u * v'
+		 */
+		friend TPR_FORCEINLINE ThisT operator*(const ThisT& u, const ThisT& v) {
+			return ThisT(u.value * v.value, Combine(u.tangent, v.value, v.tangent, u.value, Seq()));
+		}
+
+		friend TPR_FORCEINLINE ThisT operator*(const ThisT& u, T v) { return ThisT(u.value * v, Scale(u.tangent, v, Seq())); }
+		friend TPR_FORCEINLINE ThisT operator*(T u, const ThisT& v) { return ThisT(u * v.value, Scale(v.tangent, u, Seq())); }
+
+		/**
+		 * ( u / v )' = ( u' - ( u / v ) * v' ) / v
+		 */
+		friend TPR_FORCEINLINE ThisT operator/(const ThisT& u, const ThisT& v) {
+			T rval = u.value / v.value;
+			T inv = T(1) / v.value;
+			return ThisT(rval, Combine(u.tangent, inv, v.tangent, -rval * inv, Seq()));
+		}
+
+		friend TPR_FORCEINLINE ThisT operator/(const ThisT& u, T v) { return ThisT(u.value / v, Scale(u.tangent, T(1) / v, Seq())); }
+
+		/**
+		 * ( a / v )' = -a * v' / v^2
+		 */
+		friend TPR_FORCEINLINE ThisT operator/(T u, const ThisT& v) {
+			T inv = T(1) / v.value;
+			return Chain(v, u * inv, -u * inv * inv);
+		}
+
+		friend TPR_FORCEINLINE bool operator<(const ThisT& u, const ThisT& v) { return u.value < v.value; }
+		friend TPR_FORCEINLINE bool operator>(const ThisT& u, const ThisT& v) { return u.value > v.value; }
+		friend TPR_FORCEINLINE bool operator<(const ThisT& u, T v) { return u.value < v; }
+		friend TPR_FORCEINLINE bool operator>(const ThisT& u, T v) { return u.value > v; }
+		friend TPR_FORCEINLINE bool operator<(T u, const ThisT& v) { return u < v.value; }
+		friend TPR_FORCEINLINE bool operator>(T u, const ThisT& v) { return u > v.value; }
+
+		/**
+		 * sqrt( u )' = u' / ( 2 * sqrt( u ) ), sqrt is computed once for the value and all lanes
+		 */
+		friend TPR_FORCEINLINE ThisT sqrt(const ThisT& u) {
+			using std::sqrt;
+			T root = sqrt(u.value);
+			return Chain(u, root, T(0.5) / root);
+		}
+
+		/**
+		 * ( u^2 )' = 2 * u * u', found before the sqr helpers of the models
+		 */
+		friend TPR_FORCEINLINE ThisT sqr(const ThisT& u) {
+			return Chain(u, u.value * u.value, T(2) * u.value);
+		}
+
+		friend TPR_FORCEINLINE ThisT exp(const ThisT& u) {
+			using std::exp;
+			T e = exp(u.value);
+			return Chain(u, e, e);
+		}
+
+		friend TPR_FORCEINLINE ThisT log(const ThisT& u) {
+			using std::log;
+			return Chain(u, log(u.value), T(1) / u.value);
+		}
+
+		friend TPR_FORCEINLINE ThisT fabs(const ThisT& u) {
+			return u.value < T() ? -u : u;
+		}
+
+		/**
+		 * ( u^p )' = p * u^(p-1) * u'
+		 */
+		friend TPR_FORCEINLINE ThisT pow(const ThisT& u, int p) {
+			using std::pow;
+			T head = pow(u.value, p - 1);
+			return Chain(u, head * u.value, p * head);
+		}
+
+		friend TPR_FORCEINLINE ThisT pow(const ThisT& u, T p) {
+			using std::pow;
+			T head = pow(u.value, p - 1);
+			return Chain(u, head * u.value, p * head);
+		}
+
+		/**
+		 * the derivative of the selected argument, e.g. max( 0, gi(x) ) of R1
+		 */
+		friend TPR_FORCEINLINE ThisT max(const ThisT& u, const ThisT& v) { return u.value < v.value ? v : u; }
+		friend TPR_FORCEINLINE ThisT max(const ThisT& u, T v) { return u.value < v ? ThisT(v) : u; }
+		friend TPR_FORCEINLINE ThisT max(T u, const ThisT& v) { return v.value < u ? ThisT(u) : v; }
+		friend TPR_FORCEINLINE ThisT min(const ThisT& u, const ThisT& v) { return v.value < u.value ? v : u; }
+
+	private:
+		using Seq = std::make_index_sequence<Lanes>;
+
+		/**
+		 * phi( u ) with phi( u.value ) = value, phi'( u.value ) = derivative
+		 */
+		static TPR_FORCEINLINE ThisT Chain(const ThisT& u, T value, T derivative) {
+			return ThisT(value, Scale(u.tangent, derivative, Seq()));
+		}
+
+		// lane arithmetic, expanded at compile time
+		template<size_t ... K>
+		static TPR_FORCEINLINE TangentT Add(const TangentT& a, const TangentT& b, std::index_sequence<K ...>) {
+			return { { (a[K] + b[K]) ... } };
+		}
+
+		template<size_t ... K>
+		static TPR_FORCEINLINE TangentT Subtract(const TangentT& a, const TangentT& b, std::index_sequence<K ...>) {
+			return { { (a[K] - b[K]) ... } };
+		}
+
+		template<size_t ... K>
+		static TPR_FORCEINLINE TangentT Negate(const TangentT& a, std::index_sequence<K ...>) {
+			return { { (-a[K]) ... } };
+		}
+
+		template<size_t ... K>
+		static TPR_FORCEINLINE TangentT Scale(const TangentT& a, T s, std::index_sequence<K ...>) {
+			return { { (a[K] * s) ... } };
+		}
+
+		/**
+		 * a * sa + b * sb
+		 */
+		template<size_t ... K>
+		static TPR_FORCEINLINE TangentT Combine(const TangentT& a, T sa, const TangentT& b, T sb, std::index_sequence<K ...>) {
+			return { { (a[K] * sa + b[K] * sb) ... } };
+		}
+	};
+
+	namespace detail {
+		template<size_t ... Indices>
+		IndexList<Indices ...> MakeIndexList(std::index_sequence<Indices ...>);
+
+		template<typename F, typename = void>
+		struct DefaultSparsity {
+			using type = decltype(MakeIndexList(std::make_index_sequence<F::N>()));
+		};
+
+		template<typename F>
+		struct DefaultSparsity<F, typename VoidT<typename F::Sparsity>::type> {
+			using type = typename F::Sparsity;
+		};
+	}// namespace detail
+
+	/**
+	 * @brief IndexList< 0, 1, ..., N - 1 >, every variable of a dense function.
+	 */
+	template<size_t N>
+	using DenseIndexList = decltype(detail::MakeIndexList(std::make_index_sequence<N>()));
+
+	/**
+	 * @brief read only view of x for a templated apply, args[i] is a Dual seeded for the variables of SparsityT:
+	 * lane k carries d/dx[ SparsityT::at(k) ], every other variable is a constant.
+	 * With an index known at compile time the seed is a constant too.
+	 * The other lanes are seeded with -0.0 rather than 0.0: y + (-0.0) == y for every y,
+	 * so the compiler may drop the sums with them, y + 0.0 is not exact for y = -0.0.
+	 */
+	template<typename VectorT, typename SparsityT>
+	class SeededVector;
+
+	template<typename VectorT, size_t ... Indices>
+	class SeededVector<VectorT, IndexList<Indices ...>> {
+	public: // == TYPES ==
+		using ValueType		= typename VectorT::value_type;
+		using value_type	= Dual<ValueType, sizeof...(Indices)>;
+
+	public: // == METHODS ==
+		explicit SeededVector(const VectorT& x) : mX(x) {}
+
+		TPR_FORCEINLINE value_type operator[](size_t idx) const {
+			return value_type(mX[idx], { { (Indices == idx ? ValueType(1) : -ValueType()) ... } });
+		}
+
+		size_t size() const {
+			return mX.size();
+		}
+
+	private:
+		const VectorT& mX;
+	};
+
+	/**
+	 * @brief gradient of F taken from its templated apply by forward mode AD.
+	 * One pass of F::apply on Dual<ValueType, SparsityT::Size> gives the value and the gradient,
+	 * so the cost grows with the variables gi depends on (F::Sparsity), not with N.
+	 * Dense functions without Sparsity get one lane per variable.
+	 *
+	 * static void evaluate_sparse(const VectorT& x, ValueType& value, SparseVectorT& grad) {
+	 *     AutoGradient<G1>::evaluate_sparse(x, value, grad);
+	 * }
+	 */
+	template<typename F, typename SparsityT = typename detail::DefaultSparsity<F>::type>
+	struct AutoGradient {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+		using SparseVectorT = std::array<ValueType, SparsityT::Size>;
+
+		/**
+		 * grad[k] = dF/dx[ SparsityT::at(k) ]
+		 */
+		static void evaluate_sparse(const VectorT& x, ValueType& value, SparseVectorT& grad) {
+			const auto rval = F::apply(SeededVector<VectorT, SparsityT>(x));
+			value = rval.value;
+			grad = rval.tangent;
+		}
+
+		static void evaluate(const VectorT& x, ValueType& value, VectorT& grad) {
+			SparseVectorT sparseGrad;
+			evaluate_sparse(x, value, sparseGrad);
+			grad.fill(ValueType());
+			SparsityT::scatter(ValueType(1), sparseGrad, grad);
+		}
+
+		static VectorT gradient(const VectorT& x) {
+			ValueType value;
+			VectorT grad;
+			evaluate(x, value, grad);
+			return grad;
+		}
+	};
+}// namespace tpr
@@ -0,0 +1,549 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <cassert>
+#include <algorithm>
+
+#include "GradientDescent.hpp"
+#include "LBFGSDescent.hpp"
+#include "ConjugateGradientDescent.hpp"
+#include "SpectralGradientDescent.hpp"
+#include "Evaluator.hpp"
+#include "Bounds.hpp"
+
+namespace tpr {
+	/**
+	 * @brief logarithmic barrier (interior point) algorithm
+	 * min(f(x))
+	 * with contraints
+	 * gi(x) <= 0
+	 * B(x, mu) = f(x) - mu * sum( log( -gi(x) ) ), +inf unless every gi(x) < 0
+	 * grad( B ) = grad( f(x) ) + mu * sum( grad( gi(x) ) / -gi(x) )
+	 * Finite bounds of x, see setBounds, add -mu * log( x[i] - lower[i] ) and -mu * log( upper[i] - x[i] ),
+	 * M counts them along with the gi below.
+	 *
+	 * phase 1, unless x0 is strictly feasible already, is the same loop on
+	 * min( s ) with gi(x) <= s, lower - x <= s, x - upper <= s, s >= -PhaseOneMargin
+	 * from s = max( gi(x0), lower - x0, x0 - upper ) + PhaseOneMargin, it stops at the first ( x, s ) with every gi(x) < 0
+	 * and x strictly inside the bounds. The interior is empty once s - ( M + 1 ) * mu > 0 or the gap closed with s >= 0.
+	 *
+	 * mu = DefaultMu * max( 1, | f(x0) | ) / M
+	 * while true
+	 * do
+	 *     x_opt = min( B(x, mu) ) from x_prev
+	 *
+	 *     if max | grad( B(x_opt, mu) ) | > CenterEpsilon * max( 1, max | grad( f(x_opt) ) | )
+	 *     then
+	 *        continue // same mu, from x_opt
+	 *     end
+	 *
+	 *     if M * mu <= Epsilon * max( 1, | f( x_opt ) | ) or the time limit is over
+	 *     then
+	 *        return x_opt
+	 *     end
+	 *
+	 *     mu = Shrink * mu
+	 * done
+	 *
+	 * M * mu bounds f( x_opt ) - min( f ) for convex f and gi only once x_opt is centered, hence the gradient test.
+	 * The descents never accept a point where B is +inf, so every x_opt, and the x a time-limited
+	 * solve returns, is strictly feasible, unlike the iterates of PenaltyFunction which approach the feasible set from outside.
+	 */
+	template<
+		typename FT, //minimizing function
+		typename IndexType,
+		typename ... GiFuncTypes
+	>
+	class BarrierFunction {
+	public: // == TYPES ==
+		using TargetF	= FT;
+		using ValueType = typename TargetF::ValueType;
+		using VectorT	= typename TargetF::VectorT;
+		using ThisT		= BarrierFunction<FT, IndexType, GiFuncTypes ...>;
+
+	public: // == CONSTANTS ==
+		static constexpr ValueType	Shrink				= 0.1;			//!< decrease factor of mu.
+		static constexpr ValueType	Epsilon				= 1e-6;			//!< relative duality gap M * mu to stop at
+		static constexpr ValueType	CenterEpsilon		= 1e-3;			//!< max | grad( B ) | relative to max | grad( f ) | at which x is centered
+		static constexpr ValueType	DefaultMu			= 1.0;			//!< first mu, relative to | f(x0) | / M
+		static constexpr ValueType	PhaseOneMargin		= 1.0;			//!< depth below zero phase 1 may push max( gi(x) ) to
+		static constexpr IndexType	N					= TargetF::N;	//!< sizeof Xopt vector
+		static constexpr IndexType	M					= sizeof...(GiFuncTypes);	//!< number of constraints
+		static constexpr IndexType	MaxPIterations		= 1'000;
+
+	public: // == TYPES ==
+		/**
+		 * term of the i-th constraint
+		 * -mu * log( -gi(x) ) in the barrier, -mu * log( s - gi(x) ) in phase 1
+		 */
+		template<size_t I, typename G, typename... GiTail>
+		struct BarrierTerm {
+			using Head = BarrierTerm< I, G >;
+			using Tail = BarrierTerm< I + 1, GiTail ... >;
+
+			static ValueType apply(ValueType mu, const VectorT& xArgs) {
+				return Head::apply(mu, xArgs) + Tail::apply(mu, xArgs);
+			}
+
+			static void accumulate(ValueType mu, const VectorT& xArgs, ValueType& value, VectorT& grad) {
+				Head::accumulate(mu, xArgs, value, grad);
+				Tail::accumulate(mu, xArgs, value, grad);
+			}
+
+			static ValueType slack(ValueType mu, ValueType s, const VectorT& xArgs) {
+				return Head::slack(mu, s, xArgs) + Tail::slack(mu, s, xArgs);
+			}
+
+			static void accumulate_slack(ValueType mu, ValueType s, const VectorT& xArgs, ValueType& value, VectorT& grad, ValueType& sGrad) {
+				Head::accumulate_slack(mu, s, xArgs, value, grad, sGrad);
+				Tail::accumulate_slack(mu, s, xArgs, value, grad, sGrad);
+			}
+		};
+
+		// end of recursion.
+		template<size_t I, typename G>
+		struct BarrierTerm<I, G> {
+			static ValueType apply(ValueType mu, const VectorT& xArgs) {
+				ValueType g = G::apply(xArgs);
+				return g < 0 ? -mu * std::log(-g) : std::numeric_limits<ValueType>::infinity();
+			}
+
+			static void accumulate(ValueType mu, const VectorT& xArgs, ValueType& value, VectorT& grad) {
+				using GiEvaluator = SparseEvaluator<G>;
+				ValueType g;
+				typename GiEvaluator::GradientT gGrad;
+				GiEvaluator::evaluate(xArgs, g, gGrad);
+
+				// outside the domain, the descent backs off and the gradient is never used
+				if (!(g < 0)) {
+					value = std::numeric_limits<ValueType>::infinity();
+					return;
+				}
+
+				value -= mu * std::log(-g);
+				GiEvaluator::scatter(mu / -g, gGrad, grad);
+			}
+
+			static ValueType slack(ValueType mu, ValueType s, const VectorT& xArgs) {
+				ValueType room = s - G::apply(xArgs);
+				return room > 0 ? -mu * std::log(room) : std::numeric_limits<ValueType>::infinity();
+			}
+
+			static void accumulate_slack(ValueType mu, ValueType s, const VectorT& xArgs, ValueType& value, VectorT& grad, ValueType& sGrad) {
+				using GiEvaluator = SparseEvaluator<G>;
+				ValueType g;
+				typename GiEvaluator::GradientT gGrad;
+				GiEvaluator::evaluate(xArgs, g, gGrad);
+				ValueType room = s - g;
+
+				if (!(room > 0)) {
+					value = std::numeric_limits<ValueType>::infinity();
+					return;
+				}
+
+				value -= mu * std::log(room);
+				GiEvaluator::scatter(mu / room, gGrad, grad);
+				sGrad -= mu / room;
+			}
+		};
+
+		using Terms = BarrierTerm<0, GiFuncTypes ...>;
+
+		/**
+		 * terms of the finite bounds of x, nothing for bounds == nullptr
+		 * -mu * log( x[i] - lower[i] + s ) - mu * log( upper[i] - x[i] + s ),
+		 * s = 0 in the barrier, the slack of the rows lower - x <= s, x - upper <= s in phase 1.
+		 */
+		struct BoundTerm {
+			static ValueType apply(const Box<ValueType>* bounds, ValueType mu, ValueType s, const VectorT& xArgs) {
+				ValueType rval = 0.0;
+
+				for (size_t idx = 0; bounds && idx < bounds->size(); idx++) {
+					const ValueType rooms[] = { xArgs[idx] - bounds->lower(idx) + s, bounds->upper(idx) - xArgs[idx] + s };
+
+					for (ValueType room : rooms) {
+						if (std::isinf(room))
+							continue;
+
+						if (!(room > 0))
+							return std::numeric_limits<ValueType>::infinity();
+
+						rval -= mu * std::log(room);
+					}
+				}
+
+				return rval;
+			}
+
+			/**
+			 * value, grad and, in phase 1, d/ds of the terms, value = +inf outside the box
+			 */
+			static void accumulate(const Box<ValueType>* bounds, ValueType mu, ValueType s, const VectorT& xArgs,
+				ValueType& value, VectorT& grad, ValueType& sGrad
+			) {
+				for (size_t idx = 0; bounds && idx < bounds->size(); idx++) {
+					const ValueType rooms[] = { xArgs[idx] - bounds->lower(idx) + s, bounds->upper(idx) - xArgs[idx] + s };
+					const ValueType signs[] = { -1.0, 1.0 };	// d( room ) / dx[i] = 1, -1
+
+					for (size_t side = 0; side < 2; side++) {
+						if (std::isinf(rooms[side]))
+							continue;
+
+						if (!(rooms[side] > 0)) {
+							value = std::numeric_limits<ValueType>::infinity();
+							return;
+						}
+
+						value -= mu * std::log(rooms[side]);
+						grad[idx] += signs[side] * mu / rooms[side];
+						sGrad -= mu / rooms[side];
+					}
+				}
+			}
+
+			/**
+			 * number of finite bounds
+			 */
+			static IndexType count(const Box<ValueType>& bounds) {
+				IndexType rval = 0;
+
+				for (size_t idx = 0; idx < bounds.size(); idx++)
+					rval += (std::isinf(bounds.lower(idx)) ? 0 : 1) + (std::isinf(bounds.upper(idx)) ? 0 : 1);
+
+				return rval;
+			}
+
+			/**
+			 * max( lower - x, x - upper ), -inf without finite bounds
+			 */
+			static ValueType violation(const Box<ValueType>& bounds, const VectorT& xArgs) {
+				ValueType rval = -std::numeric_limits<ValueType>::infinity();
+
+				for (size_t idx = 0; idx < bounds.size(); idx++)
+					rval = std::max(rval, std::max(bounds.lower(idx) - xArgs[idx], xArgs[idx] - bounds.upper(idx)));
+
+				return rval;
+			}
+		};
+
+		/**
+		 * B(x, mu) for fixed mu, held by reference, the solver shrinks it between inner solves, as are the bounds of x.
+		 * The bounds enter as barrier terms, not as box(): a projecting descent would put x onto them, where B is +inf.
+		 */
+		struct BarrierObjective {
+			using ValueType = typename ThisT::ValueType;
+			using VectorT	= typename ThisT::VectorT;
+			static constexpr int N = ThisT::N;
+
+			const ValueType&		mu;
+			const Box<ValueType>*	bounds = nullptr;
+
+			explicit BarrierObjective(const ValueType& muRef) : mu(muRef) {}
+
+			BarrierObjective(const ValueType& muRef, const Box<ValueType>& boundsRef) : mu(muRef), bounds(&boundsRef) {}
+
+			ValueType apply(const VectorT& xArgs) const {
+				return TargetF::apply(xArgs) + Terms::apply(mu, xArgs) + BoundTerm::apply(bounds, mu, 0.0, xArgs);
+			}
+
+			void evaluate(const VectorT& xArgs, ValueType& value, VectorT& grad) const {
+				ValueType sGrad = 0.0;
+				Evaluator<TargetF>::evaluate(xArgs, value, grad);
+				Terms::accumulate(mu, xArgs, value, grad);
+				BoundTerm::accumulate(bounds, mu, 0.0, xArgs, value, grad, sGrad);
+			}
+
+			VectorT gradient(const VectorT& xArgs) const {
+				ValueType value;
+				VectorT rval;
+				evaluate(xArgs, value, rval);
+				return rval;
+			}
+		};
+
+		/**
+		 * phase 1 barrier s - mu * ( log( s + PhaseOneMargin ) + sum( log( s - gi(x) ) ) ) over ( x, s ), s is the last entry,
+		 * plus the bound terms with s added to their rooms.
+		 * The floor on s keeps it bounded below when the interior is unbounded.
+		 */
+		struct PhaseOneObjective {
+			using ValueType = typename ThisT::ValueType;
+			using VectorT	= std::array<ValueType, ThisT::N + 1>;
+			static constexpr int N = ThisT::N + 1;
+
+			const ValueType&		mu;
+			const Box<ValueType>*	bounds = nullptr;
+
+			explicit PhaseOneObjective(const ValueType& muRef) : mu(muRef) {}
+
+			PhaseOneObjective(const ValueType& muRef, const Box<ValueType>& boundsRef) : mu(muRef), bounds(&boundsRef) {}
+
+			ValueType apply(const VectorT& xsArgs) const {
+				ValueType s = xsArgs[ThisT::N];
+
+				if (!(s + PhaseOneMargin > 0))
+					return std::numeric_limits<ValueType>::infinity();
+
+				const typename ThisT::VectorT xArgs = point(xsArgs);
+				return s - mu * std::log(s + PhaseOneMargin) + Terms::slack(mu, s, xArgs) + BoundTerm::apply(bounds, mu, s, xArgs);
+			}
+
+			void evaluate(const VectorT& xsArgs, ValueType& value, VectorT& grad) const {
+				ValueType s = xsArgs[ThisT::N];
+				grad.fill(ValueType());
+
+				if (!(s + PhaseOneMargin > 0)) {
+					value = std::numeric_limits<ValueType>::infinity();
+					return;
+				}
+
+				typename ThisT::VectorT xGrad;
+				xGrad.fill(ValueType());
+				ValueType sGrad = 1 - mu / (s + PhaseOneMargin);
+				value = s - mu * std::log(s + PhaseOneMargin);
+				const typename ThisT::VectorT xArgs = point(xsArgs);
+				Terms::accumulate_slack(mu, s, xArgs, value, xGrad, sGrad);
+				BoundTerm::accumulate(bounds, mu, s, xArgs, value, xGrad, sGrad);
+				std::copy(xGrad.begin(), xGrad.end(), grad.begin());
+				grad[ThisT::N] = sGrad;
+			}
+
+			/**
+			 * x of ( x, s )
+			 */
+			static typename ThisT::VectorT point(const VectorT& xsArgs) {
+				typename ThisT::VectorT rval;
+				std::copy(xsArgs.begin(), xsArgs.begin() + ThisT::N, rval.begin());
+				return rval;
+			}
+
+			VectorT gradient(const VectorT& xArgs) const {
+				ValueType value;
+				VectorT rval;
+				evaluate(xArgs, value, rval);
+				return rval;
+			}
+		};
+
+	private: // == MEMBERS ==
+		Box<ValueType>	mBounds;						//!< bounds of x, kept by barrier terms
+		ValueType	mMu					= ValueType();	//!< mu
+		ValueType	mLambda				= ValueType();	//!< step of the last inner solve
+		double		mTimeLimit			= 0.0;			//!< seconds, 0 - none
+		IndexType	mOuterIterations	= 0;			//!< inner solves done, phase 1 included
+		IndexType	mInnerIterations	= 0;			//!< descent iterations over all inner solves
+		bool		mFeasible			= false;		//!< phase 1 found a strictly feasible x
+		bool		mCentered			= false;		//!< the last inner solve met CenterEpsilon
+
+	public: // == METHODS ==
+		/**
+		 * max( 0, max( gi(x) ) ), zero for a feasible x
+		 */
+		static ValueType infeasibility(const VectorT& xArgs) {
+			ValueType values[] = { ValueType(), GiFuncTypes::apply(xArgs) ... };
+			return *std::max_element(std::begin(values), std::end(values));
+		}
+
+		/**
+		 * solves with a solver object of its own, see solve.
+		 */
+		template<template<typename, typename> class GradientDescentT = LBFGS<8>::Descent>
+		static VectorT evaluate(const VectorT& x0) {
+			ThisT solver;
+			return solver.template solve<GradientDescentT>(x0);
+		}
+
+		/**
+		 * lower < x < upper, kept strictly inside by -mu * log terms of the finite sides, see BarrierFunction.
+		 * Without them subj_17 has no minimum: f is bounded below on its feasible set only by x >= 0.
+		 * solver.setBounds( Box<double>::nonnegative( N ) );
+		 * @param bounds	N entries or empty to drop them
+		 */
+		void setBounds(const Box<ValueType>& bounds) {
+			assert(bounds.empty() || bounds.size() == N);
+			mBounds = bounds;
+		}
+
+		const Box<ValueType>& bounds() const {
+			return mBounds;
+		}
+
+		/**
+		 * The state of a solve lives in this object, so separate objects may solve concurrently.
+		 * @tparam GradientDescentT	minimizer of B(x, mu) and of the phase 1 objective, see PenaltyFunction::solve.
+		 *		B is +inf outside the feasible set, the descent has to reject such steps as any step without decrease,
+		 *		and mu only shrinks once it stops on a small gradient: LBFGS<Depth>::Descent, PolakRibiereDescent, BarzilaiBorweinDescent ...
+		 *		StepSplitGradientDescent stops on | f( x[k+1] ) - f( x[k] ) | < Epsilon far from the center and does not get there.
+		 * @return the last centered x, strictly feasible unless phase 1 failed, see feasible(),
+		 *		then the x with the least max( gi(x) ) phase 1 found
+		 */
+		template<template<typename, typename> class GradientDescentT = LBFGS<8>::Descent>
+		VectorT solve(const VectorT& x0) {
+			auto started = std::chrono::steady_clock::now();
+			mOuterIterations = 0;
+			mInnerIterations = 0;
+			VectorT xArgs = x0;
+			mFeasible = PhaseOne<GradientDescentT>(xArgs);
+
+			// no interior to move in, the least infeasible x is all there is
+			if (!mFeasible)
+				return xArgs;
+
+			const IndexType terms = M + BoundTerm::count(mBounds);
+			mMu = DefaultMu * std::max(ValueType(1.0), std::fabs(TargetF::apply(xArgs))) / terms;
+			const BarrierObjective barrier(mMu, mBounds);
+			using GradientDescent = GradientDescentT<BarrierObjective, IndexType>;
+			IndexType idx = 0;
+
+			for (; idx < MaxPIterations; idx++) {
+				IndexType it = 0;
+
+				// find min( B(x, mu) )
+				mLambda = GradientDescent::Lambda;
+				xArgs = GradientDescent::calculate(barrier, xArgs, mLambda, it);
+				mOuterIterations++;
+				mInnerIterations += it;
+				mCentered = Centered(barrier, xArgs, GradientScale(xArgs));
+
+				// every x_opt is feasible, the latest one is the best plan so far
+				if (mTimeLimit > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count() >= mTimeLimit)
+					return xArgs;
+
+				// off center M * mu bounds nothing, go on with the same mu
+				if (!mCentered)
+					continue;
+
+				if (terms * mMu <= Epsilon * std::max(ValueType(1.0), std::fabs(TargetF::apply(xArgs))))
+					return xArgs;
+
+				// mu[k+1] = mu[k] * Shrink
+				mMu *= ThisT::Shrink;
+			}
+
+			if (idx >= MaxPIterations) {
+				assert(0 && "Failure");
+			}
+
+			return xArgs;
+		}
+
+		/**
+		 * wall time after which solve returns its current x, checked between inner solves,
+		 * so a solve ends within one inner solve past it. Phase 1 runs to completion regardless.
+		 * @param seconds	0 - no limit
+		 */
+		void setTimeLimit(double seconds) {
+			mTimeLimit = seconds;
+		}
+
+		ValueType coefficient() const {
+			return mMu;
+		}
+
+		ValueType lambda() const {
+			return mLambda;
+		}
+
+		bool feasible() const {
+			return mFeasible;
+		}
+
+		/**
+		 * the last inner solve stopped at a small max | grad( B ) |, false when the time limit cut the solve short off center
+		 */
+		bool centered() const {
+			return mCentered;
+		}
+
+		IndexType outerIterations() const {
+			return mOuterIterations;
+		}
+
+		IndexType innerIterations() const {
+			return mInnerIterations;
+		}
+
+	private:
+		/**
+		 * moves xArgs strictly inside, returns false when the interior is empty, see BarrierFunction
+		 */
+		template<template<typename, typename> class GradientDescentT>
+		bool PhaseOne(VectorT& xArgs) {
+			mCentered = true;
+
+			if (Strict(xArgs))
+				return true;
+
+			typename PhaseOneObjective::VectorT xsArgs;
+			std::copy(xArgs.begin(), xArgs.end(), xsArgs.begin());
+			ValueType values[] = { BoundTerm::violation(mBounds, xArgs), GiFuncTypes::apply(xArgs) ... };
+			ValueType& s = xsArgs[N];
+			s = *std::max_element(std::begin(values), std::end(values)) + PhaseOneMargin;
+			const IndexType terms = M + BoundTerm::count(mBounds) + 1;
+			mMu = DefaultMu * std::max(ValueType(1.0), s) / terms;
+			const PhaseOneObjective slack(mMu, mBounds);
+			using GradientDescent = GradientDescentT<PhaseOneObjective, IndexType>;
+			IndexType idx = 0;
+
+			for (; idx < MaxPIterations; idx++) {
+				IndexType it = 0;
+				mLambda = GradientDescent::Lambda;
+				xsArgs = GradientDescent::calculate(slack, xsArgs, mLambda, it);
+				mOuterIterations++;
+				mInnerIterations += it;
+				xArgs = PhaseOneObjective::point(xsArgs);
+
+				if (Strict(xArgs))
+					return true;
+
+				if (!Centered(slack, xsArgs, 1.0))
+					continue;
+
+				// min( s ) >= s - ( M + 1 ) * mu > 0, or no room left between them
+				if (s - terms * mMu > 0 || terms * mMu <= Epsilon * std::max(ValueType(1.0), std::fabs(s)))
+					return false;
+
+				mMu *= ThisT::Shrink;
+			}
+
+			assert(0 && "Failure");
+			return false;
+		}
+
+		/**
+		 * max | grad( B ) | <= CenterEpsilon * scale
+		 */
+		template<typename F>
+		static bool Centered(const F& barrier, const typename F::VectorT& xArgs, ValueType scale) {
+			ValueType value;
+			typename F::VectorT grad;
+			barrier.evaluate(xArgs, value, grad);
+			return Projection<F>::stationarity(barrier, xArgs, grad) <= CenterEpsilon * scale;
+		}
+
+		/**
+		 * max( 1, max | grad( f(x) ) | ), grad( B ) is compared with it, phase 1 uses 1 = max | grad( s ) |
+		 */
+		static ValueType GradientScale(const VectorT& xArgs) {
+			ValueType value;
+			VectorT grad;
+			Evaluator<TargetF>::evaluate(xArgs, value, grad);
+			ValueType rval = 1.0;
+
+			for (size_t idx = 0; idx < grad.size(); idx++)
+				rval = std::max(rval, std::fabs(grad[idx]));
+
+			return rval;
+		}
+
+		/**
+		 * every gi(x) < 0 and lower < x < upper
+		 */
+		bool Strict(const VectorT& xArgs) const {
+			ValueType values[] = { BoundTerm::violation(mBounds, xArgs), GiFuncTypes::apply(xArgs) ... };
+			return *std::max_element(std::begin(values), std::end(values)) < 0;
+		}
+	};
+}// namespace tpr
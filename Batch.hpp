@@ -0,0 +1,286 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+#if defined(__AVX512F__) || defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+#include "AutoDiff.hpp"
+
+namespace tpr {
+	/**
+	 * doubles per vector register of the compile target: 8 for AVX-512, 4 for AVX / AVX2, 2 for SSE2, 1 otherwise.
+	 * A Batch wider than that runs lane by lane and loses to apply, so BatchEvaluator takes it as its default K.
+	 */
+#if defined(__AVX512F__)
+	constexpr size_t NativeLanes = 8;
+#elif defined(__AVX__)
+	constexpr size_t NativeLanes = 4;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	constexpr size_t NativeLanes = 2;
+#else
+	constexpr size_t NativeLanes = 1;
+#endif
+
+	template<typename T, size_t K, typename = void>
+	struct BatchMath;
+
+	/**
+	 * @brief K independent points of one scalar, one lane per point.
+	 * A model with a templated apply
+	 *
+	 * template<typename VecT>
+	 * static auto apply(const VecT& args) {
+	 *     return 300 - args[x111] - args[x121] - args[x131];
+	 * }
+	 *
+	 * runs on BatchVector< N, K > for K points at once, see BatchEvaluator.
+	 * Operations are expanded over the lanes at compile time, so the compiler keeps a Batch in one vector register:
+	 * K = 2 for SSE2, 4 for AVX / AVX2, 8 for AVX-512 doubles. sqrt and max go through BatchMath,
+	 * compilers do not vectorize them from lanes: std::sqrt may set errno, the selects of max stay branches.
+	 */
+	template<typename T, size_t K>
+	struct Batch {
+	public: // == TYPES ==
+		using ValueType = T;
+		using LanesT	= std::array<T, K>;
+		using ThisT		= Batch<T, K>;
+
+	public: // == CONSTANTS ==
+		static constexpr size_t Lanes = K;
+
+		static_assert((K & (K - 1)) == 0, "lanes are a power of 2, a Batch is one vector");
+
+	public: // == MEMBERS ==
+		LanesT lane;	//!< lane[k] belongs to point k, no alignas: C++14 new does not align beyond max_align_t
+
+	public: // == METHODS ==
+		Batch() : lane() {}
+
+		/**
+		 * the same value in every lane
+		 */
+		explicit Batch(T v) : lane(Broadcast(v, Seq())) {}
+
+		Batch(const LanesT& l) : lane(l) {}
+
+		TPR_FORCEINLINE ThisT& operator+=(const ThisT& rhs) { return *this = *this + rhs; }
+		TPR_FORCEINLINE ThisT& operator-=(const ThisT& rhs) { return *this = *this - rhs; }
+		TPR_FORCEINLINE ThisT& operator*=(const ThisT& rhs) { return *this = *this * rhs; }
+		TPR_FORCEINLINE ThisT& operator/=(const ThisT& rhs) { return *this = *this / rhs; }
+		TPR_FORCEINLINE ThisT& operator+=(T rhs) { return *this = *this + rhs; }
+		TPR_FORCEINLINE ThisT& operator-=(T rhs) { return *this = *this - rhs; }
+		TPR_FORCEINLINE ThisT& operator*=(T rhs) { return *this = *this * rhs; }
+		TPR_FORCEINLINE ThisT& operator/=(T rhs) { return *this = *this / rhs; }
+
+		friend TPR_FORCEINLINE ThisT operator-(const ThisT& u) { return Map(u, [](T a) { return -a; }, Seq()); }
+
+		friend TPR_FORCEINLINE ThisT operator+(const ThisT& u, const ThisT& v) { return Zip(u, v, [](T a, T b) { return a + b; }, Seq()); }
+		friend TPR_FORCEINLINE ThisT operator-(const ThisT& u, const ThisT& v) { return Zip(u, v, [](T a, T b) { return a - b; }, Seq()); }
+		friend TPR_FORCEINLINE ThisT operator*(const ThisT& u, const ThisT& v) { return Zip(u, v, [](T a, T b) { return a * b; }, Seq()); }
+		friend TPR_FORCEINLINE ThisT operator/(const ThisT& u, const ThisT& v) { return Zip(u, v, [](T a, T b) { return a / b; }, Seq()); }
+
+		friend TPR_FORCEINLINE ThisT operator+(const ThisT& u, T v) { return u + ThisT(v); }
+		friend TPR_FORCEINLINE ThisT operator+(T u, const ThisT& v) { return ThisT(u) + v; }
+		friend TPR_FORCEINLINE ThisT operator-(const ThisT& u, T v) { return u - ThisT(v); }
+		friend TPR_FORCEINLINE ThisT operator-(T u, const ThisT& v) { return ThisT(u) - v; }
+		friend TPR_FORCEINLINE ThisT operator*(const ThisT& u, T v) { return u * ThisT(v); }
+		friend TPR_FORCEINLINE ThisT operator*(T u, const ThisT& v) { return ThisT(u) * v; }
+		friend TPR_FORCEINLINE ThisT operator/(const ThisT& u, T v) { return u / ThisT(v); }
+		friend TPR_FORCEINLINE ThisT operator/(T u, const ThisT& v) { return ThisT(u) / v; }
+
+		/**
+		 * lane-wise, max( 0, gi(x) ) of R1 selects per point
+		 */
+		friend TPR_FORCEINLINE ThisT max(const ThisT& u, const ThisT& v) { return BatchMath<T, K>::max(u, v); }
+		friend TPR_FORCEINLINE ThisT max(const ThisT& u, T v) { return max(u, ThisT(v)); }
+		friend TPR_FORCEINLINE ThisT max(T u, const ThisT& v) { return max(ThisT(u), v); }
+		friend TPR_FORCEINLINE ThisT min(const ThisT& u, const ThisT& v) { return Zip(u, v, [](T a, T b) { return b < a ? b : a; }, Seq()); }
+		friend TPR_FORCEINLINE ThisT fabs(const ThisT& u) { return Map(u, [](T a) { return a < T() ? -a : a; }, Seq()); }
+
+		friend TPR_FORCEINLINE ThisT sqr(const ThisT& u) { return u * u; }
+
+		friend TPR_FORCEINLINE ThisT sqrt(const ThisT& u) {
+			return BatchMath<T, K>::sqrt(u);
+		}
+
+		friend TPR_FORCEINLINE ThisT pow(const ThisT& u, T p) {
+			using std::pow;
+			return Map(u, [p](T a) { return pow(a, p); }, Seq());
+		}
+
+	private:
+		using Seq = std::make_index_sequence<K>;
+
+		// lane arithmetic, expanded at compile time
+		template<size_t ... I>
+		static TPR_FORCEINLINE LanesT Broadcast(T v, std::index_sequence<I ...>) {
+			return { { ((void)I, v) ... } };
+		}
+
+		template<typename Op, size_t ... I>
+		static TPR_FORCEINLINE ThisT Map(const ThisT& u, Op op, std::index_sequence<I ...>) {
+			return ThisT(LanesT{ { op(u.lane[I]) ... } });
+		}
+
+		template<typename Op, size_t ... I>
+		static TPR_FORCEINLINE ThisT Zip(const ThisT& u, const ThisT& v, Op op, std::index_sequence<I ...>) {
+			return ThisT(LanesT{ { op(u.lane[I], v.lane[I]) ... } });
+		}
+	};
+
+	/**
+	 * @brief lane-wise sqrt and max, one instruction where the target has a vector of K lanes of T.
+	 * max( u, v ) is u[k] < v[k] ? v[k] : u[k], as MAXPD( v, u ).
+	 */
+	template<typename T, size_t K, typename>
+	struct BatchMath {
+		static TPR_FORCEINLINE Batch<T, K> sqrt(const Batch<T, K>& u) {
+			using std::sqrt;
+			Batch<T, K> rval;
+
+			for (size_t k = 0; k < K; k++)
+				rval.lane[k] = sqrt(u.lane[k]);
+
+			return rval;
+		}
+
+		static TPR_FORCEINLINE Batch<T, K> max(const Batch<T, K>& u, const Batch<T, K>& v) {
+			Batch<T, K> rval;
+
+			for (size_t k = 0; k < K; k++)
+				rval.lane[k] = u.lane[k] < v.lane[k] ? v.lane[k] : u.lane[k];
+
+			return rval;
+		}
+	};
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	template<typename V>
+	struct BatchMath<double, 2, V> {
+		static TPR_FORCEINLINE Batch<double, 2> sqrt(const Batch<double, 2>& u) {
+			Batch<double, 2> rval;
+			_mm_storeu_pd(rval.lane.data(), _mm_sqrt_pd(_mm_loadu_pd(u.lane.data())));
+			return rval;
+		}
+
+		static TPR_FORCEINLINE Batch<double, 2> max(const Batch<double, 2>& u, const Batch<double, 2>& v) {
+			Batch<double, 2> rval;
+			_mm_storeu_pd(rval.lane.data(), _mm_max_pd(_mm_loadu_pd(v.lane.data()), _mm_loadu_pd(u.lane.data())));
+			return rval;
+		}
+	};
+#endif
+
+#if defined(__AVX__)
+	template<typename V>
+	struct BatchMath<double, 4, V> {
+		static TPR_FORCEINLINE Batch<double, 4> sqrt(const Batch<double, 4>& u) {
+			Batch<double, 4> rval;
+			_mm256_storeu_pd(rval.lane.data(), _mm256_sqrt_pd(_mm256_loadu_pd(u.lane.data())));
+			return rval;
+		}
+
+		static TPR_FORCEINLINE Batch<double, 4> max(const Batch<double, 4>& u, const Batch<double, 4>& v) {
+			Batch<double, 4> rval;
+			_mm256_storeu_pd(rval.lane.data(), _mm256_max_pd(_mm256_loadu_pd(v.lane.data()), _mm256_loadu_pd(u.lane.data())));
+			return rval;
+		}
+	};
+#endif
+
+#if defined(__AVX512F__)
+	template<typename V>
+	struct BatchMath<double, 8, V> {
+		static TPR_FORCEINLINE Batch<double, 8> sqrt(const Batch<double, 8>& u) {
+			Batch<double, 8> rval;
+			_mm512_storeu_pd(rval.lane.data(), _mm512_sqrt_pd(_mm512_loadu_pd(u.lane.data())));
+			return rval;
+		}
+
+		static TPR_FORCEINLINE Batch<double, 8> max(const Batch<double, 8>& u, const Batch<double, 8>& v) {
+			Batch<double, 8> rval;
+			_mm512_storeu_pd(rval.lane.data(), _mm512_max_pd(_mm512_loadu_pd(v.lane.data()), _mm512_loadu_pd(u.lane.data())));
+			return rval;
+		}
+	};
+#endif
+
+	/**
+	 * @brief structure of arrays block of K points of N variables:
+	 * x[i].lane[k] is variable i of point k, so args[i] of a templated apply is a Batch.
+	 */
+	template<size_t N, typename T, size_t K>
+	using BatchVector = std::array<Batch<T, K>, N>;
+
+	/**
+	 * @brief F(x) over many points, K at a time through F::apply_batch when F has one,
+	 * one point at a time through F::apply otherwise.
+	 *
+	 * std::vector<VectorT> points = ...;
+	 * std::vector<ValueType> values;
+	 * BatchEvaluator<PF::FxRk>::apply(fxRk, points, values);
+	 */
+	template<typename F, size_t K = NativeLanes>
+	struct BatchEvaluator {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+		using BatchT	= Batch<ValueType, K>;
+		using BlockT	= BatchVector<std::tuple_size<VectorT>::value, ValueType, K>;
+
+		static void apply(const F& f, const std::vector<VectorT>& points, std::vector<ValueType>& values) {
+			values.resize(points.size());
+			Apply(f, points, values, 0);
+		}
+
+		/**
+		 * x[i].lane[k] = points[first + k][i], a tail block repeats the last point
+		 */
+		static void pack(const std::vector<VectorT>& points, size_t first, BlockT& x) {
+			const ValueType* point[K];
+
+			for (size_t k = 0; k < K; k++)
+				point[k] = points[std::min(first + k, points.size() - 1)].data();
+
+			Pack(point, x, std::make_index_sequence<K>());
+		}
+
+	private:
+		/**
+		 * each Batch is built in a register and stored whole,
+		 * lane by lane stores would stall the vector loads of apply_batch that read them back
+		 */
+		template<size_t ... L>
+		static void Pack(const ValueType* const (&point)[K], BlockT& x, std::index_sequence<L ...>) {
+			for (size_t idx = 0; idx < x.size(); idx++)
+				x[idx] = BatchT(typename BatchT::LanesT{ { point[L][idx] ... } });
+		}
+
+		template<typename FT>
+		static auto Apply(const FT& f, const std::vector<VectorT>& points, std::vector<ValueType>& values, int)
+			-> decltype(f.apply_batch(std::declval<const BlockT&>()), void())
+		{
+			BlockT x;
+
+			for (size_t first = 0; first < points.size(); first += K) {
+				pack(points, first, x);
+				BatchT rval = f.apply_batch(x);
+
+				for (size_t k = 0; k < K && first + k < points.size(); k++)
+					values[first + k] = rval.lane[k];
+			}
+		}
+
+		template<typename FT>
+		static void Apply(const FT& f, const std::vector<VectorT>& points, std::vector<ValueType>& values, long) {
+			for (size_t idx = 0; idx < points.size(); idx++)
+				values[idx] = f.apply(points[idx]);
+		}
+	};
+}// namespace tpr
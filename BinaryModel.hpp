@@ -0,0 +1,469 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "CsrModel.hpp"
+
+namespace tpr {
+	/**
+	 * @brief first bytes of a binary model file.
+	 * The counts fix the size of every array, BinaryModelLayout places them after the header.
+	 */
+	struct BinaryModelHeader {
+		static constexpr std::uint32_t	Version		= 1;
+		static constexpr std::uint32_t	ByteOrder	= 0x01020304;	//!< reads differently on a machine of the other endianness
+
+		char			magic[8];		//!< "TPRMODEL"
+		std::uint32_t	version;
+		std::uint32_t	byteOrder;
+		std::uint64_t	fileSize;
+		std::uint64_t	variables;
+		std::uint64_t	linearRows;
+		std::uint64_t	linearNonzeros;
+		std::uint64_t	chanceRows;
+		std::uint64_t	chanceNonzeros;
+		std::uint64_t	nameBytes;		//!< characters of all names, no terminators
+
+		static const char* Magic() {
+			return "TPRMODEL";
+		}
+	};
+
+	/**
+	 * @brief offsets of the arrays of a binary model file.
+	 * Arrays follow in the order apply / evaluate scan them, each starts on a cache line,
+	 * entries are native doubles and the fixed width CsrOffset / CsrColumn, so a mapping is used in place.
+	 */
+	struct BinaryModelLayout {
+		enum Section {
+			Objective,
+			LinearStart,
+			LinearColumns,
+			LinearValues,
+			Bounds,
+			ChanceStart,
+			ChanceColumns,
+			ChanceValues,
+			Variances,
+			Quantiles,
+			Resources,
+			NameStart,
+			NameChars,
+			SectionCount
+		};
+
+		static constexpr std::uint64_t	Alignment = 64;
+
+		std::uint64_t	offset[SectionCount + 1];	//!< offset[SectionCount] is the size of the file
+
+		explicit BinaryModelLayout(const BinaryModelHeader& header) {
+			const std::uint64_t bytes[SectionCount] = {
+				header.variables * sizeof(double),
+				(header.linearRows + 1) * sizeof(CsrOffset),
+				header.linearNonzeros * sizeof(CsrColumn),
+				header.linearNonzeros * sizeof(double),
+				header.linearRows * sizeof(double),
+				(header.chanceRows + 1) * sizeof(CsrOffset),
+				header.chanceNonzeros * sizeof(CsrColumn),
+				header.chanceNonzeros * sizeof(double),
+				header.chanceNonzeros * sizeof(double),
+				header.chanceRows * sizeof(double),
+				header.chanceRows * sizeof(double),
+				(header.variables + 1) * sizeof(std::uint64_t),
+				header.nameBytes
+			};
+
+			std::uint64_t pos = sizeof(BinaryModelHeader);
+
+			for (size_t idx = 0; idx < SectionCount; idx++) {
+				pos = (pos + Alignment - 1) / Alignment * Alignment;
+				offset[idx] = pos;
+				pos += bytes[idx];
+			}
+
+			offset[SectionCount] = pos;
+		}
+	};
+
+	/**
+	 * @brief writes a CsrModel as a binary model file, see MappedModel.
+	 */
+	class BinaryModelWriter {
+	public: // == METHODS ==
+		/**
+		 * @param error	reason when the file is not written
+		 */
+		static bool write(const CsrModel& model, const std::string& path, std::string& error) {
+			if (model.size() > CsrColumn(-1)) {
+				error = "too many variables for CsrColumn";
+				return false;
+			}
+
+			BinaryModelHeader header;
+			std::memcpy(header.magic, BinaryModelHeader::Magic(), sizeof(header.magic));
+			header.version			= BinaryModelHeader::Version;
+			header.byteOrder		= BinaryModelHeader::ByteOrder;
+			header.variables		= model.size();
+			header.linearRows		= model.linear.rows();
+			header.linearNonzeros	= model.linear.nonzeros();
+			header.chanceRows		= model.chance.rows();
+			header.chanceNonzeros	= model.chance.nonzeros();
+			header.nameBytes		= 0;
+
+			std::vector<std::uint64_t> nameStart = { 0 };
+
+			for (const std::string& name : model.names) {
+				header.nameBytes += name.size();
+				nameStart.push_back(header.nameBytes);
+			}
+
+			BinaryModelLayout layout(header);
+			header.fileSize = layout.offset[BinaryModelLayout::SectionCount];
+
+			std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+
+			if (!out) {
+				error = "cannot open " + path;
+				return false;
+			}
+
+			Put(out, 0, &header, sizeof(header));
+			PutArray(out, layout.offset[BinaryModelLayout::Objective], model.objective);
+			PutArray(out, layout.offset[BinaryModelLayout::LinearStart], model.linear.rowStart);
+			PutArray(out, layout.offset[BinaryModelLayout::LinearColumns], model.linear.columns);
+			PutArray(out, layout.offset[BinaryModelLayout::LinearValues], model.linear.values);
+			PutArray(out, layout.offset[BinaryModelLayout::Bounds], model.bounds);
+			PutArray(out, layout.offset[BinaryModelLayout::ChanceStart], model.chance.rowStart);
+			PutArray(out, layout.offset[BinaryModelLayout::ChanceColumns], model.chance.columns);
+			PutArray(out, layout.offset[BinaryModelLayout::ChanceValues], model.chance.values);
+			PutArray(out, layout.offset[BinaryModelLayout::Variances], model.variances);
+			PutArray(out, layout.offset[BinaryModelLayout::Quantiles], model.quantiles);
+			PutArray(out, layout.offset[BinaryModelLayout::Resources], model.resources);
+			PutArray(out, layout.offset[BinaryModelLayout::NameStart], nameStart);
+
+			for (size_t idx = 0; idx < model.names.size(); idx++)
+				Put(out, layout.offset[BinaryModelLayout::NameChars] + nameStart[idx], model.names[idx].data(), model.names[idx].size());
+
+			// without name characters the file ends in padding, it still gets its full size
+			if (header.nameBytes == 0)
+				Put(out, header.fileSize - 1, "", 1);
+
+			if (!out.flush()) {
+				error = "cannot write " + path;
+				return false;
+			}
+
+			return true;
+		}
+
+	private:
+		static void Put(std::ofstream& out, std::uint64_t offset, const void* data, size_t bytes) {
+			out.seekp(static_cast<std::streamoff>(offset));
+			out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+		}
+
+		template<typename T>
+		static void PutArray(std::ofstream& out, std::uint64_t offset, const std::vector<T>& array) {
+			Put(out, offset, array.data(), array.size() * sizeof(T));
+		}
+	};
+
+	/**
+	 * @brief read-only mapping of a binary model file, evaluated in place through view().
+	 * Opening checks the header and the ends of the row arrays, nothing is parsed or copied,
+	 * so processes mapping one file share its page cache copy.
+	 *
+	 * MappedModel model;
+	 * if (!model.open("model.tprm", error)) ...
+	 * CsrPenaltyFunction<> solver(model.view());
+	 */
+	class MappedModel {
+	private: // == MEMBERS ==
+		const char*				mData		= nullptr;	//!< start of the mapping
+		std::uint64_t			mSize		= 0;
+		CsrModelView			mView;
+		const std::uint64_t*	mNameStart	= nullptr;	//!< name i is [ mNameStart[i], mNameStart[i + 1] ) of mNameChars
+		const char*				mNameChars	= nullptr;
+
+	public: // == METHODS ==
+		MappedModel() = default;
+		MappedModel(const MappedModel&) = delete;
+		MappedModel& operator=(const MappedModel&) = delete;
+
+		MappedModel(MappedModel&& other) {
+			*this = std::move(other);
+		}
+
+		MappedModel& operator=(MappedModel&& other) {
+			if (this != &other) {
+				close();
+				mData		= other.mData;
+				mSize		= other.mSize;
+				mView		= other.mView;
+				mNameStart	= other.mNameStart;
+				mNameChars	= other.mNameChars;
+				other.mData = nullptr;
+				other.close();
+			}
+
+			return *this;
+		}
+
+		~MappedModel() {
+			close();
+		}
+
+		/**
+		 * @param error	reason when the file is not a binary model of this version
+		 * @return false if the file is rejected, the model is closed then.
+		 */
+		bool open(const std::string& path, std::string& error) {
+			close();
+
+			if (!Map(path, error))
+				return false;
+
+			if (!Check(error)) {
+				close();
+				return false;
+			}
+
+			return true;
+		}
+
+		void close() {
+			if (mData)
+				Unmap();
+
+			mData		= nullptr;
+			mSize		= 0;
+			mView		= CsrModelView();
+			mNameStart	= nullptr;
+			mNameChars	= nullptr;
+		}
+
+		bool isOpen() const {
+			return mData != nullptr;
+		}
+
+		/**
+		 * valid until the model is closed
+		 */
+		const CsrModelView& view() const {
+			return mView;
+		}
+
+		size_t size() const {
+			return mView.variables;
+		}
+
+		std::string name(size_t idx) const {
+			return std::string(mNameChars + mNameStart[idx], mNameChars + mNameStart[idx + 1]);
+		}
+
+		/**
+		 * full check of the indices, reads every page of the file.
+		 * open only checks what costs no scan, a file of a foreign writer should pass validate before a solve.
+		 */
+		bool validate(std::string& error) const {
+			if (!CheckRows(mView.linearStart, mView.linearColumns, mView.linearRows, "linear", error))
+				return false;
+
+			if (!CheckRows(mView.chanceStart, mView.chanceColumns, mView.chanceRows, "chance", error))
+				return false;
+
+			for (size_t idx = 0; idx < mView.variables; idx++) {
+				if (mNameStart[idx] > mNameStart[idx + 1]) {
+					error = "name offsets out of order";
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+	private:
+		template<typename T>
+		const T* At(const BinaryModelLayout& layout, BinaryModelLayout::Section section) const {
+			return reinterpret_cast<const T*>(mData + layout.offset[section]);
+		}
+
+		bool Check(std::string& error) {
+			BinaryModelHeader header;
+
+			if (mSize < sizeof(header)) {
+				error = "too short for a header";
+				return false;
+			}
+
+			std::memcpy(&header, mData, sizeof(header));
+
+			if (std::memcmp(header.magic, BinaryModelHeader::Magic(), sizeof(header.magic)) != 0) {
+				error = "not a binary model";
+				return false;
+			}
+
+			if (header.byteOrder != BinaryModelHeader::ByteOrder) {
+				error = "written on a machine of other byte order";
+				return false;
+			}
+
+			if (header.version != BinaryModelHeader::Version) {
+				error = "version " + std::to_string(header.version) + ", expected " + std::to_string(BinaryModelHeader::Version);
+				return false;
+			}
+
+			// every count is at most the size of the file, the layout cannot overflow then
+			const std::uint64_t counts[] = { header.variables, header.linearRows, header.linearNonzeros, header.chanceRows, header.chanceNonzeros, header.nameBytes };
+
+			for (std::uint64_t count : counts) {
+				if (count > mSize) {
+					error = "counts exceed the file";
+					return false;
+				}
+			}
+
+			BinaryModelLayout layout(header);
+
+			if (header.fileSize != mSize || layout.offset[BinaryModelLayout::SectionCount] != mSize) {
+				error = "size " + std::to_string(mSize) + " does not match the header";
+				return false;
+			}
+
+			mView.variables		= header.variables;
+			mView.linearRows	= header.linearRows;
+			mView.chanceRows	= header.chanceRows;
+			mView.objective		= At<double>(layout, BinaryModelLayout::Objective);
+			mView.linearStart	= At<CsrOffset>(layout, BinaryModelLayout::LinearStart);
+			mView.linearColumns	= At<CsrColumn>(layout, BinaryModelLayout::LinearColumns);
+			mView.linearValues	= At<double>(layout, BinaryModelLayout::LinearValues);
+			mView.bounds		= At<double>(layout, BinaryModelLayout::Bounds);
+			mView.chanceStart	= At<CsrOffset>(layout, BinaryModelLayout::ChanceStart);
+			mView.chanceColumns	= At<CsrColumn>(layout, BinaryModelLayout::ChanceColumns);
+			mView.chanceValues	= At<double>(layout, BinaryModelLayout::ChanceValues);
+			mView.variances		= At<double>(layout, BinaryModelLayout::Variances);
+			mView.quantiles		= At<double>(layout, BinaryModelLayout::Quantiles);
+			mView.resources		= At<double>(layout, BinaryModelLayout::Resources);
+			mNameStart			= At<std::uint64_t>(layout, BinaryModelLayout::NameStart);
+			mNameChars			= At<char>(layout, BinaryModelLayout::NameChars);
+
+			if (mView.linearStart[0] != 0 || mView.linearStart[header.linearRows] != header.linearNonzeros
+				|| mView.chanceStart[0] != 0 || mView.chanceStart[header.chanceRows] != header.chanceNonzeros
+				|| mNameStart[0] != 0 || mNameStart[header.variables] != header.nameBytes
+			) {
+				error = "row arrays do not match the counts";
+				return false;
+			}
+
+			return true;
+		}
+
+		bool CheckRows(const CsrOffset* rowStart, const CsrColumn* columns, size_t rows, const char* what, std::string& error) const {
+			for (size_t row = 0; row < rows; row++) {
+				if (rowStart[row] > rowStart[row + 1]) {
+					error = std::string(what) + " row " + std::to_string(row) + ": offsets out of order";
+					return false;
+				}
+
+				for (CsrOffset k = rowStart[row]; k < rowStart[row + 1]; k++) {
+					if (columns[k] >= mView.variables) {
+						error = std::string(what) + " row " + std::to_string(row) + ": column out of range";
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+#ifdef _WIN32
+		bool Map(const std::string& path, std::string& error) {
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+			if (file == INVALID_HANDLE_VALUE) {
+				error = "cannot open " + path;
+				return false;
+			}
+
+			LARGE_INTEGER size;
+			HANDLE mapping = nullptr;
+
+			if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+				mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+			// the view keeps the mapping alive
+			const void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+			if (mapping)
+				CloseHandle(mapping);
+
+			CloseHandle(file);
+
+			if (!data) {
+				error = "cannot map " + path;
+				return false;
+			}
+
+			mData = static_cast<const char*>(data);
+			mSize = static_cast<std::uint64_t>(size.QuadPart);
+			return true;
+		}
+
+		void Unmap() {
+			UnmapViewOfFile(mData);
+		}
+#else
+		bool Map(const std::string& path, std::string& error) {
+			int fd = ::open(path.c_str(), O_RDONLY);
+
+			if (fd < 0) {
+				error = "cannot open " + path;
+				return false;
+			}
+
+			struct stat st;
+			void* data = MAP_FAILED;
+
+			if (::fstat(fd, &st) == 0 && st.st_size > 0)
+				data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+			// the mapping keeps the file alive
+			::close(fd);
+
+			if (data == MAP_FAILED) {
+				error = "cannot map " + path;
+				return false;
+			}
+
+			// every solve iteration scans all arrays, start reading the pages ahead
+			::madvise(data, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+			mData = static_cast<const char*>(data);
+			mSize = static_cast<std::uint64_t>(st.st_size);
+			return true;
+		}
+
+		void Unmap() {
+			::munmap(const_cast<char*>(mData), static_cast<size_t>(mSize));
+		}
+#endif
+	};
+}// namespace tpr
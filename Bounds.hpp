@@ -0,0 +1,215 @@
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <cassert>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+
+#include "Evaluator.hpp"
+
+namespace tpr {
+	/**
+	 * @brief box lower[i] <= x[i] <= upper[i] on the variable vector.
+	 * Bounds are not penalized, the descent classes that support them keep x inside by projection:
+	 * P( x )[i] = min( max( x[i], lower[i] ), upper[i] ). An empty box bounds nothing.
+	 *
+	 * solver.setBounds( Box<double>::nonnegative( model.size() ) );	// production quantities
+	 */
+	template<typename T>
+	class Box {
+	public: // == TYPES ==
+		using ValueType = T;
+	private: // == MEMBERS ==
+		std::vector<T>	mLower;
+		std::vector<T>	mUpper;
+	public: // == METHODS ==
+		Box() = default;
+
+		/**
+		 * @param lower, upper	one entry per variable, -/+ infinity leaves a side open
+		 */
+		Box(std::vector<T> lower, std::vector<T> upper) : mLower(std::move(lower)), mUpper(std::move(upper)) {
+			assert(mLower.size() == mUpper.size());
+		}
+
+		/**
+		 * x[i] >= 0 for n variables
+		 */
+		static Box nonnegative(size_t n) {
+			return Box(std::vector<T>(n, T()), std::vector<T>(n, std::numeric_limits<T>::infinity()));
+		}
+
+		bool empty() const {
+			return mLower.empty();
+		}
+
+		size_t size() const {
+			return mLower.size();
+		}
+
+		T lower(size_t idx) const {
+			return mLower[idx];
+		}
+
+		T upper(size_t idx) const {
+			return mUpper[idx];
+		}
+
+		/**
+		 * x = P( x )
+		 */
+		template<typename VecT>
+		void project(VecT& x) const {
+			for (size_t idx = 0; idx < mLower.size(); idx++)
+				x[idx] = std::min(std::max(x[idx], mLower[idx]), mUpper[idx]);
+		}
+
+		/**
+		 * d = P( x + d ) - x, computed as min( max( d, lower - x ), upper - x ) so a short d inside the box
+		 * is not lost to the cancellation in ( x + d ) - x.
+		 */
+		template<typename VecT>
+		void clip(const VecT& x, VecT& d) const {
+			for (size_t idx = 0; idx < mLower.size(); idx++)
+				d[idx] = std::min(std::max(d[idx], mLower[idx] - x[idx]), mUpper[idx] - x[idx]);
+		}
+
+		/**
+		 * d[i] = 0 for every x[i] held at its bound, x[i] = lower[i] with grad[i] > 0 or x[i] = upper[i] with grad[i] < 0.
+		 * A descent direction masked this way moves the free variables only.
+		 */
+		template<typename VecT>
+		void hold(const VecT& x, const VecT& grad, VecT& d) const {
+			for (size_t idx = 0; idx < mLower.size(); idx++) {
+				if ((x[idx] <= mLower[idx] && grad[idx] > 0) || (x[idx] >= mUpper[idx] && grad[idx] < 0))
+					d[idx] = T();
+			}
+		}
+
+		/**
+		 * max | P( x - grad ) - x |, zero exactly at the stationary points of f on the box:
+		 * a component of grad pushing x against its bound does not count.
+		 */
+		template<typename VecT>
+		T stationarity(const VecT& x, const VecT& grad) const {
+			T rval = T();
+
+			for (size_t idx = 0; idx < x.size(); idx++) {
+				T moved = -grad[idx];
+
+				if (idx < mLower.size())
+					moved = std::min(std::max(moved, mLower[idx] - x[idx]), mUpper[idx] - x[idx]);
+
+				rval = std::max(rval, std::fabs(moved));
+			}
+
+			return rval;
+		}
+	};
+
+	/**
+	 * @brief detects the optional bounds of an objective
+	 * const Box<ValueType>& box() const;
+	 * PenaltyFunction::FxRkFunction and CsrPenaltyFunction::FxRkFunction provide it.
+	 */
+	template<typename F, typename = void>
+	struct HasBox : std::false_type {};
+
+	template<typename F>
+	struct HasBox<F, typename detail::VoidT<
+		decltype(std::declval<const F&>().box())
+	>::type> : std::true_type {};
+
+	/**
+	 * @brief projection onto the box of F for the descent classes, a no-op for F without box()
+	 */
+	template<typename F, bool Bounded = HasBox<F>::value>
+	struct Projection {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+
+		/**
+		 * true when x has to be projected, the descent keeps its unbounded arithmetic otherwise
+		 */
+		static bool active(const F& f) {
+			return !f.box().empty();
+		}
+
+		static void project(const F& f, VectorT& x) {
+			f.box().project(x);
+		}
+
+		/**
+		 * d = P( x + d ) - x
+		 */
+		static void clip(const F& f, const VectorT& x, VectorT& d) {
+			f.box().clip(x, d);
+		}
+
+		/**
+		 * d[i] = 0 where x[i] is held at its bound by grad, see Box::hold
+		 */
+		static void hold(const F& f, const VectorT& x, const VectorT& grad, VectorT& d) {
+			f.box().hold(x, grad, d);
+		}
+
+		/**
+		 * max | P( x - grad ) - x |, max | grad | without bounds
+		 */
+		static ValueType stationarity(const F& f, const VectorT& x, const VectorT& grad) {
+			return f.box().stationarity(x, grad);
+		}
+	};
+
+	template<typename F>
+	struct Projection<F, false> {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+
+		static bool active(const F&) {
+			return false;
+		}
+
+		static void project(const F&, VectorT&) {}
+
+		static void clip(const F&, const VectorT&, VectorT&) {}
+
+		static void hold(const F&, const VectorT&, const VectorT&, VectorT&) {}
+
+		static ValueType stationarity(const F&, const VectorT&, const VectorT& grad) {
+			ValueType rval = ValueType();
+
+			for (size_t idx = 0; idx < grad.size(); idx++)
+				rval = std::max(rval, std::fabs(grad[idx]));
+
+			return rval;
+		}
+	};
+
+	/**
+	 * @brief detects descent classes that keep x inside the box of F,
+	 * static constexpr bool Projects = true;
+	 * solvers with bounds refuse the others, see requireProjection.
+	 */
+	template<typename D, typename = void>
+	struct ProjectsBounds : std::false_type {};
+
+	template<typename D>
+	struct ProjectsBounds<D, typename detail::VoidT<
+		decltype(D::Projects)
+	>::type> : std::integral_constant<bool, D::Projects> {};
+
+	/**
+	 * Throws std::invalid_argument when bounds are set and descent D does not project onto them.
+	 * Such a descent would return x outside the box without a sign, so the check also holds in release builds.
+	 */
+	template<typename D, typename T>
+	void requireProjection(const Box<T>& bounds) {
+		if (!bounds.empty() && !ProjectsBounds<D>::value)
+			throw std::invalid_argument("tpr: the descent ignores the bounds, use one with Projects set");
+	}
+}// namespace tpr
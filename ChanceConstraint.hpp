@@ -0,0 +1,171 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+#include "Evaluator.hpp"
+#include "Hessian.hpp"
+
+namespace tpr {
+	/**
+	 * @brief resource constraint with normally distributed consumption rates.
+	 * P( sum( a[k] * x[k] ) <= R ) >= p for independent a[k] ~ N( coeffs[k], variances[k] ) turns into
+	 * g(x) = sum( coeffs[k] * x[k] ) + FLaplassInverse * sqrt( sum( variances[k] * x[k]^2 ) ) - R <= 0
+	 * dg/dx[k] = coeffs[k] + FLaplassInverse * variances[k] * x[k] / sqrt( sum( variances[j] * x[j]^2 ) )
+	 * d2g/dx[j]dx[k] = FLaplassInverse * ( variances[k] * delta[j][k] / s - variances[j] * x[j] * variances[k] * x[k] / s^3 ), s = sqrt( ... )
+	 *
+	 * A constraint derives from ChanceConstraint and provides its row of the model table,
+	 * coeffs and variances in Sparsity order:
+	 * template<typename CfgParam>
+	 * struct G1 : ChanceConstraint< G1<CfgParam>, 18, IndexList< x111, x121, x131 > > {
+	 *		static constexpr std::array<double, 3> coeffs()		{ return {{ 1.5, 0.75, 2.5 }}; }
+	 *		static constexpr std::array<double, 3> variances()	{ return {{ 0.083, 0.0208, 0.083 }}; }
+	 *		static double laplassInverse()	{ return CfgParam::FLaplassInverse; }
+	 *		static double resource()		{ return CfgParam::Resource11; }
+	 * };
+	 */
+	template<typename RowT, size_t NVars, typename SparsityT>
+	struct ChanceConstraint;
+
+	template<typename RowT, size_t NVars, size_t ... Indices>
+	struct ChanceConstraint<RowT, NVars, IndexList<Indices ...>> {
+		static constexpr size_t N = NVars;
+		using ValueType = double;
+		using VectorT = std::array<ValueType, N>;
+		using Sparsity = IndexList<Indices ...>;
+		using SparseVectorT = std::array<ValueType, Sparsity::Size>;
+		using RowVectorT = std::array<ValueType, Sparsity::Size>;
+
+		/**
+		 * g(x) on plain values, on Dual for AutoGradient, on Batch for several points at once
+		 */
+		template<typename VecT>
+		static auto apply(const VecT& xargs) {
+			using std::sqrt;
+			typename std::decay<decltype(xargs[0])>::type linear, spread;
+			Sums(xargs, linear, spread, Seq());
+			return linear + RowT::laplassInverse() * sqrt(spread) - RowT::resource();
+		}
+
+		static VectorT gradient(const VectorT& xargs) {
+			ValueType value;
+			VectorT grad;
+			Evaluator<RowT>::evaluate(xargs, value, grad);
+			return grad;
+		}
+
+		/**
+		 * g(x) and its nonzero gradient entries in Sparsity order, sqrt( ... ) is computed once.
+		 * At x = 0 the sqrt term has no gradient, grad[k] = coeffs[k] there.
+		 */
+		static void evaluate_sparse(const VectorT& xargs, ValueType& value, SparseVectorT& grad) {
+			ValueType linear, spread;
+			Sums(xargs, linear, spread, Seq());
+			ValueType deviation = std::sqrt(spread);
+			value = linear + RowT::laplassInverse() * deviation - RowT::resource();
+
+			ValueType k = deviation > 0 ? RowT::laplassInverse() / deviation : ValueType();
+			Gradient(xargs, k, grad, Seq());
+		}
+
+		/**
+		 * g(x) from one pass over the Sparsity, grad is only filled for g(x) > 0.
+		 * Returns g(x) > 0.
+		 */
+		static bool evaluate_active_sparse(const VectorT& xargs, ValueType& value, SparseVectorT& grad) {
+			ValueType linear, spread;
+			Sums(xargs, linear, spread, Seq());
+			ValueType deviation = std::sqrt(spread);
+			value = linear + RowT::laplassInverse() * deviation - RowT::resource();
+
+			if (!(value > 0))
+				return false;
+
+			ValueType k = deviation > 0 ? RowT::laplassInverse() / deviation : ValueType();
+			Gradient(xargs, k, grad, Seq());
+			return true;
+		}
+
+		/**
+		 * H += coef * hessian( g( x ) ), only the Sparsity block is touched.
+		 * The sqrt term has no second derivative at x = 0, nothing is added there.
+		 */
+		static void add_hessian(const VectorT& xargs, ValueType coef, DenseMatrix<ValueType>& H) {
+			constexpr RowVectorT variances = RowT::variances();
+			ValueType linear, spread;
+			Sums(xargs, linear, spread, Seq());
+			ValueType deviation = std::sqrt(spread);
+
+			if (!(deviation > 0))
+				return;
+
+			ValueType k = coef * RowT::laplassInverse() / deviation;
+			SparseVectorT scaled;	// variances[j] * x[j] / s
+
+			for (size_t j = 0; j < Sparsity::Size; j++)
+				scaled[j] = variances[j] * xargs[Sparsity::at(j)] / deviation;
+
+			for (size_t j = 0; j < Sparsity::Size; j++) {
+				H(Sparsity::at(j), Sparsity::at(j)) += k * variances[j];
+
+				for (size_t l = 0; l < Sparsity::Size; l++)
+					H(Sparsity::at(j), Sparsity::at(l)) -= k * scaled[j] * scaled[l];
+			}
+		}
+
+		/**
+		 * hv += coef * hessian( g( x ) ) * v in O( Sparsity::Size ), without forming the block.
+		 */
+		static void add_hessian_vector(const VectorT& xargs, const VectorT& v, ValueType coef, VectorT& hv) {
+			constexpr RowVectorT variances = RowT::variances();
+			ValueType linear, spread;
+			Sums(xargs, linear, spread, Seq());
+			ValueType deviation = std::sqrt(spread);
+
+			if (!(deviation > 0))
+				return;
+
+			ValueType k = coef * RowT::laplassInverse() / deviation;
+			ValueType projection = 0.0;	// sum( variances[j] * x[j] * v[j] ) / s
+
+			for (size_t j = 0; j < Sparsity::Size; j++)
+				projection += variances[j] * xargs[Sparsity::at(j)] * v[Sparsity::at(j)];
+
+			projection /= deviation;
+
+			for (size_t j = 0; j < Sparsity::Size; j++) {
+				size_t col = Sparsity::at(j);
+				hv[col] += k * variances[j] * (v[col] - xargs[col] * projection / deviation);
+			}
+		}
+
+	private:
+		using Seq = std::make_index_sequence<Sparsity::Size>;
+
+		/**
+		 * linear = sum( coeffs[k] * x[k] ), spread = sum( variances[k] * x[k]^2 ), unrolled at compile time.
+		 */
+		template<typename VecT, typename ElementT, size_t ... K>
+		static void Sums(const VecT& xargs, ElementT& linear, ElementT& spread, std::index_sequence<K ...>) {
+			constexpr RowVectorT coeffs = RowT::coeffs();
+			constexpr RowVectorT variances = RowT::variances();
+			linear = ElementT();
+			spread = ElementT();
+			int expand[] = { 0, ((linear += coeffs[K] * xargs[Indices]), (spread += variances[K] * xargs[Indices] * xargs[Indices]), 0) ... };
+			(void)expand;
+		}
+
+		/**
+		 * grad[k] = coeffs[k] + k * variances[k] * x[k]
+		 */
+		template<size_t ... K>
+		static void Gradient(const VectorT& xargs, ValueType k, SparseVectorT& grad, std::index_sequence<K ...>) {
+			constexpr RowVectorT coeffs = RowT::coeffs();
+			constexpr RowVectorT variances = RowT::variances();
+			int expand[] = { 0, ((grad[K] = coeffs[K] + k * variances[K] * xargs[Indices]), 0) ... };
+			(void)expand;
+		}
+	};
+}// namespace tpr
@@ -0,0 +1,200 @@
+#pragma once
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#include "Evaluator.hpp"
+#include "LineSearch.hpp"
+#include "Bounds.hpp"
+
+namespace tpr {
+	/**
+	 * @brief beta[k] = || g[k] ||^2 / || g[k-1] ||^2
+	 * Converges globally with a strong Wolfe search and c2 < 1/2, but keeps taking tiny steps
+	 * once a bad direction was chosen, so ConjugateGradientDescent restarts it often.
+	 */
+	struct FletcherReeves {
+		template<typename ValueType>
+		static ValueType beta(ValueType gg, ValueType ggPrev, ValueType) {
+			return gg / ggPrev;
+		}
+	};
+
+	/**
+	 * @brief beta[k] = max( 0, g[k]' * ( g[k] - g[k-1] ) / || g[k-1] ||^2 )
+	 * Resets itself to steepest descent after small steps, where FR gets stuck, the max( 0, ... ) keeps it convergent.
+	 */
+	struct PolakRibierePlus {
+		template<typename ValueType>
+		static ValueType beta(ValueType gg, ValueType ggPrev, ValueType ggCross) {
+			return std::max(ValueType(), (gg - ggCross) / ggPrev);
+		}
+	};
+
+	/**
+	 * @brief nonlinear conjugate gradients, drop-in replacement for StepSplitGradientDescent.
+	 * d[0] = -g[0], d[k] = -g[k] + beta[k] * d[k-1], beta[k] is given by BetaT,
+	 * the step length is chosen by WolfeLineSearch with c2 = 0.1.
+	 * Keeps a few vectors of size N only, no curvature history as LBFGSDescent does.
+	 *
+	 * Restarts from d[k] = -g[k]
+	 *	- every N iterations,
+	 *	- when consecutive gradients are far from orthogonal, | g[k]' * g[k-1] | >= 0.2 * || g[k] ||^2 (Powell),
+	 *	- when d[k] is not a descent direction or the line search fails along it.
+	 * With a box g[k] and d[k] leave out the variables held at a bound, see Box::hold, the step follows
+	 * the projected path by ProjectedLineSearch and the descent stops on max | P( x - grad ) - x | <= GradientEpsilon.
+	 * Nocedal, Wright "Numerical Optimization", algorithm 5.4 and section 5.2.
+	 */
+	template< typename F,
+		typename IndexType = size_t,
+		typename BetaT = PolakRibierePlus
+	>
+	class ConjugateGradientDescent {
+	public: // == TYPES ==
+		using ValueType		= typename F::ValueType;
+		using VectorT		= typename F::VectorT;
+		using LineSearch	= WolfeLineSearch<F, IndexType>;
+		using BoxSearch		= ProjectedLineSearch<F, IndexType>;
+		using Beta			= BetaT;
+	public: // == CONSTANTS ==
+		static constexpr ValueType	Epsilon			= 1e-10;	//!< relative decrease of f( x ) to stop at
+		static constexpr ValueType	GradientEpsilon	= 1e-8;		//!< max | grad( f( x ) ) | to stop at
+		static constexpr IndexType	MaxIterations	= 100'000;
+		static constexpr ValueType	Curvature		= 0.1;		//!< c2 of the Wolfe conditions, below 1/2 keeps FR directions descending
+		static constexpr ValueType	Orthogonality	= 0.2;		//!< Powell restart threshold
+		static constexpr ValueType	Lambda			= 1.0;		//!< length of the first step along -grad( f( x0 ) )
+		static constexpr bool		Projects		= true;		//!< keeps x inside the box of F, see Bounds.hpp
+	public:
+		static VectorT calculate(const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(F(), x0, lambda, it, evaluations);
+		}
+
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(f, x0, lambda, it, evaluations);
+		}
+
+		/**
+		 * @param f				objective, called through the object so it may carry state
+		 * @param lambda		in: length of the first step, out: last accepted step
+		 * @param evaluations	incremented by the number of value + gradient evaluations, line search included
+		 */
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it, IndexType& evaluations) {
+			IndexType N = x0.size();// take num of vars from x0, runtime models have no F::N
+			const bool bounded = Projection<F>::active(f);
+			VectorT currentXVec = x0;
+			VectorT gradientVec;
+			VectorT freeGradientVec;	// g[k] without the components held at a bound
+			VectorT nextXVec;
+			VectorT nextGradientVec;
+			VectorT direction;
+			ValueType currentValue = 0.0;
+			ValueType nextValue = 0.0;
+			ValueType step = 0.0;
+			ValueType slope = 0.0;		// g[k]' * d[k]
+			IndexType sinceRestart = 0;	// iterations along conjugate directions
+
+			Projection<F>::project(f, currentXVec);
+			Evaluator<F>::evaluate(f, currentXVec, currentValue, gradientVec);
+			evaluations++;
+			freeGradientVec = gradientVec;
+			Projection<F>::hold(f, currentXVec, gradientVec, freeGradientVec);
+			ValueType squaredNorm = LineSearch::Dot(freeGradientVec, freeGradientVec);
+			direction = gradientVec;
+
+			for (it = 0; it < MaxIterations; it++) {
+				if (Projection<F>::stationarity(f, currentXVec, gradientVec) <= GradientEpsilon)
+					return currentXVec;
+
+				if (sinceRestart == 0) {
+					for (IndexType j = 0; j < N; j++)
+						direction[j] = -freeGradientVec[j];
+
+					ValueType restartSlope = -squaredNorm;
+					// first step of lambda, later restarts reuse the decrease of the last step
+					step = it == 0 ? lambda / std::sqrt(squaredNorm) : step * slope / restartSlope;
+					slope = restartSlope;
+				}
+
+				ValueType trial = step;
+				bool found = bounded
+					? BoxSearch::search(f, currentXVec, currentValue, gradientVec, direction, trial, nextXVec, nextValue, nextGradientVec, evaluations)
+					: LineSearch::search(f, currentXVec, currentValue, gradientVec, direction, trial, Curvature,
+						nextXVec, nextValue, nextGradientVec, evaluations);
+
+				if (!found) {
+					// conjugacy went stale, restart from steepest descent
+					if (sinceRestart > 0) {
+						sinceRestart = 0;
+						continue;
+					}
+
+					// no decrease along -grad( f( x ) ) is representable, x[k] is as good as it gets
+					return currentXVec;
+				}
+
+				step = trial;
+				lambda = step;
+
+				VectorT nextFreeGradientVec = nextGradientVec;
+				Projection<F>::hold(f, nextXVec, nextGradientVec, nextFreeGradientVec);
+				ValueType nextSquaredNorm = LineSearch::Dot(nextFreeGradientVec, nextFreeGradientVec);
+				ValueType cross = LineSearch::Dot(nextFreeGradientVec, freeGradientVec);
+				ValueType beta = Beta::beta(nextSquaredNorm, squaredNorm, cross);
+
+				ValueType diff = std::fabs(nextValue - currentValue);
+				ValueType scale = std::max(ValueType(1.0), std::max(std::fabs(nextValue), std::fabs(currentValue)));
+
+				currentXVec = nextXVec;
+				currentValue = nextValue;
+				gradientVec = nextGradientVec;
+				freeGradientVec = nextFreeGradientVec;
+				squaredNorm = nextSquaredNorm;
+
+				if (diff <= Epsilon * scale)
+					return currentXVec;
+
+				sinceRestart++;
+
+				if (sinceRestart >= N || std::fabs(cross) >= Orthogonality * squaredNorm) {
+					sinceRestart = 0;
+					continue;
+				}
+
+				// d[k+1] = -g[k+1] + beta * d[k]
+				ValueType nextSlope = 0.0;
+
+				for (IndexType j = 0; j < N; j++)
+					direction[j] = beta * direction[j] - freeGradientVec[j];
+
+				Projection<F>::hold(f, currentXVec, gradientVec, direction);
+
+				for (IndexType j = 0; j < N; j++)
+					nextSlope += gradientVec[j] * direction[j];
+
+				if (!(nextSlope < 0)) {
+					sinceRestart = 0;
+					continue;
+				}
+
+				// a[k+1] = a[k] * g[k]' * d[k] / g[k+1]' * d[k+1], the step that repeats the last first order decrease
+				step = step * slope / nextSlope;
+				slope = nextSlope;
+			}// for
+
+			assert(0 && "Failed");
+			return currentXVec;
+		}
+	};
+
+	/**
+	 * ConjugateGradientDescent with a fixed beta, fit a template<typename F, typename IndexType> class parameter:
+	 * PF::evaluate< PolakRibiereDescent >( x0 );
+	 */
+	template<typename F, typename IndexType = size_t>
+	using FletcherReevesDescent = ConjugateGradientDescent<F, IndexType, FletcherReeves>;
+
+	template<typename F, typename IndexType = size_t>
+	using PolakRibiereDescent = ConjugateGradientDescent<F, IndexType, PolakRibierePlus>;
+}// namespace tpr
@@ -0,0 +1,552 @@
+#pragma once
+#include <map>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace tpr {
+	using CsrOffset = std::uint64_t;	//!< index into the entries of a CsrMatrix
+	using CsrColumn = std::uint32_t;	//!< variable index of an entry
+
+	/**
+	 * @brief compressed sparse rows
+	 * the entries of row i are [ rowStart[i], rowStart[i + 1] ) of columns / values.
+	 * Index types have a fixed width, so a MappedModel file holds the same arrays.
+	 */
+	struct CsrMatrix {
+		std::vector<CsrOffset>	rowStart = { 0 };
+		std::vector<CsrColumn>	columns;
+		std::vector<double>		values;
+
+		size_t rows() const {
+			return rowStart.size() - 1;
+		}
+
+		size_t nonzeros() const {
+			return columns.size();
+		}
+
+		/**
+		 * appends a row, entries of the same column are summed, columns are kept sorted.
+		 */
+		void append(std::vector<std::pair<size_t, double>> entries) {
+			std::sort(entries.begin(), entries.end(),
+				[](const std::pair<size_t, double>& a, const std::pair<size_t, double>& b) { return a.first < b.first; });
+
+			for (const std::pair<size_t, double>& entry : entries) {
+				if (columns.size() > rowStart.back() && columns.back() == entry.first) {
+					values.back() += entry.second;
+				} else {
+					columns.push_back(static_cast<CsrColumn>(entry.first));
+					values.push_back(entry.second);
+				}
+			}
+
+			rowStart.push_back(columns.size());
+		}
+	};
+
+	/**
+	 * @brief constraints and objective of a model over arrays it does not own,
+	 * the vectors of a CsrModel or the pages of a MappedModel. Cheap to copy.
+	 * linear:	A[i] * x - b[i] <= 0
+	 * chance:	M[i] * x + quantile[i] * sqrt( sum( V[i][k] * x[k]^2 ) ) - resource[i] <= 0
+	 */
+	struct CsrModelView {
+		using ValueType = double;
+		using VectorT	= std::vector<ValueType>;
+
+		size_t				variables		= 0;
+		size_t				linearRows		= 0;
+		size_t				chanceRows		= 0;
+		const ValueType*	objective		= nullptr;	//!< c, dense
+		const CsrOffset*	linearStart		= nullptr;	//!< A
+		const CsrColumn*	linearColumns	= nullptr;
+		const ValueType*	linearValues	= nullptr;
+		const ValueType*	bounds			= nullptr;	//!< b
+		const CsrOffset*	chanceStart		= nullptr;	//!< M
+		const CsrColumn*	chanceColumns	= nullptr;
+		const ValueType*	chanceValues	= nullptr;
+		const ValueType*	variances		= nullptr;	//!< V, parallel to chanceValues
+		const ValueType*	quantiles		= nullptr;
+		const ValueType*	resources		= nullptr;
+
+		size_t size() const {
+			return variables;
+		}
+
+		size_t constraints() const {
+			return linearRows + chanceRows;
+		}
+
+		/**
+		 * c' * x in four partial sums, one chain of additions would wait on each of its terms
+		 */
+		ValueType objectiveValue(const VectorT& x) const {
+			ValueType sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+			size_t idx = 0;
+
+			for (; idx + 4 <= variables; idx += 4) {
+				sum0 += objective[idx] * x[idx];
+				sum1 += objective[idx + 1] * x[idx + 1];
+				sum2 += objective[idx + 2] * x[idx + 2];
+				sum3 += objective[idx + 3] * x[idx + 3];
+			}
+
+			for (; idx < variables; idx++)
+				sum0 += objective[idx] * x[idx];
+
+			return (sum0 + sum1) + (sum2 + sum3);
+		}
+
+		/**
+		 * A[row] * x - b[row], in two partial sums as objectiveValue
+		 */
+		ValueType linearValue(size_t row, const VectorT& x) const {
+			const CsrOffset end = linearStart[row + 1];
+			ValueType sum0 = -bounds[row], sum1 = 0.0;
+			CsrOffset k = linearStart[row];
+
+			for (; k + 2 <= end; k += 2) {
+				sum0 += linearValues[k] * x[linearColumns[k]];
+				sum1 += linearValues[k + 1] * x[linearColumns[k + 1]];
+			}
+
+			if (k < end)
+				sum0 += linearValues[k] * x[linearColumns[k]];
+
+			return sum0 + sum1;
+		}
+
+		/**
+		 * @param deviation	out: sqrt( sum( V[row][k] * x[k]^2 ) ), reused by scatterChance
+		 */
+		ValueType chanceValue(size_t row, const VectorT& x, ValueType& deviation) const {
+			ValueType sum = -resources[row];
+			ValueType spread = 0.0;
+
+			for (CsrOffset k = chanceStart[row]; k < chanceStart[row + 1]; k++) {
+				ValueType xk = x[chanceColumns[k]];
+				sum += chanceValues[k] * xk;
+				spread += variances[k] * xk * xk;
+			}
+
+			deviation = std::sqrt(spread);
+			return sum + quantiles[row] * deviation;
+		}
+
+		/**
+		 * grad += coef * grad( linear row )
+		 */
+		void scatterLinear(size_t row, ValueType coef, VectorT& grad) const {
+			for (CsrOffset k = linearStart[row]; k < linearStart[row + 1]; k++)
+				grad[linearColumns[k]] += coef * linearValues[k];
+		}
+
+		/**
+		 * grad += coef * grad( chance row ), at x = 0 the sqrt term has no gradient.
+		 */
+		void scatterChance(size_t row, ValueType coef, ValueType deviation, const VectorT& x, VectorT& grad) const {
+			ValueType scale = deviation > 0 ? quantiles[row] / deviation : 0.0;
+
+			for (CsrOffset k = chanceStart[row]; k < chanceStart[row + 1]; k++) {
+				CsrColumn col = chanceColumns[k];
+				grad[col] += coef * (chanceValues[k] + scale * variances[k] * x[col]);
+			}
+		}
+
+		/**
+		 * grad( linear row )' * v
+		 */
+		ValueType linearProduct(size_t row, const VectorT& v) const {
+			ValueType rval = 0.0;
+
+			for (CsrOffset k = linearStart[row]; k < linearStart[row + 1]; k++)
+				rval += linearValues[k] * v[linearColumns[k]];
+
+			return rval;
+		}
+
+		/**
+		 * grad( chance row )' * v, deviation as returned by chanceValue
+		 */
+		ValueType chanceProduct(size_t row, ValueType deviation, const VectorT& x, const VectorT& v) const {
+			ValueType scale = deviation > 0 ? quantiles[row] / deviation : 0.0;
+			ValueType rval = 0.0;
+
+			for (CsrOffset k = chanceStart[row]; k < chanceStart[row + 1]; k++) {
+				CsrColumn col = chanceColumns[k];
+				rval += (chanceValues[k] + scale * variances[k] * x[col]) * v[col];
+			}
+
+			return rval;
+		}
+
+		/**
+		 * hv += coef * hessian( chance row ) * v,
+		 * hessian[j][k] = quantile / s * ( V[j] * delta[j][k] - V[j] * x[j] * V[k] * x[k] / s^2 ), s = deviation
+		 */
+		void scatterChanceHessian(size_t row, ValueType coef, ValueType deviation, const VectorT& x, const VectorT& v, VectorT& hv) const {
+			if (!(deviation > 0))
+				return;
+
+			ValueType scale = coef * quantiles[row] / deviation;
+			ValueType projection = 0.0;
+
+			for (CsrOffset k = chanceStart[row]; k < chanceStart[row + 1]; k++) {
+				CsrColumn col = chanceColumns[k];
+				projection += variances[k] * x[col] * v[col];
+			}
+
+			projection /= deviation * deviation;
+
+			for (CsrOffset k = chanceStart[row]; k < chanceStart[row + 1]; k++) {
+				CsrColumn col = chanceColumns[k];
+				hv[col] += scale * variances[k] * (v[col] - x[col] * projection);
+			}
+		}
+
+		/**
+		 * gi(x) of all constraints, linear rows first
+		 */
+		VectorT constraintValues(const VectorT& x) const {
+			VectorT rval;
+			rval.reserve(constraints());
+			ValueType deviation;
+
+			for (size_t row = 0; row < linearRows; row++)
+				rval.push_back(linearValue(row, x));
+
+			for (size_t row = 0; row < chanceRows; row++)
+				rval.push_back(chanceValue(row, x, deviation));
+
+			return rval;
+		}
+
+		/**
+		 * max( 0, max( gi(x) ) ), zero for a feasible x
+		 */
+		ValueType infeasibility(const VectorT& x) const {
+			ValueType rval = 0.0;
+
+			for (ValueType g : constraintValues(x))
+				rval = std::max(rval, g);
+
+			return rval;
+		}
+	};
+
+	/**
+	 * @brief model read at runtime, see ModelLoader for the text format.
+	 * min( c' * x )
+	 * with the constraints of CsrModelView.
+	 * M and V share the sparsity pattern of chance, V is stored in variances, parallel to chance.values.
+	 */
+	struct CsrModel {
+		using ValueType = CsrModelView::ValueType;
+		using VectorT	= CsrModelView::VectorT;
+
+		std::vector<std::string>	names;			//!< variable names, in the order of x
+		VectorT						objective;		//!< c, dense
+		CsrMatrix					linear;			//!< A
+		VectorT						bounds;			//!< b
+		CsrMatrix					chance;			//!< M
+		VectorT						variances;		//!< V
+		VectorT						quantiles;
+		VectorT						resources;
+
+		/**
+		 * valid until the vectors of the model change
+		 */
+		CsrModelView view() const {
+			CsrModelView rval;
+			rval.variables		= names.size();
+			rval.linearRows		= linear.rows();
+			rval.chanceRows		= chance.rows();
+			rval.objective		= objective.data();
+			rval.linearStart	= linear.rowStart.data();
+			rval.linearColumns	= linear.columns.data();
+			rval.linearValues	= linear.values.data();
+			rval.bounds			= bounds.data();
+			rval.chanceStart	= chance.rowStart.data();
+			rval.chanceColumns	= chance.columns.data();
+			rval.chanceValues	= chance.values.data();
+			rval.variances		= variances.data();
+			rval.quantiles		= quantiles.data();
+			rval.resources		= resources.data();
+			return rval;
+		}
+
+		size_t size() const {
+			return names.size();
+		}
+
+		size_t constraints() const {
+			return linear.rows() + chance.rows();
+		}
+
+		ValueType objectiveValue(const VectorT& x) const {
+			return view().objectiveValue(x);
+		}
+
+		VectorT constraintValues(const VectorT& x) const {
+			return view().constraintValues(x);
+		}
+
+		ValueType infeasibility(const VectorT& x) const {
+			return view().infeasibility(x);
+		}
+	};
+
+	/**
+	 * @brief reads a CsrModel from text, one statement per line, # starts a comment:
+	 *
+	 * variables x111 x112 x121
+	 * minimize 3 x111 3 x112 9 x121
+	 * linear 1 x111 1 x112 >= 300
+	 * chance 1.5 x111 0.75 x121 quantile 1.282 variance 0.083 x111 0.0208 x121 <= 250
+	 *
+	 * Terms are <coefficient> <variable> pairs, variables are declared before use.
+	 * linear takes <= or >=, chance reads as
+	 * 1.5 * x111 + 0.75 * x121 + 1.282 * sqrt( 0.083 * x111^2 + 0.0208 * x121^2 ) <= 250
+	 */
+	class ModelLoader {
+	public: // == METHODS ==
+		/**
+		 * @param error	"line N: reason" when the model is rejected
+		 * @return false if the text is not a valid model, model is left in an unspecified state then.
+		 */
+		static bool load(std::istream& in, CsrModel& model, std::string& error) {
+			model = CsrModel();
+			std::map<std::string, size_t> index;
+			std::string line;
+			size_t lineNo = 0;
+			bool hasObjective = false;
+
+			while (std::getline(in, line)) {
+				lineNo++;
+				std::vector<std::string> tokens = Tokenize(line);
+
+				if (tokens.empty())
+					continue;
+
+				std::string reason;
+				const std::string& statement = tokens[0];
+
+				if (statement == "variables") {
+					for (size_t idx = 1; idx < tokens.size() && reason.empty(); idx++) {
+						if (!index.emplace(tokens[idx], model.names.size()).second)
+							reason = "variable " + tokens[idx] + " declared twice";
+						else
+							model.names.push_back(tokens[idx]);
+					}
+
+					model.objective.resize(model.names.size(), 0.0);
+				} else if (statement == "minimize") {
+					std::vector<std::pair<size_t, double>> terms;
+					size_t pos = 1;
+
+					if (hasObjective)
+						reason = "second objective";
+					else if (ReadTerms(tokens, pos, index, terms, reason) && pos != tokens.size())
+						reason = "unexpected " + tokens[pos];
+
+					for (const std::pair<size_t, double>& term : terms)
+						model.objective[term.first] += term.second;
+
+					hasObjective = true;
+				} else if (statement == "linear") {
+					ReadLinear(tokens, index, model, reason);
+				} else if (statement == "chance") {
+					ReadChance(tokens, index, model, reason);
+				} else {
+					reason = "unknown statement " + statement;
+				}
+
+				if (!reason.empty()) {
+					error = "line " + std::to_string(lineNo) + ": " + reason;
+					return false;
+				}
+			}
+
+			if (model.names.empty()) {
+				error = "no variables";
+				return false;
+			}
+
+			if (!hasObjective) {
+				error = "no objective";
+				return false;
+			}
+
+			return true;
+		}
+
+		static bool load(const std::string& path, CsrModel& model, std::string& error) {
+			std::ifstream in(path.c_str());
+
+			if (!in) {
+				error = "cannot open " + path;
+				return false;
+			}
+
+			return load(in, model, error);
+		}
+
+	private:
+		static std::vector<std::string> Tokenize(const std::string& line) {
+			std::istringstream stream(line.substr(0, line.find('#')));
+			std::vector<std::string> rval;
+			std::string token;
+
+			while (stream >> token)
+				rval.push_back(token);
+
+			return rval;
+		}
+
+		static bool ReadNumber(const std::string& token, double& value) {
+			char* end = nullptr;
+			value = std::strtod(token.c_str(), &end);
+			return !token.empty() && *end == '\0' && std::isfinite(value);
+		}
+
+		static bool IsKeyword(const std::string& token) {
+			return token == "<=" || token == ">=" || token == "quantile" || token == "variance";
+		}
+
+		/**
+		 * <coefficient> <variable> pairs from pos up to the next keyword or the end of the line.
+		 */
+		static bool ReadTerms(const std::vector<std::string>& tokens, size_t& pos, const std::map<std::string, size_t>& index,
+			std::vector<std::pair<size_t, double>>& terms, std::string& reason
+		) {
+			while (pos < tokens.size() && !IsKeyword(tokens[pos])) {
+				double coef;
+
+				if (!ReadNumber(tokens[pos], coef)) {
+					reason = "expected a coefficient, got " + tokens[pos];
+					return false;
+				}
+
+				if (++pos == tokens.size()) {
+					reason = "coefficient without a variable";
+					return false;
+				}
+
+				auto var = index.find(tokens[pos]);
+
+				if (var == index.end()) {
+					reason = "undeclared variable " + tokens[pos];
+					return false;
+				}
+
+				terms.emplace_back(var->second, coef);
+				pos++;
+			}
+
+			return true;
+		}
+
+		/**
+		 * <= <rhs> or >= <rhs> closing the statement
+		 */
+		static bool ReadBound(const std::vector<std::string>& tokens, size_t pos, bool allowGreater, bool& greater, double& rhs, std::string& reason) {
+			if (pos == tokens.size() || (tokens[pos] != "<=" && (!allowGreater || tokens[pos] != ">="))) {
+				reason = allowGreater ? "expected <= or >=" : "expected <=";
+				return false;
+			}
+
+			greater = tokens[pos] == ">=";
+
+			if (pos + 2 != tokens.size() || !ReadNumber(tokens[pos + 1], rhs)) {
+				reason = "expected a single number after " + tokens[pos];
+				return false;
+			}
+
+			return true;
+		}
+
+		static void ReadLinear(const std::vector<std::string>& tokens, const std::map<std::string, size_t>& index, CsrModel& model, std::string& reason) {
+			std::vector<std::pair<size_t, double>> terms;
+			size_t pos = 1;
+			bool greater = false;
+			double rhs = 0.0;
+
+			if (!ReadTerms(tokens, pos, index, terms, reason) || !ReadBound(tokens, pos, true, greater, rhs, reason))
+				return;
+
+			// a * x >= b is stored as -a * x <= -b
+			if (greater) {
+				for (std::pair<size_t, double>& term : terms)
+					term.second = -term.second;
+
+				rhs = -rhs;
+			}
+
+			model.linear.append(terms);
+			model.bounds.push_back(rhs);
+		}
+
+		static void ReadChance(const std::vector<std::string>& tokens, const std::map<std::string, size_t>& index, CsrModel& model, std::string& reason) {
+			std::vector<std::pair<size_t, double>> means;
+			std::vector<std::pair<size_t, double>> variances;
+			size_t pos = 1;
+			bool greater = false;
+			double quantile = 0.0;
+			double resource = 0.0;
+
+			if (!ReadTerms(tokens, pos, index, means, reason))
+				return;
+
+			if (pos + 1 >= tokens.size() || tokens[pos] != "quantile" || !ReadNumber(tokens[pos + 1], quantile)) {
+				reason = "expected quantile <number>";
+				return;
+			}
+
+			pos += 2;
+
+			if (pos == tokens.size() || tokens[pos] != "variance") {
+				reason = "expected variance";
+				return;
+			}
+
+			pos++;
+
+			if (!ReadTerms(tokens, pos, index, variances, reason) || !ReadBound(tokens, pos, false, greater, resource, reason))
+				return;
+
+			// one entry per variable of either sum, its mean goes to chance, its variance to variances
+			std::map<size_t, std::pair<double, double>> entries;
+			std::vector<std::pair<size_t, double>> row;
+
+			for (const std::pair<size_t, double>& term : means)
+				entries[term.first].first += term.second;
+
+			for (const std::pair<size_t, double>& term : variances)
+				entries[term.first].second += term.second;
+
+			for (const auto& entry : entries) {
+				if (entry.second.second < 0) {
+					reason = "negative variance of " + model.names[entry.first];
+					return;
+				}
+			}
+
+			for (const auto& entry : entries) {
+				row.emplace_back(entry.first, entry.second.first);
+				model.variances.push_back(entry.second.second);
+			}
+
+			model.chance.append(row);
+			model.quantiles.push_back(quantile);
+			model.resources.push_back(resource);
+		}
+	};
+}// namespace tpr
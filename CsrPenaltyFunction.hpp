@@ -0,0 +1,280 @@
+#pragma once
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+
+#include "GradientDescent.hpp"
+#include "LBFGSDescent.hpp"
+#include "ConjugateGradientDescent.hpp"
+#include "TruncatedNewtonDescent.hpp"
+#include "ExactStepGradientDescent.hpp"
+#include "SpectralGradientDescent.hpp"
+#include "CsrModel.hpp"
+#include "Bounds.hpp"
+#include "PenaltyPower.hpp"
+
+namespace tpr {
+	/**
+	 * @brief penalty function algorithm of PenaltyFunction for a model read at runtime
+	 * F(x, r[k]) = c' * x + r[k] * sum( max( 0, gi(x) )^P ), P is the PowerT policy as in BasicPenaltyFunction
+	 * with the constraints of a CsrModelView, the same r[k] schedule and stopping rule as PenaltyFunction.
+	 * Vectors are std::vector sized by the model, so any descent class works as the inner minimizer.
+	 *
+	 * CsrModel model;
+	 * ModelLoader::load("model.txt", model, error);
+	 * CsrPenaltyFunction<> solver(model);			// or solver(mappedModel.view())
+	 * xOpt = solver.solve(x0);
+	 */
+	template<typename IndexType = size_t, typename PowerT = IntegerPower<2>>
+	class CsrPenaltyFunction {
+	public: // == TYPES ==
+		using ValueType = CsrModelView::ValueType;
+		using VectorT	= CsrModelView::VectorT;
+		using Power		= PowerT;
+		using ThisT		= CsrPenaltyFunction<IndexType, PowerT>;
+
+		/**
+		 * F(x, r[k]) over the rows of the model, r[k] and the bounds of x are held by reference, the view by value.
+		 */
+		struct FxRkFunction {
+			using ValueType = typename ThisT::ValueType;
+			using VectorT	= typename ThisT::VectorT;
+
+			const CsrModelView		model;
+			const ValueType&		rk;
+			const Box<ValueType>*	bounds = nullptr;
+
+			FxRkFunction(const CsrModelView& modelView, const ValueType& rkRef) : model(modelView), rk(rkRef) {}
+
+			FxRkFunction(const CsrModelView& modelView, const ValueType& rkRef, const Box<ValueType>& boundsRef)
+				: model(modelView), rk(rkRef), bounds(&boundsRef) {}
+
+			/**
+			 * box the projecting descents keep x in, empty when there is none
+			 */
+			const Box<ValueType>& box() const {
+				static const Box<ValueType> none;
+				return bounds ? *bounds : none;
+			}
+
+			ValueType apply(const VectorT& xArgs) const {
+				ValueType penalty = 0.0;
+				ValueType deviation;
+
+				for (size_t row = 0; row < model.linearRows; row++)
+					penalty += Power::apply(model.linearValue(row, xArgs));
+
+				for (size_t row = 0; row < model.chanceRows; row++)
+					penalty += Power::apply(model.chanceValue(row, xArgs, deviation));
+
+				return model.objectiveValue(xArgs) + rk * penalty;
+			}
+
+			/**
+			 * F(x, r[k]) and its gradient in one pass, grad is resized to the model.
+			 * The gradient of a row is only scattered when gi(x) > 0.
+			 */
+			void evaluate(const VectorT& xArgs, ValueType& value, VectorT& grad) const {
+				ValueType penalty = 0.0;
+				grad.assign(model.objective, model.objective + model.variables);
+
+				for (size_t row = 0; row < model.linearRows; row++) {
+					ValueType g = model.linearValue(row, xArgs);
+
+					if (g > 0) {
+						ValueType term, slope;
+						Power::evaluate(g, term, slope);
+						penalty += term;
+						model.scatterLinear(row, rk * slope, grad);
+					}
+				}
+
+				for (size_t row = 0; row < model.chanceRows; row++) {
+					ValueType deviation;
+					ValueType g = model.chanceValue(row, xArgs, deviation);
+
+					if (g > 0) {
+						ValueType term, slope;
+						Power::evaluate(g, term, slope);
+						penalty += term;
+						model.scatterChance(row, rk * slope, deviation, xArgs, grad);
+					}
+				}
+
+				value = model.objectiveValue(xArgs) + rk * penalty;
+			}
+
+			/**
+			 * hv = hessian( F(x, r[k]) ) * v over the active rows, for TruncatedNewtonDescent.
+			 */
+			void hessian_vector(const VectorT& xArgs, const VectorT& v, VectorT& hv) const {
+				hv.assign(model.variables, ValueType());
+
+				for (size_t row = 0; row < model.linearRows; row++) {
+					ValueType g = model.linearValue(row, xArgs);
+
+					if (g > 0)
+						model.scatterLinear(row, rk * Power::curvature(g) * model.linearProduct(row, v), hv);
+				}
+
+				for (size_t row = 0; row < model.chanceRows; row++) {
+					ValueType deviation;
+					ValueType g = model.chanceValue(row, xArgs, deviation);
+
+					if (g > 0) {
+						ValueType term, slope;
+						Power::evaluate(g, term, slope);
+						model.scatterChance(row, rk * Power::curvature(g) * model.chanceProduct(row, deviation, xArgs, v), deviation, xArgs, hv);
+						model.scatterChanceHessian(row, rk * slope, deviation, xArgs, v, hv);
+					}
+				}
+			}
+
+			/**
+			 * F(x + t * d, r[k]) as a PenaltyRay, for ExactLineSearch: exact over the linear rows, chance rows linearized.
+			 */
+			void ray(const VectorT& xArgs, const VectorT& d, PenaltyRay<ValueType>& ray) const {
+				static_assert(std::is_same<PowerT, IntegerPower<2>>::value, "the penalty is piecewise quadratic along a ray for P = 2 only");
+				ray.reset(model.objectiveValue(d), ValueType(), rk);
+
+				for (size_t row = 0; row < model.linearRows; row++)
+					ray.add(model.linearValue(row, xArgs), model.linearProduct(row, d));
+
+				for (size_t row = 0; row < model.chanceRows; row++) {
+					ValueType deviation;
+					ValueType g = model.chanceValue(row, xArgs, deviation);
+					ray.add(g, model.chanceProduct(row, deviation, xArgs, d));
+				}
+			}
+
+			VectorT gradient(const VectorT& xArgs) const {
+				ValueType value;
+				VectorT rval;
+				evaluate(xArgs, value, rval);
+				return rval;
+			}
+		};
+
+		using FxRk = FxRkFunction;
+
+	public: // == CONSTANTS ==
+		static constexpr ValueType	Beta			= 2.0f;			//!< growth factor.
+		static constexpr ValueType	Epsilon			= 1e-5f;		//!< accuracy
+		static constexpr ValueType	DefaultC		= 0.5f;			//!< positive constant
+		static constexpr IndexType	MaxPIterations	= 100'000;
+
+	private: // == MEMBERS ==
+		CsrModelView	mModel;
+		ValueType		mC					= DefaultC;		//!< r[k]
+		Box<ValueType>	mBounds;							//!< bounds of x, enforced by the descent
+		ValueType		mLambda				= ValueType();	//!< step of the last inner solve
+		IndexType		mOuterIterations	= 0;			//!< inner solves done
+		IndexType		mInnerIterations	= 0;			//!< descent iterations over all inner solves
+		IndexType		mTruncatedSolves	= 0;			//!< inner solves the descent ended at its MaxIterations
+
+	public: // == METHODS ==
+		/**
+		 * @param model	arrays of the model, must outlive the solver
+		 */
+		explicit CsrPenaltyFunction(const CsrModelView& model) : mModel(model) {}
+
+		/**
+		 * @param model	held by reference, its vectors must not change while the solver is used
+		 */
+		explicit CsrPenaltyFunction(const CsrModel& model) : mModel(model.view()) {}
+
+		/**
+		 * max( 0, max( gi(x) ) ), zero for a feasible x
+		 */
+		ValueType infeasibility(const VectorT& xArgs) const {
+			return mModel.infeasibility(xArgs);
+		}
+
+		/**
+		 * lower <= x <= upper, kept by projection instead of penalty rows, see PenaltyFunction::setBounds.
+		 * solver.setBounds( Box<double>::nonnegative( model.size() ) );
+		 * @param bounds	one entry per variable of the model or empty to drop them
+		 */
+		void setBounds(const Box<ValueType>& bounds) {
+			assert(bounds.empty() || bounds.size() == mModel.size());
+			mBounds = bounds;
+		}
+
+		const Box<ValueType>& bounds() const {
+			return mBounds;
+		}
+
+		/**
+		 * @tparam GradientDescentT	minimizer of F(x, r[k]), see PenaltyFunction::solve
+		 * @param x0	start point, one entry per variable of the model
+		 */
+		template<template<typename, typename> class GradientDescentT = StepSplitGradientDescent>
+		VectorT solve(const VectorT& x0) {
+			assert(x0.size() == mModel.size());
+			mC = DefaultC;
+			mOuterIterations = 0;
+			mInnerIterations = 0;
+			mTruncatedSolves = 0;
+			VectorT xArgs = x0;
+			const FxRk fxRk(mModel, mC, mBounds);
+
+			using GradientDescent = GradientDescentT<FxRk, IndexType>;
+			requireProjection<GradientDescent>(mBounds);
+			mBounds.project(xArgs);
+			IndexType idx = 0;
+
+			for (; idx < MaxPIterations; idx++) {
+				IndexType it = 0;
+
+				// find min( F(x, rk) )
+				mLambda = GradientDescent::Lambda;
+				VectorT xOptLoc = GradientDescent::calculate(fxRk, xArgs, mLambda, it);
+				ValueType eps = std::fabs(mModel.objectiveValue(xOptLoc) - mModel.objectiveValue(xArgs));
+				mOuterIterations++;
+				mInnerIterations += it;
+				mTruncatedSolves += it >= GradientDescent::MaxIterations ? 1 : 0;
+
+				if (eps <= Epsilon)
+					return xOptLoc;
+
+				// r[k+1] = r[k] * B
+				mC *= ThisT::Beta;
+				xArgs = xOptLoc;
+			}
+
+			if (idx >= MaxPIterations) {
+				assert(0 && "Failure");
+			}
+
+			return xArgs;
+		}
+
+		const CsrModelView& model() const {
+			return mModel;
+		}
+
+		ValueType coefficient() const {
+			return mC;
+		}
+
+		ValueType lambda() const {
+			return mLambda;
+		}
+
+		IndexType outerIterations() const {
+			return mOuterIterations;
+		}
+
+		IndexType innerIterations() const {
+			return mInnerIterations;
+		}
+
+		/**
+		 * inner solves of the last solve that ran out of descent iterations, a bounded descent returns its best x then
+		 */
+		IndexType truncatedSolves() const {
+			return mTruncatedSolves;
+		}
+	};
+}// namespace tpr
@@ -0,0 +1,293 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace tpr {
+	namespace detail {
+		template<typename ...>
+		struct VoidT {
+			using type = void;
+		};
+	}// namespace detail
+
+	/**
+	 * @brief detects the optional fused entry point of Fx/Gi types
+	 * static void evaluate(const VectorT& x, ValueType& value, VectorT& grad);
+	 * or the same const member function of a stateful objective.
+	 */
+	template<typename F, typename = void>
+	struct HasEvaluate : std::false_type {};
+
+	template<typename F>
+	struct HasEvaluate<F, typename detail::VoidT<
+		decltype(std::declval<const F&>().evaluate(
+			std::declval<const typename F::VectorT&>(),
+			std::declval<typename F::ValueType&>(),
+			std::declval<typename F::VectorT&>()
+		))
+	>::type> : std::true_type {};
+
+	/**
+	 * @brief compile-time list of the variables a constraint depends on.
+	 * using Sparsity = IndexList< x111, x121, x131 >;
+	 */
+	template<size_t ... Indices>
+	struct IndexList {
+		static constexpr size_t Size = sizeof...(Indices);
+
+		static size_t at(size_t k) {
+			static constexpr size_t values[] = { Indices ... };
+			return values[k];
+		}
+
+		/**
+		 * acc[ Indices[k] ] += coef * grad[k], unrolled at compile time.
+		 */
+		template<typename ValueT, typename SparseVecT, typename VecT>
+		static void scatter(ValueT coef, const SparseVecT& grad, VecT& acc) {
+			scatter(coef, grad, acc, std::make_index_sequence<Size>());
+		}
+
+		/**
+		 * sum( grad[k] * v[ Indices[k] ] ), unrolled at compile time.
+		 */
+		template<typename SparseVecT, typename VecT>
+		static typename VecT::value_type dot(const SparseVecT& grad, const VecT& v) {
+			return dot(grad, v, std::make_index_sequence<Size>());
+		}
+
+		/**
+		 * H( Indices[j], Indices[k] ) += coef * grad[j] * grad[k], the Sparsity block of a rank one term.
+		 */
+		template<typename ValueT, typename SparseVecT, typename MatrixT>
+		static void scatter_outer(ValueT coef, const SparseVecT& grad, MatrixT& H) {
+			for (size_t j = 0; j < Size; j++) {
+				ValueT row = coef * grad[j];
+
+				for (size_t k = 0; k < Size; k++)
+					H(at(j), at(k)) += row * grad[k];
+			}
+		}
+
+	private:
+		template<typename ValueT, typename SparseVecT, typename VecT, size_t ... K>
+		static void scatter(ValueT coef, const SparseVecT& grad, VecT& acc, std::index_sequence<K ...>) {
+			int expand[] = { 0, ((acc[Indices] += coef * grad[K]), 0) ... };
+			(void)expand;
+		}
+
+		template<typename SparseVecT, typename VecT, size_t ... K>
+		static typename VecT::value_type dot(const SparseVecT& grad, const VecT& v, std::index_sequence<K ...>) {
+			typename VecT::value_type rval = typename VecT::value_type();
+			int expand[] = { 0, ((rval += grad[K] * v[Indices]), 0) ... };
+			(void)expand;
+			return rval;
+		}
+	};
+
+	/**
+	 * @brief detects a sparse constraint
+	 * using Sparsity = IndexList< ... >;
+	 * static void evaluate_sparse(const VectorT& x, ValueType& value, std::array<ValueType, Sparsity::Size>& grad);
+	 * grad[k] = dg/dx[ Sparsity::at(k) ], every other entry of the gradient is zero.
+	 */
+	template<typename F, typename = void>
+	struct HasSparsity : std::false_type {};
+
+	template<typename F>
+	struct HasSparsity<F, typename detail::VoidT<
+		decltype(F::evaluate_sparse(
+			std::declval<const typename F::VectorT&>(),
+			std::declval<typename F::ValueType&>(),
+			std::declval<std::array<typename F::ValueType, F::Sparsity::Size>&>()
+		))
+	>::type> : std::true_type {};
+
+	/**
+	 * @brief detects the optional active-set entry point of a sparse constraint
+	 * static bool evaluate_active_sparse(const VectorT& x, ValueType& value, std::array<ValueType, Sparsity::Size>& grad);
+	 * computes g(x) once and fills grad only when g(x) > 0, the return value.
+	 */
+	template<typename F, typename = void>
+	struct HasEvaluateActive : std::false_type {};
+
+	template<typename F>
+	struct HasEvaluateActive<F, typename detail::VoidT<
+		decltype(F::evaluate_active_sparse(
+			std::declval<const typename F::VectorT&>(),
+			std::declval<typename F::ValueType&>(),
+			std::declval<std::array<typename F::ValueType, F::Sparsity::Size>&>()
+		))
+	>::type> : std::true_type {};
+
+	/**
+	 * @brief value and gradient of F at one point.
+	 * Uses F::evaluate when F provides it, so shared subexpressions are computed once,
+	 * then F::evaluate_sparse scattered into a dense vector,
+	 * otherwise falls back to separate F::apply / F::gradient calls.
+	 * The overloads taking const F& call through the object, so an objective
+	 * may keep its state (e.g. r[k]) in members instead of statics.
+	 */
+	template<typename F, bool Fused = HasEvaluate<F>::value, bool Sparse = HasSparsity<F>::value>
+	struct Evaluator {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+
+		static void evaluate(const VectorT& x, ValueType& value, VectorT& grad) {
+			F::evaluate(x, value, grad);
+		}
+
+		static void evaluate(const F& f, const VectorT& x, ValueType& value, VectorT& grad) {
+			f.evaluate(x, value, grad);
+		}
+
+		/**
+		 * gi(x) and its gradient, returns true when gi(x) > 0.
+		 * grad is only meaningful for an active constraint.
+		 */
+		static bool evaluate_active(const VectorT& x, ValueType& value, VectorT& grad) {
+			F::evaluate(x, value, grad);
+			return value > 0;
+		}
+	};
+
+	template<typename F>
+	struct Evaluator<F, false, true> {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+		using SparseVectorT = std::array<ValueType, F::Sparsity::Size>;
+
+		static void evaluate(const VectorT& x, ValueType& value, VectorT& grad) {
+			SparseVectorT sparseGrad;
+			F::evaluate_sparse(x, value, sparseGrad);
+			grad.fill(ValueType());
+			F::Sparsity::scatter(ValueType(1), sparseGrad, grad);
+		}
+
+		static void evaluate(const F&, const VectorT& x, ValueType& value, VectorT& grad) {
+			evaluate(x, value, grad);
+		}
+
+		static bool evaluate_active(const VectorT& x, ValueType& value, VectorT& grad) {
+			evaluate(x, value, grad);
+			return value > 0;
+		}
+	};
+
+	template<typename F>
+	struct Evaluator<F, false, false> {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+
+		static void evaluate(const VectorT& x, ValueType& value, VectorT& grad) {
+			value = F::apply(x);
+			grad = F::gradient(x);
+		}
+
+		static void evaluate(const F& f, const VectorT& x, ValueType& value, VectorT& grad) {
+			value = f.apply(x);
+			grad = f.gradient(x);
+		}
+
+		static bool evaluate_active(const VectorT& x, ValueType& value, VectorT& grad) {
+			value = F::apply(x);
+
+			if (value > 0) {
+				grad = F::gradient(x);
+				return true;
+			}
+
+			return false;
+		}
+	};
+
+	/**
+	 * @brief constraint evaluation for the penalty sum.
+	 * The gradient of a sparse gi holds only its Sparsity::Size entries and
+	 * is scattered into the accumulator, so the cost of grad( alpha(x) )
+	 * scales with the total number of nonzeros instead of constraints x N.
+	 * Dense constraints go through Evaluator and touch all N entries.
+	 */
+	template<typename G, bool Sparse = HasSparsity<G>::value>
+	struct SparseEvaluator {
+		using ValueType = typename G::ValueType;
+		using VectorT	= typename G::VectorT;
+		using GradientT = std::array<ValueType, G::Sparsity::Size>;
+
+		static void evaluate(const VectorT& x, ValueType& value, GradientT& grad) {
+			G::evaluate_sparse(x, value, grad);
+		}
+
+		/**
+		 * gi(x) is computed once: G::evaluate_active_sparse skips the gradient of an
+		 * inactive constraint, otherwise G::evaluate_sparse yields value and gradient in one pass.
+		 */
+		static bool evaluate_active(const VectorT& x, ValueType& value, GradientT& grad) {
+			return evaluate_active(x, value, grad, std::integral_constant<bool, HasEvaluateActive<G>::value>());
+		}
+
+		static void scatter(ValueType coef, const GradientT& grad, VectorT& acc) {
+			G::Sparsity::scatter(coef, grad, acc);
+		}
+
+		template<typename MatrixT>
+		static void scatter_outer(ValueType coef, const GradientT& grad, MatrixT& H) {
+			G::Sparsity::scatter_outer(coef, grad, H);
+		}
+
+		static ValueType dot(const GradientT& grad, const VectorT& v) {
+			return G::Sparsity::dot(grad, v);
+		}
+
+	private:
+		static bool evaluate_active(const VectorT& x, ValueType& value, GradientT& grad, std::true_type) {
+			return G::evaluate_active_sparse(x, value, grad);
+		}
+
+		static bool evaluate_active(const VectorT& x, ValueType& value, GradientT& grad, std::false_type) {
+			G::evaluate_sparse(x, value, grad);
+			return value > 0;
+		}
+	};
+
+	template<typename G>
+	struct SparseEvaluator<G, false> {
+		using ValueType = typename G::ValueType;
+		using VectorT	= typename G::VectorT;
+		using GradientT = VectorT;
+
+		static void evaluate(const VectorT& x, ValueType& value, GradientT& grad) {
+			Evaluator<G>::evaluate(x, value, grad);
+		}
+
+		static bool evaluate_active(const VectorT& x, ValueType& value, GradientT& grad) {
+			return Evaluator<G>::evaluate_active(x, value, grad);
+		}
+
+		static void scatter(ValueType coef, const GradientT& grad, VectorT& acc) {
+			for (size_t idx = 0; idx < grad.size(); idx++)
+				acc[idx] += coef * grad[idx];
+		}
+
+		template<typename MatrixT>
+		static void scatter_outer(ValueType coef, const GradientT& grad, MatrixT& H) {
+			for (size_t j = 0; j < grad.size(); j++) {
+				ValueType row = coef * grad[j];
+
+				for (size_t k = 0; k < grad.size(); k++)
+					H(j, k) += row * grad[k];
+			}
+		}
+
+		static ValueType dot(const GradientT& grad, const VectorT& v) {
+			ValueType rval = ValueType();
+
+			for (size_t idx = 0; idx < grad.size(); idx++)
+				rval += grad[idx] * v[idx];
+
+			return rval;
+		}
+	};
+}// namespace tpr
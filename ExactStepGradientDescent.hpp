@@ -0,0 +1,100 @@
+#pragma once
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#include "Evaluator.hpp"
+#include "LineSearch.hpp"
+
+namespace tpr {
+	/**
+	 * @brief steepest descent with the step chosen by ExactLineSearch, drop-in replacement for StepSplitGradientDescent
+	 * when F provides ray(x, d, PenaltyRay&), i.e. a penalty with P = 2.
+	 * x[k+1] = x[k] - t[k] * grad( f( x[k] ) ), t[k] = argmin( F( x[k] - t * grad ) ) found by scanning the breakpoints
+	 * of the penalty along the ray instead of shrinking lambda by SplitDelta until it decreases enough.
+	 * The step is exact for linear gi (TrainingModel, the demand rows of subj_17 and subj_17_p4, CsrModel linear rows),
+	 * the chance constraints enter linearized and are backtracked when that overshoots.
+	 */
+	template< typename F,
+		typename IndexType = size_t
+	>
+	class ExactStepGradientDescent {
+	public: // == TYPES ==
+		using ValueType		= typename F::ValueType;
+		using VectorT		= typename F::VectorT;
+		using LineSearch	= ExactLineSearch<F, IndexType>;
+	public: // == CONSTANTS ==
+		static constexpr ValueType	Epsilon			= 1e-10;	//!< relative decrease of f( x ) to stop at
+		static constexpr ValueType	GradientEpsilon	= 1e-8;		//!< max | grad( f( x ) ) | to stop at
+		static constexpr IndexType	MaxIterations	= 100'000;
+		static constexpr ValueType	Lambda			= 1.0;		//!< length of a step along a ray the penalty does not bound
+	public:
+		static VectorT calculate(const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(F(), x0, lambda, it, evaluations);
+		}
+
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(f, x0, lambda, it, evaluations);
+		}
+
+		/**
+		 * @param f				objective, called through the object so it may carry state
+		 * @param lambda		in: length of a step along an unbounded ray, out: length of the last step
+		 * @param evaluations	incremented by the number of value + gradient evaluations and ray models
+		 */
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it, IndexType& evaluations) {
+			IndexType N = x0.size();// take num of vars from x0, runtime models have no F::N
+			VectorT currentXVec = x0;
+			VectorT gradientVec;
+			VectorT nextXVec;
+			VectorT nextGradientVec;
+			VectorT direction;
+			PenaltyRay<ValueType> ray;
+			ValueType currentValue = 0.0;
+			ValueType nextValue = 0.0;
+			const ValueType length = lambda;
+
+			Evaluator<F>::evaluate(f, currentXVec, currentValue, gradientVec);
+			evaluations++;
+			direction = gradientVec;
+
+			for (it = 0; it < MaxIterations; it++) {
+				ValueType gradientNorm = 0.0;
+				ValueType squaredNorm = 0.0;
+
+				for (IndexType idx = 0; idx < N; idx++) {
+					gradientNorm = std::max(gradientNorm, std::fabs(gradientVec[idx]));
+					squaredNorm += gradientVec[idx] * gradientVec[idx];
+					direction[idx] = -gradientVec[idx];
+				}
+
+				if (gradientNorm <= GradientEpsilon)
+					return currentXVec;
+
+				ValueType step = length / std::sqrt(squaredNorm);
+
+				// no decrease along -grad( f( x ) ) is representable, x[k] is as good as it gets
+				if (!LineSearch::search(f, currentXVec, currentValue, gradientVec, direction, step, ray,
+					nextXVec, nextValue, nextGradientVec, evaluations))
+					return currentXVec;
+
+				lambda = step * std::sqrt(squaredNorm);
+
+				ValueType diff = std::fabs(nextValue - currentValue);
+				ValueType scale = std::max(ValueType(1.0), std::max(std::fabs(nextValue), std::fabs(currentValue)));
+
+				currentXVec = nextXVec;
+				currentValue = nextValue;
+				gradientVec = nextGradientVec;
+
+				if (diff <= Epsilon * scale)
+					return currentXVec;
+			}// for
+
+			assert(0 && "Failed");
+			return currentXVec;
+		}
+	};
+}// namespace tpr
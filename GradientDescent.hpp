@@ -2,6 +2,11 @@
 #include <cmath>
 #include <cassert>
 #include <iostream>
+#include <limits>
+#include <algorithm>
+
+#include "Evaluator.hpp"
+#include "Bounds.hpp"
 
 namespace tpr {
 	/**
@@ -18,28 +23,61 @@ namespace tpr {
 		using VectorT	= typename F::VectorT;
 	public: // == CONSTANTS == 
 		static constexpr ValueType	Epsilon			= 0.1f;
+		static constexpr ValueType	GradientEpsilon	= 1e-6;		//!< max | P( x - grad( f( x ) ) ) - x | to stop at with a box
+		static constexpr IndexType	StallWindow		= 1'000;	//!< steps over which f has to drop by Epsilon with a box
 		static constexpr IndexType	MaxIterations	= 300'000;
 
 		static constexpr ValueType	SplitEps		= 0.1f;
 		static constexpr ValueType  SplitDelta		= 0.95f;
 		static constexpr ValueType  Lambda			= 0.0001f;
+		static constexpr bool		Projects		= true;		//!< keeps x inside the box of F, see Bounds.hpp
 		// less lambda matches constdescent
 		// static constexpr ValueType  Lambda                      = 0.00000001f
 	public:
 		static VectorT calculate( const VectorT& x0, ValueType& lambda, IndexType& it) {
-			IndexType N = F::N;// take num of vars from F
+			return calculate(F(), x0, lambda, it);
+		}
+
+		/**
+		 * @param f	objective, called through the object so it may carry state, e.g. r[k] of the penalty.
+		 *			With a box every step is projected, x[k+1] = P( x[k] - lambda[k] * grad( f( x[k] ) ) ),
+		 *			and the descent stops on max | P( x - grad ) - x | <= GradientEpsilon instead of | f( x[k+1] ) - f( x[k] ) | < Epsilon:
+		 *			a step cut short by a bound changes f little long before x is stationary.
+		 *			lambda then also grows by 1 / SplitDelta after each step taken in full, and the descent gives up
+		 *			once f drops by less than Epsilon over StallWindow steps, as on large ill-conditioned models.
+		 * @param it	number of steps, MaxIterations when a bounded descent ran out of them before it converged:
+		 *			f never rises, the x returned is the best one found.
+		 */
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType N = x0.size();// take num of vars from x0, runtime models have no F::N
+			const bool bounded = Projection<F>::active(f);
 			VectorT oldXVec;
 			VectorT currentXVec = x0;
+			VectorT gradientVec;
 			// || grad( f( x[k] ) )||^2
 			ValueType squaredNorm = 0.0f;
 			ValueType diff = 0.0f;
+			ValueType oldValue = 0.0f;
+			ValueType currentValue = 0.0f;
+			ValueType windowValue = std::numeric_limits<ValueType>::infinity();	// f( x ) StallWindow steps ago
 
 			for (it = 0; it < MaxIterations; it++) {
 				diff = 0.0f;
 				// save old value
 				oldXVec = currentXVec;
-				// evaluate gradient
-				VectorT gradientVec = F::gradient(currentXVec);
+				// evaluate f( x[k] ) and its gradient at once
+				Evaluator<F>::evaluate(f, currentXVec, oldValue, gradientVec);
+
+				if (bounded && Projection<F>::stationarity(f, currentXVec, gradientVec) <= GradientEpsilon)
+					return currentXVec;
+
+				if (bounded && it % StallWindow == 0) {
+					if (windowValue - oldValue < Epsilon)
+						return currentXVec;
+
+					windowValue = oldValue;
+				}
+
 				// evaluate new value
 				for (IndexType j = 0; j < N; j++)
 					currentXVec[j] = currentXVec[j] - lambda * gradientVec[j];
@@ -51,28 +89,68 @@ namespace tpr {
 
 				// select lambda from next condition:
 				// f( x[k+1] ) = f( x[k] ) - lambda[k] * grad(f[ x[ k ] ]) <= f(x[k]) - eps * lambda[k] * || grad( f( x[k] ) )|| ^ 2
-				
+				// with bounds || grad || is the projected one, || x[k+1] - x[k] || / lambda[k]
+				ValueType stepNorm = bounded ? Project(f, oldXVec, currentXVec, lambda) : squaredNorm;
+				currentValue = f.apply(currentXVec);
+				bool split = false;
 
-				while (F::apply(currentXVec) > (F::apply(oldXVec) - SplitEps * lambda * squaredNorm) ) {
+				while (currentValue > (oldValue - SplitEps * lambda * stepNorm) ) {
+					split = true;
 					lambda = SplitDelta * lambda;
 					currentXVec = oldXVec;
 
 					for (IndexType j = 0; j < N; j++)
 						currentXVec[j] = currentXVec[j] - lambda * gradientVec[j];
+
+					if (bounded)
+						stepNorm = Project(f, oldXVec, currentXVec, lambda);
+
+					currentValue = f.apply(currentXVec);
 				}
 
-				diff = std::fabs(F::apply(currentXVec) - F::apply(oldXVec));
+				diff = std::fabs(currentValue - oldValue);
 				
-				if(diff < Epsilon)
+				if(!bounded && diff < Epsilon)
+					return currentXVec;
+
+				// the stationarity test needs x to reach the minimum, not only to slow down, so lambda grows back
+				if (bounded && !split)
+					lambda = lambda / SplitDelta;
+
+				// lambda split down to where x no longer moves, x[k] is as good as it gets
+				if (currentXVec == oldXVec)
 					return currentXVec;
 
 			}// for
 
-			assert(0 && "Failed");
+			assert(bounded && "Failed");
 			return currentXVec;
 		}
+
+	private:
+		/**
+		 * x = P( x ), returns || x - from ||^2 / lambda^2
+		 */
+		static ValueType Project(const F& f, const VectorT& from, VectorT& x, ValueType lambda) {
+			ValueType rval = 0.0f;
+			Projection<F>::project(f, x);
+
+			for (IndexType j = 0; j < x.size(); j++)
+				rval += (x[j] - from[j]) * (x[j] - from[j]);
+
+			return rval / (lambda * lambda);
+		}
 	};
 
+	/**
+	 * steepest descent, x[k+1] = x[k] - lambda[k] * grad( f( x[k] ) ), lambda[k] = argmin( f( x[k] - lambda * grad( f( x[k] ) ) ) ).
+	 * The minimum along the ray is first bracketed, starting from the previous lambda and growing or shrinking it
+	 * by the golden ratio, then located by Brent's method to a tolerance relative to lambda itself.
+	 * With a box the search runs along the projected path P( x[k] - lambda * grad( f( x[k] ) ) ) and the descent stops
+	 * on max | P( x - grad ) - x | <= GradientEpsilon or once f drops by less than Epsilon over StallWindow steps,
+	 * without one on | f( x[k+1] ) - f( x[k] ) | <= Epsilon.
+	 * Brent, "Algorithms for minimization without derivatives", ch. 5; Press et al. "Numerical Recipes", 10.1 - 10.2.
+	 */
 	template< typename F,
 		typename IndexType = size_t
 	>
@@ -82,57 +160,159 @@ namespace tpr {
 			using VectorT = typename F::VectorT;
 		public: // == CONSTANTS == 
 			static constexpr ValueType	Epsilon = 0.1;
+			static constexpr ValueType	GradientEpsilon = 1e-6;	//!< max | P( x - grad( f( x ) ) ) - x | to stop at with a box
+			static constexpr IndexType	StallWindow = 100;		//!< steps over which f has to drop by Epsilon with a box
 			static constexpr IndexType	MaxIterations = 100'000;
 			static constexpr ValueType	SplitEps = 0.1f;
 			static constexpr ValueType  SplitDelta = 0.95f;
 			static constexpr ValueType  Lambda = 1.0f;
+			static constexpr ValueType	Golden = 1.6180339887;
+			static constexpr IndexType	MaxBracket = 64;		//!< golden growths or shrinks of lambda while bracketing
+			static constexpr IndexType	MaxBrent = 100;
+			static constexpr ValueType	StepEpsilon = 1e-6;		//!< tolerance of Brent's method, relative to lambda
+			static constexpr bool		Projects = true;		//!< keeps x inside the box of F, see Bounds.hpp
 		public:
-			static ValueType MakeSimplefx(ValueType x, const VectorT& grad, const VectorT& xj) {
-				VectorT buffer;
+			static ValueType MakeSimplefx(const F& f, ValueType x, const VectorT& grad, const VectorT& xj) {
+				VectorT buffer = xj;
 
 				for (IndexType idx = 0; idx < grad.size(); idx++) {
 					buffer[ idx ] = xj[ idx ] - x * grad[ idx ];
 				}
 				
+				Projection<F>::project(f, buffer);
 
-				return F::apply(buffer);
+				return f.apply(buffer);
 			}
 
-			static ValueType GoldenSelsction(ValueType a, ValueType b, ValueType eps, const VectorT& gradient, const VectorT& x) {
-				const ValueType fi = 1.6180339887;
-				ValueType x1, x2;
-				ValueType y1, y2;
+			/**
+			 * finds a < b < c with f( b ) below f( a ) and f( c ) along x - lambda * gradient, a starts at 0 with f( a ) = fa.
+			 * b starts at the given guess, is shrunk until f decreases and then c grows until f increases again.
+			 * @return false when no decrease is found down to MaxBracket shrinks,
+			 * when f keeps decreasing over MaxBracket growths b is left at the furthest point and c == b
+			 */
+			static bool Bracket(const F& f, const VectorT& gradient, const VectorT& x, ValueType fa,
+				ValueType& a, ValueType& b, ValueType& c, ValueType& fb
+			) {
+				a = 0;
+				fb = MakeSimplefx(f, b, gradient, x);
+				c = b;
+				ValueType fc = fb;
+				IndexType count = 0;
 
-				x1 = b - ((b - a) / fi);
-				x2 = a + ((b - a) / fi);
-				y1 = MakeSimplefx(x1, gradient, x);
-				y2 = MakeSimplefx(x2, gradient, x);
-				
-				while (std::abs(b - a) > eps){
-					if (y1 <= y2)
-					{
-						b = x2;
-						x2 = x1;
-						x1 = b - ((b - a) / fi);
-						y2 = y1;
-						y1 = MakeSimplefx(x1, gradient, x);
+				while (!(fb < fa)) {
+					if (++count > MaxBracket)
+						return false;
+
+					c = b;
+					fc = fb;
+					b = c / (Golden * Golden);
+					fb = MakeSimplefx(f, b, gradient, x);
+				}
+
+				if (c > b)
+					return true;// shrunk, f( c ) >= f( a ) > f( b )
+
+				for (count = 0; count < MaxBracket; count++) {
+					c = b + Golden * (b - a);
+					fc = MakeSimplefx(f, c, gradient, x);
+
+					if (!(fc < fb))
+						return true;
+
+					a = b;
+					b = c;
+					fb = fc;
+				}
+
+				// f decreases as far as we looked, take the furthest point
+				c = b;
+				return true;
+			}
+
+			/**
+			 * Brent's method on [a, c] around b from Bracket, parabolic steps where they behave, golden section otherwise.
+			 * @param fb	in: f( b ), out: f at the returned lambda
+			 */
+			static ValueType Brent(const F& f, const VectorT& gradient, const VectorT& x, ValueType a, ValueType b, ValueType c, ValueType& fb) {
+				const ValueType ratio = 1 - 1 / Golden;
+				ValueType lo = std::min(a, c), hi = std::max(a, c);
+				ValueType v = b, w = b, u = b;
+				ValueType fv = fb, fw = fb, fu = fb;
+				ValueType d = 0, e = 0;
+
+				for (IndexType it = 0; it < MaxBrent; it++) {
+					const ValueType mid = (lo + hi) / 2;
+					const ValueType tol = StepEpsilon * std::fabs(b) + std::numeric_limits<ValueType>::min();
+
+					if (std::fabs(b - mid) <= 2 * tol - (hi - lo) / 2)
+						break;
+
+					bool golden = true;
+
+					if (std::fabs(e) > tol) {
+						// parabola through b, w, v
+						ValueType r = (b - w) * (fb - fv);
+						ValueType q = (b - v) * (fb - fw);
+						ValueType p = (b - v) * q - (b - w) * r;
+						q = 2 * (q - r);
+
+						if (q > 0)
+							p = -p;
+
+						q = std::fabs(q);
+						const ValueType previous = e;
+						e = d;
+
+						// accept it only inside [lo, hi] and when it moves less than half the step before last
+						if (std::fabs(p) < std::fabs(q * previous / 2) && p > q * (lo - b) && p < q * (hi - b)) {
+							d = p / q;
+							u = b + d;
+
+							if (u - lo < 2 * tol || hi - u < 2 * tol)
+								d = mid > b ? tol : -tol;
+
+							golden = false;
+						}
 					}
-					else
-					{
-						a = x1;
-						x1 = x2;
-						x2 = a + ((b - a) / fi);
-						y1 = y2;
-						y2 = MakeSimplefx(x2, gradient, x);
+
+					if (golden) {
+						e = b >= mid ? lo - b : hi - b;
+						d = ratio * e;
+					}
+
+					u = std::fabs(d) >= tol ? b + d : b + (d > 0 ? tol : -tol);
+					fu = MakeSimplefx(f, u, gradient, x);
+
+					if (fu <= fb) {
+						if (u >= b)
+							lo = b;
+						else
+							hi = b;
+
+						v = w; fv = fw;
+						w = b; fw = fb;
+						b = u; fb = fu;
+					} else {
+						if (u < b)
+							lo = u;
+						else
+							hi = u;
+
+						if (fu <= fw || w == b) {
+							v = w; fv = fw;
+							w = u; fw = fu;
+						} else if (fu <= fv || v == b || v == w) {
+							v = u; fv = fu;
+						}
 					}
 				}
 
-				return (a + b) / 2;
+				return b;
 			}
 
 			static VectorT CalculateXVec( const VectorT& x, const VectorT& gradient, ValueType lambda)
 			{
-				VectorT buffer;
+				VectorT buffer = x;
 				assert(buffer.size() == gradient.size());
 				
 				for (IndexType idx = 0; idx < buffer.size(); idx++) {
@@ -142,24 +322,51 @@ namespace tpr {
 				return buffer;
 			}
 
-			static VectorT calculate(const VectorT& x0, ValueType&, IndexType& it) {
-				IndexType N = F::N;// take num of vars from F
-				VectorT oldXVec;
+			static VectorT calculate(const VectorT& x0, ValueType& lambda, IndexType& it) {
+				return calculate(F(), x0, lambda, it);
+			}
+
+			/**
+			 * @param lambda	in: first guess of the step, out: last step
+			 * @param it		number of steps, MaxIterations when a bounded descent ran out of them before it converged:
+			 *					every step lowers f, the x returned is the best one found.
+			 */
+			static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it) {
+				const bool bounded = Projection<F>::active(f);
 				VectorT currentXVec = x0;
 				it = 0;
 
+				ValueType oldValue = 0.0f;
+				ValueType currentValue = 0.0f;
+				ValueType windowValue = std::numeric_limits<ValueType>::infinity();	// f( x ) StallWindow steps ago
+				VectorT grad;
+
 				do {
-					oldXVec = currentXVec;
-					VectorT grad = F::gradient(currentXVec);
-					ValueType lambda = GoldenSelsction(0, 0.05, Epsilon, grad, currentXVec);
+					Evaluator<F>::evaluate(f, currentXVec, oldValue, grad);
+
+					if (bounded && Projection<F>::stationarity(f, currentXVec, grad) <= GradientEpsilon)
+						return currentXVec;
+
+					if (bounded && it % StallWindow == 0) {
+						if (windowValue - oldValue < Epsilon)
+							return currentXVec;
+
+						windowValue = oldValue;
+					}
+
+					ValueType a, b = lambda, c;
+
+					// no decrease along -grad( f( x ) ) is representable, x[k] is as good as it gets
+					if (!Bracket(f, grad, currentXVec, oldValue, a, b, c, currentValue))
+						return currentXVec;
+
+					lambda = c > b ? Brent(f, grad, currentXVec, a, b, c, currentValue) : b;
 					currentXVec = CalculateXVec(currentXVec, grad, lambda);
+					Projection<F>::project(f, currentXVec);
 					it++;
-				} while (std::abs(F::apply(currentXVec) - F::apply(oldXVec)) > Epsilon && it < MaxIterations);
+				} while ((bounded || std::abs(currentValue - oldValue) > Epsilon) && it < MaxIterations);
 				
-				auto f1 = std::abs(F::apply(currentXVec) );
-				auto f2 = std::abs( F::apply(oldXVec) );
-				auto d = std::abs(f1 - f2);
-				assert(it < MaxIterations);
+				assert((bounded || it < MaxIterations) && "Failed");
 
 				return currentXVec;
 			}
@@ -179,25 +386,32 @@ namespace tpr {
 			static constexpr ValueType  Lambda = 0.00000001f;
 		public:
 			static VectorT calculate(const VectorT& x0, ValueType& lambda, IndexType& it) {
-				IndexType N = F::N;// take num of vars from F
+				return calculate(F(), x0, lambda, it);
+			}
+
+			static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it) {
+				IndexType N = x0.size();// take num of vars from x0, runtime models have no F::N
 				VectorT oldXVec;
 				VectorT currentXVec = x0;
 				ValueType diff = 0.0f;
 				ValueType oldDiff = 0.0f;
 
+				ValueType oldValue = 0.0f;
+				VectorT gradientVec;
+
 				for (it = 0; it < MaxIterations; it++) {
 					diff = 0.0f;
 					// save old value
 					oldXVec = currentXVec;
-					// evaluate gradient
-					VectorT gradientVec = F::gradient(currentXVec);
+					// evaluate f( x[k] ) and its gradient at once
+					Evaluator<F>::evaluate(f, currentXVec, oldValue, gradientVec);
 
 					// evaluate new value
 					for (IndexType j = 0; j < N; j++)
 						currentXVec[j] = currentXVec[j] - lambda * gradientVec[j];
 
 					// evaluate square of gradient norm
-					diff = std::fabs(F::apply(currentXVec) - F::apply(oldXVec));
+					diff = std::fabs(f.apply(currentXVec) - oldValue);
 					
 					//std::cerr << "diff = " << diff << std::endl;
 					if (diff < Epsilon )
@@ -210,4 +424,4 @@ namespace tpr {
 				return currentXVec;
 			}
 	};
-}// namespace tpr
\ No newline at end of file
+}// namespace tpr
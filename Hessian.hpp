@@ -0,0 +1,235 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+#include "Evaluator.hpp"
+
+namespace tpr {
+	/**
+	 * @brief dense N x N matrix, row major, sized at runtime so array and vector models share it.
+	 */
+	template<typename T>
+	class DenseMatrix {
+	public: // == TYPES ==
+		using ValueType = T;
+	private: // == MEMBERS ==
+		size_t			mSize = 0;
+		std::vector<T>	mData;
+	public: // == METHODS ==
+		DenseMatrix() = default;
+
+		explicit DenseMatrix(size_t n) : mSize(n), mData(n * n) {}
+
+		void resize(size_t n) {
+			mSize = n;
+			mData.resize(n * n);
+		}
+
+		void fill(T value) {
+			std::fill(mData.begin(), mData.end(), value);
+		}
+
+		size_t size() const {
+			return mSize;
+		}
+
+		T& operator()(size_t row, size_t col) {
+			return mData[row * mSize + col];
+		}
+
+		const T& operator()(size_t row, size_t col) const {
+			return mData[row * mSize + col];
+		}
+	};
+
+	/**
+	 * @brief detects the optional second derivatives of Fx/Gi types
+	 * static void add_hessian(const VectorT& x, ValueType coef, DenseMatrix<ValueType>& H);
+	 * H += coef * hessian( f( x ) ), a sparse gi only touches its Sparsity block.
+	 * A type without add_hessian is taken as linear: the rows of subj_17 demand constraints need nothing.
+	 */
+	template<typename F, typename = void>
+	struct HasHessian : std::false_type {};
+
+	template<typename F>
+	struct HasHessian<F, typename detail::VoidT<
+		decltype(F::add_hessian(
+			std::declval<const typename F::VectorT&>(),
+			std::declval<typename F::ValueType>(),
+			std::declval<DenseMatrix<typename F::ValueType>&>()
+		))
+	>::type> : std::true_type {};
+
+	template<typename F, bool Curved = HasHessian<F>::value>
+	struct HessianEvaluator {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+
+		static void accumulate(const VectorT& x, ValueType coef, DenseMatrix<ValueType>& H) {
+			F::add_hessian(x, coef, H);
+		}
+	};
+
+	template<typename F>
+	struct HessianEvaluator<F, false> {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+
+		static void accumulate(const VectorT&, ValueType, DenseMatrix<ValueType>&) {}
+	};
+
+	/**
+	 * @brief detects the optional Hessian-vector product of Fx/Gi types, the matrix-free form of add_hessian
+	 * static void add_hessian_vector(const VectorT& x, const VectorT& v, ValueType coef, VectorT& hv);
+	 * hv += coef * hessian( f( x ) ) * v. A type without it is taken as linear, as for add_hessian.
+	 */
+	template<typename F, typename = void>
+	struct HasHessianVector : std::false_type {};
+
+	template<typename F>
+	struct HasHessianVector<F, typename detail::VoidT<
+		decltype(F::add_hessian_vector(
+			std::declval<const typename F::VectorT&>(),
+			std::declval<const typename F::VectorT&>(),
+			std::declval<typename F::ValueType>(),
+			std::declval<typename F::VectorT&>()
+		))
+	>::type> : std::true_type {};
+
+	template<typename F, bool Curved = HasHessianVector<F>::value>
+	struct HessianVectorEvaluator {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+
+		static void accumulate(const VectorT& x, const VectorT& v, ValueType coef, VectorT& hv) {
+			F::add_hessian_vector(x, v, coef, hv);
+		}
+	};
+
+	template<typename F>
+	struct HessianVectorEvaluator<F, false> {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+
+		static void accumulate(const VectorT&, const VectorT&, ValueType, VectorT&) {}
+	};
+
+	/**
+	 * @brief Cholesky factorization H + tau * I = L * L' with tau >= 0 raised until it succeeds,
+	 * so the Newton direction -( H + tau * I )^-1 * g always descends.
+	 * Nocedal, Wright "Numerical Optimization", algorithm 3.3.
+	 */
+	template<typename T>
+	class ModifiedCholesky {
+	public: // == CONSTANTS ==
+		static constexpr T		MinShift		= 1e-3;		//!< first tau for an indefinite H, relative to its largest diagonal entry
+		static constexpr size_t	MaxAttempts		= 64;
+	private: // == MEMBERS ==
+		DenseMatrix<T>	mFactor;	//!< L, lower triangle
+		T				mShift = T();
+	public: // == METHODS ==
+		/**
+		 * @param minShift	lower bound of tau, a caller damping the step raises it
+		 * @return false when no tau below overflow gives a positive definite matrix, e.g. H holds NaN.
+		 */
+		bool factorize(const DenseMatrix<T>& H, T minShift = T()) {
+			const size_t n = H.size();
+			T minDiagonal = n > 0 ? H(0, 0) : T();
+
+			for (size_t idx = 0; idx < n; idx++)
+				minDiagonal = std::min(minDiagonal, H(idx, idx));
+
+			const T beta = MinShift * scale(H);
+			mShift = std::max(minShift, minDiagonal > 0 ? T() : beta - minDiagonal);
+
+			for (size_t attempt = 0; attempt < MaxAttempts; attempt++) {
+				if (Factorize(H, mShift))
+					return true;
+
+				mShift = std::max(2 * mShift, beta);
+			}
+
+			return false;
+		}
+
+		/**
+		 * x = ( H + tau * I )^-1 * b by forward and back substitution, x may alias b.
+		 */
+		template<typename VecT>
+		void solve(const VecT& b, VecT& x) const {
+			const size_t n = mFactor.size();
+			x = b;
+
+			for (size_t row = 0; row < n; row++) {
+				T sum = x[row];
+
+				for (size_t col = 0; col < row; col++)
+					sum -= mFactor(row, col) * x[col];
+
+				x[row] = sum / mFactor(row, row);
+			}
+
+			for (size_t row = n; row-- > 0;) {
+				T sum = x[row];
+
+				for (size_t col = row + 1; col < n; col++)
+					sum -= mFactor(col, row) * x[col];
+
+				x[row] = sum / mFactor(row, row);
+			}
+		}
+
+		/**
+		 * max( 1, max( | H[i][i] | ) ), the unit of tau
+		 */
+		static T scale(const DenseMatrix<T>& H) {
+			T maxDiagonal = T(1);
+
+			for (size_t idx = 0; idx < H.size(); idx++)
+				maxDiagonal = std::max(maxDiagonal, std::fabs(H(idx, idx)));
+
+			return maxDiagonal;
+		}
+
+		/**
+		 * tau of the last factorization, zero when H itself was positive definite
+		 */
+		T shift() const {
+			return mShift;
+		}
+
+	private:
+		bool Factorize(const DenseMatrix<T>& H, T shift) {
+			const size_t n = H.size();
+			mFactor.resize(n);
+
+			for (size_t col = 0; col < n; col++) {
+				T diagonal = H(col, col) + shift;
+
+				for (size_t k = 0; k < col; k++)
+					diagonal -= mFactor(col, k) * mFactor(col, k);
+
+				if (!(diagonal > 0) || !std::isfinite(diagonal))
+					return false;
+
+				diagonal = std::sqrt(diagonal);
+				mFactor(col, col) = diagonal;
+
+				for (size_t row = col + 1; row < n; row++) {
+					T sum = H(row, col);
+
+					for (size_t k = 0; k < col; k++)
+						sum -= mFactor(row, k) * mFactor(col, k);
+
+					mFactor(row, col) = sum / diagonal;
+				}
+			}
+
+			return true;
+		}
+	};
+}// namespace tpr
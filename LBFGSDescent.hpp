@@ -0,0 +1,183 @@
+#pragma once
+#include <cmath>
+#include <cassert>
+#include <array>
+#include <algorithm>
+
+#include "Evaluator.hpp"
+#include "LineSearch.hpp"
+#include "Bounds.hpp"
+
+namespace tpr {
+	/**
+	 * @brief limited memory BFGS, drop-in replacement for StepSplitGradientDescent.
+	 * Keeps the last Depth pairs
+	 * s[k] = x[k+1] - x[k], y[k] = grad( f( x[k+1] ) ) - grad( f( x[k] ) )
+	 * and applies the inverse Hessian approximation to grad( f( x[k] ) ) by the two-loop recursion,
+	 * the step length is chosen by WolfeLineSearch.
+	 * With a box the variables held at a bound by the gradient are left out of the direction, see Box::hold,
+	 * the step follows the projected path by ProjectedLineSearch and the descent stops on max | P( x - grad ) - x | <= GradientEpsilon.
+	 * Nocedal, Wright "Numerical Optimization", algorithms 7.4, 7.5.
+	 */
+	template< typename F,
+		typename IndexType = size_t,
+		size_t Depth = 8
+	>
+	class LBFGSDescent {
+	public: // == TYPES ==
+		using ValueType		= typename F::ValueType;
+		using VectorT		= typename F::VectorT;
+		using LineSearch	= WolfeLineSearch<F, IndexType>;
+		using BoxSearch		= ProjectedLineSearch<F, IndexType>;
+	public: // == CONSTANTS ==
+		static constexpr ValueType	Epsilon			= 1e-10;	//!< relative decrease of f( x ) to stop at
+		static constexpr ValueType	GradientEpsilon	= 1e-8;		//!< max | grad( f( x ) ) | to stop at
+		static constexpr IndexType	MaxIterations	= 10'000;
+		static constexpr ValueType	Curvature		= 0.9;		//!< c2 of the Wolfe conditions
+		static constexpr ValueType	Lambda			= 1.0;		//!< length of the first step along -grad( f( x0 ) )
+		static constexpr size_t		HistoryDepth	= Depth;	//!< number of stored ( s, y ) pairs
+		static constexpr bool		Projects		= true;		//!< keeps x inside the box of F, see Bounds.hpp
+	public:
+		static VectorT calculate(const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(F(), x0, lambda, it, evaluations);
+		}
+
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(f, x0, lambda, it, evaluations);
+		}
+
+		/**
+		 * @param f				objective, called through the object so it may carry state
+		 * @param lambda		in: length of the first step, out: last accepted step
+		 * @param evaluations	incremented by the number of value + gradient evaluations, line search included
+		 */
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it, IndexType& evaluations) {
+			IndexType N = x0.size();// take num of vars from x0, runtime models have no F::N
+			const bool bounded = Projection<F>::active(f);
+			std::array<VectorT, Depth> sHistory;
+			std::array<VectorT, Depth> yHistory;
+			sHistory.fill(x0);
+			yHistory.fill(x0);
+			std::array<ValueType, Depth> rho;
+			std::array<ValueType, Depth> alpha;
+			size_t head = 0;	// slot for the next pair
+			size_t count = 0;	// stored pairs
+			VectorT currentXVec = x0;
+			VectorT gradientVec;
+			VectorT freeGradientVec;	// grad( f( x ) ) without the components held at a bound
+			VectorT nextXVec;
+			VectorT nextGradientVec;
+			VectorT direction;
+			ValueType currentValue = 0.0;
+			ValueType nextValue = 0.0;
+
+			Projection<F>::project(f, currentXVec);
+			Evaluator<F>::evaluate(f, currentXVec, currentValue, gradientVec);
+			evaluations++;
+
+			for (it = 0; it < MaxIterations; it++) {
+				if (Projection<F>::stationarity(f, currentXVec, gradientVec) <= GradientEpsilon)
+					return currentXVec;
+
+				freeGradientVec = gradientVec;
+				Projection<F>::hold(f, currentXVec, gradientVec, freeGradientVec);
+
+				// direction = -H[k] * grad( f( x[k] ) )
+				direction = freeGradientVec;
+
+				for (size_t k = 0; k < count; k++) {
+					size_t i = (head + Depth - 1 - k) % Depth;
+					alpha[i] = rho[i] * LineSearch::Dot(sHistory[i], direction);
+
+					for (IndexType j = 0; j < N; j++)
+						direction[j] -= alpha[i] * yHistory[i][j];
+				}
+
+				ValueType step = 1.0;
+
+				if (count > 0) {
+					// H0 = gamma * I, gamma = s' * y / y' * y of the latest pair
+					size_t last = (head + Depth - 1) % Depth;
+					ValueType gamma = LineSearch::Dot(sHistory[last], yHistory[last]) / LineSearch::Dot(yHistory[last], yHistory[last]);
+
+					for (IndexType j = 0; j < N; j++)
+						direction[j] *= gamma;
+				} else {
+					step = lambda / std::sqrt(LineSearch::Dot(freeGradientVec, freeGradientVec));
+				}
+
+				for (size_t k = count; k-- > 0;) {
+					size_t i = (head + Depth - 1 - k) % Depth;
+					ValueType beta = rho[i] * LineSearch::Dot(yHistory[i], direction);
+
+					for (IndexType j = 0; j < N; j++)
+						direction[j] += (alpha[i] - beta) * sHistory[i][j];
+				}
+
+				for (IndexType j = 0; j < N; j++)
+					direction[j] = -direction[j];
+
+				Projection<F>::hold(f, currentXVec, gradientVec, direction);
+				bool found = bounded
+					? BoxSearch::search(f, currentXVec, currentValue, gradientVec, direction, step, nextXVec, nextValue, nextGradientVec, evaluations)
+					: LineSearch::search(f, currentXVec, currentValue, gradientVec, direction, step, Curvature,
+						nextXVec, nextValue, nextGradientVec, evaluations);
+
+				if (!found) {
+					// the curvature pairs went stale, restart from steepest descent
+					if (count > 0) {
+						count = 0;
+						continue;
+					}
+
+					// no decrease along -grad( f( x ) ) is representable, x[k] is as good as it gets
+					return currentXVec;
+				}
+
+				lambda = step;
+
+				VectorT& s = sHistory[head];
+				VectorT& y = yHistory[head];
+
+				for (IndexType j = 0; j < N; j++) {
+					s[j] = nextXVec[j] - currentXVec[j];
+					y[j] = nextGradientVec[j] - gradientVec[j];
+				}
+
+				ValueType sy = LineSearch::Dot(s, y);
+
+				// the Wolfe curvature condition keeps s' * y > 0, skip the pair if rounding or a bound broke it
+				if (sy > 1e-16 * LineSearch::Dot(y, y)) {
+					rho[head] = 1.0 / sy;
+					head = (head + 1) % Depth;
+					count = std::min(count + 1, Depth);
+				}
+
+				ValueType diff = std::fabs(nextValue - currentValue);
+				ValueType scale = std::max(ValueType(1.0), std::max(std::fabs(nextValue), std::fabs(currentValue)));
+
+				currentXVec = nextXVec;
+				currentValue = nextValue;
+				gradientVec = nextGradientVec;
+
+				if (diff <= Epsilon * scale)
+					return currentXVec;
+			}// for
+
+			assert(0 && "Failed");
+			return currentXVec;
+		}
+	};
+
+	/**
+	 * binds the history depth, so that LBFGSDescent fits a template<typename F, typename IndexType> class parameter:
+	 * PF::evaluate< LBFGS<16>::Descent >( x0 );
+	 */
+	template<size_t Depth>
+	struct LBFGS {
+		template<typename F, typename IndexType = size_t>
+		using Descent = LBFGSDescent<F, IndexType, Depth>;
+	};
+}// namespace tpr
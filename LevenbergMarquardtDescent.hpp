@@ -0,0 +1,141 @@
+#pragma once
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#include "Evaluator.hpp"
+#include "Hessian.hpp"
+#include "LineSearch.hpp"
+
+namespace tpr {
+	/**
+	 * @brief Levenberg-Marquardt method on the Gauss-Newton matrix, drop-in replacement for StepSplitGradientDescent when F provides
+	 * void gauss_newton(const VectorT& x, MatrixT& H) const;	// MatrixT = DenseMatrix<ValueType>
+	 * as PenaltyFunction::FxRkFunction does: H = hessian( f(x) ) + r[k] * J' * J over the active gi.
+	 * With P = 2 the penalty is a sum of squared residuals max( 0, gi(x) ), J' * J is built from the gi gradients
+	 * the descent evaluates anyway, and equals the exact hessian for linear gi.
+	 * d[k] = -( H[k] + mu[k] * I )^-1 * grad( f( x[k] ) ) is taken without a line search: the gain ratio
+	 * rho = ( F( x[k] ) - F( x[k] + d[k] ) ) / ( m( 0 ) - m( d[k] ) ) of the actual to the predicted decrease
+	 * accepts or rejects it and updates mu (Nielsen), small mu is a Gauss-Newton step, large mu a short steepest descent step.
+	 * mu starts at zero, so on a quadratic f with linear gi the first steps are Newton steps.
+	 * The matrix is dense and factorized in O(N^3), as in NewtonDescent.
+	 * Madsen, Nielsen, Tingleff "Methods for non-linear least squares problems", algorithm 3.16.
+	 */
+	template< typename F,
+		typename IndexType = size_t
+	>
+	class LevenbergMarquardtDescent {
+	public: // == TYPES ==
+		using ValueType		= typename F::ValueType;
+		using VectorT		= typename F::VectorT;
+		using MatrixT		= DenseMatrix<ValueType>;
+		using LineSearch	= WolfeLineSearch<F, IndexType>;
+	public: // == CONSTANTS ==
+		static constexpr ValueType	Epsilon			= 1e-10;	//!< relative decrease of f( x ) to stop at
+		static constexpr ValueType	GradientEpsilon	= 1e-8;		//!< max | grad( f( x ) ) | to stop at
+		static constexpr IndexType	MaxIterations	= 1'000;
+		static constexpr ValueType	Lambda			= 1.0;		//!< unused, the step is always 1
+	public:
+		static VectorT calculate(const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(F(), x0, lambda, it, evaluations);
+		}
+
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(f, x0, lambda, it, evaluations);
+		}
+
+		/**
+		 * @param f				objective, called through the object so it may carry state
+		 * @param lambda		out: length of the last accepted step
+		 * @param evaluations	incremented by the number of value + gradient evaluations
+		 */
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it, IndexType& evaluations) {
+			IndexType N = x0.size();// take num of vars from x0, runtime models have no F::N
+			VectorT currentXVec = x0;
+			VectorT gradientVec;
+			VectorT nextXVec;
+			VectorT nextGradientVec;
+			VectorT direction;
+			MatrixT matrix;
+			ModifiedCholesky<ValueType> factor;
+			ValueType currentValue = 0.0;
+			ValueType nextValue = 0.0;
+			ValueType mu = 0.0;		// a Gauss-Newton step first, damped once a step fails
+			ValueType nu = 2.0;		// growth of mu after consecutive rejections
+			bool fresh = true;		// H[k] is not built for x[k] yet
+
+			Evaluator<F>::evaluate(f, currentXVec, currentValue, gradientVec);
+			evaluations++;
+
+			for (it = 0; it < MaxIterations; it++) {
+				ValueType gradientNorm = 0.0;
+
+				for (IndexType idx = 0; idx < N; idx++)
+					gradientNorm = std::max(gradientNorm, std::fabs(gradientVec[idx]));
+
+				if (gradientNorm <= GradientEpsilon)
+					return currentXVec;
+
+				if (fresh) {
+					f.gauss_newton(currentXVec, matrix);
+					fresh = false;
+				}
+
+				// no mu below overflow gives a finite step, H holds NaN
+				if (!factor.factorize(matrix, mu))
+					return currentXVec;
+
+				factor.solve(gradientVec, direction);
+				ValueType length = 0.0;	// d' * d
+				nextXVec = currentXVec;
+
+				for (IndexType j = 0; j < N; j++) {
+					direction[j] = -direction[j];
+					nextXVec[j] += direction[j];
+					length += direction[j] * direction[j];
+				}
+
+				// m( 0 ) - m( d ) = ( mu * d' * d - g' * d ) / 2, mu as ModifiedCholesky raised it
+				const ValueType predicted = (factor.shift() * length - LineSearch::Dot(gradientVec, direction)) / 2;
+				Evaluator<F>::evaluate(f, nextXVec, nextValue, nextGradientVec);
+				evaluations++;
+
+				const ValueType actual = currentValue - nextValue;
+
+				if (!(predicted > 0 && actual > 0)) {
+					// x[k] + d[k] is no better, retry closer to steepest descent
+					mu = std::max(nu * factor.shift(), ModifiedCholesky<ValueType>::MinShift * ModifiedCholesky<ValueType>::scale(matrix));
+					nu *= 2;
+
+					// no decrease is representable along any d, x[k] is as good as it gets
+					if (!(length > 0) || !std::isfinite(mu))
+						return currentXVec;
+
+					continue;
+				}
+
+				const ValueType rho = actual / predicted;
+				const ValueType cube = 2 * rho - 1;
+				mu = factor.shift() * std::max(ValueType(1.0 / 3.0), 1 - cube * cube * cube);
+				nu = 2.0;
+				lambda = std::sqrt(length);
+
+				ValueType diff = std::fabs(nextValue - currentValue);
+				ValueType scale = std::max(ValueType(1.0), std::max(std::fabs(nextValue), std::fabs(currentValue)));
+
+				currentXVec = nextXVec;
+				currentValue = nextValue;
+				gradientVec = nextGradientVec;
+				fresh = true;
+
+				if (diff <= Epsilon * scale)
+					return currentXVec;
+			}// for
+
+			assert(0 && "Failed");
+			return currentXVec;
+		}
+	};
+}// namespace tpr
@@ -0,0 +1,416 @@
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "Evaluator.hpp"
+#include "Bounds.hpp"
+
+namespace tpr {
+	/**
+	 * @brief line search satisfying the strong Wolfe conditions
+	 * phi(a) = f( x + a * d )
+	 * phi(a) <= phi(0) + C1 * a * phi'(0)		- sufficient decrease
+	 * |phi'(a)| <= -c2 * phi'(0)				- curvature
+	 *
+	 * Bracketing phase followed by zoom with safeguarded cubic interpolation,
+	 * Nocedal, Wright "Numerical Optimization", algorithms 3.5, 3.6.
+	 * Every trial point costs one fused evaluation of value and gradient.
+	 */
+	template< typename F,
+		typename IndexType = size_t
+	>
+	class WolfeLineSearch {
+	public: // == TYPES ==
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+	public: // == CONSTANTS ==
+		static constexpr ValueType	C1				= 1e-4;		//!< sufficient decrease
+		static constexpr ValueType	Expansion		= 2.0;		//!< step growth while bracketing
+		static constexpr ValueType	MaxStep			= 1e10;
+		static constexpr IndexType	MaxIterations	= 40;		//!< trial points per search
+	public:
+		/**
+		 * @param f			objective, called through the object
+		 * @param x			start point
+		 * @param f0		f( x )
+		 * @param g0		grad( f( x ) )
+		 * @param d			descent direction, grad( f( x ) ) * d < 0
+		 * @param alpha		in: first trial step, out: accepted step
+		 * @param c2		curvature constant, 0.9 for quasi-Newton, 0.1 for conjugate gradients
+		 * @param xOut, fOut, gOut	accepted point, its value and gradient
+		 * @param evaluations		incremented by the number of trial points
+		 * @return false if no step with sufficient decrease was found, outputs are untouched then.
+		 */
+		static bool search(const F& f, const VectorT& x, ValueType f0, const VectorT& g0, const VectorT& d,
+			ValueType& alpha, ValueType c2,
+			VectorT& xOut, ValueType& fOut, VectorT& gOut, IndexType& evaluations
+		) {
+			const ValueType dphi0 = Dot(g0, d);
+
+			if (!(dphi0 < 0))
+				return false;
+
+			ValueType aPrev = 0.0;
+			ValueType fPrev = f0;
+			ValueType dphiPrev = dphi0;
+			ValueType a = alpha;
+			VectorT xa = x, ga = g0;
+			ValueType fa = 0.0;
+
+			for (IndexType i = 0; i < MaxIterations; i++) {
+				Trial(f, x, d, a, xa, fa, ga);
+				evaluations++;
+				ValueType dphia = Dot(ga, d);
+
+				if (!std::isfinite(fa) || fa > f0 + C1 * a * dphi0 || (i > 0 && fa >= fPrev))
+					return Zoom(f, x, f0, dphi0, d, c2, aPrev, fPrev, dphiPrev, a, fa, dphia, alpha, xOut, fOut, gOut, evaluations);
+
+				if (std::fabs(dphia) <= -c2 * dphi0) {
+					alpha = a;
+					xOut = xa;
+					fOut = fa;
+					gOut = ga;
+					return true;
+				}
+
+				if (dphia >= 0)
+					return Zoom(f, x, f0, dphi0, d, c2, a, fa, dphia, aPrev, fPrev, dphiPrev, alpha, xOut, fOut, gOut, evaluations);
+
+				aPrev = a;
+				fPrev = fa;
+				dphiPrev = dphia;
+				a = std::min(a * Expansion, ValueType(MaxStep));
+			}
+
+			// still decreasing at the largest step we were allowed to try
+			alpha = aPrev;
+			xOut = xa;
+			fOut = fa;
+			gOut = ga;
+			return aPrev > 0;
+		}
+
+		static ValueType Dot(const VectorT& a, const VectorT& b) {
+			ValueType rval = 0.0;
+
+			for (IndexType idx = 0; idx < a.size(); idx++)
+				rval += a[idx] * b[idx];
+
+			return rval;
+		}
+
+	private:
+		static void Trial(const F& f, const VectorT& x, const VectorT& d, ValueType a, VectorT& xa, ValueType& fa, VectorT& ga) {
+			for (IndexType idx = 0; idx < x.size(); idx++)
+				xa[idx] = x[idx] + a * d[idx];
+
+			Evaluator<F>::evaluate(f, xa, fa, ga);
+		}
+
+		/**
+		 * minimizer of the cubic interpolating phi, phi' at a and b,
+		 * falls back to bisection when it lands outside the safeguarded interval.
+		 */
+		static ValueType Interpolate(ValueType a, ValueType fa, ValueType dfa, ValueType b, ValueType fb, ValueType dfb) {
+			const ValueType lo = std::min(a, b);
+			const ValueType hi = std::max(a, b);
+			const ValueType margin = 0.1 * (hi - lo);
+			ValueType d1 = dfa + dfb - 3.0 * (fa - fb) / (a - b);
+			ValueType disc = d1 * d1 - dfa * dfb;
+
+			if (disc >= 0) {
+				ValueType d2 = (b > a ? 1.0 : -1.0) * std::sqrt(disc);
+				ValueType t = b - (b - a) * (dfb + d2 - d1) / (dfb - dfa + 2.0 * d2);
+
+				if (std::isfinite(t) && t >= lo + margin && t <= hi - margin)
+					return t;
+			}
+
+			return 0.5 * (a + b);
+		}
+
+		static bool Zoom(const F& f, const VectorT& x, ValueType f0, ValueType dphi0, const VectorT& d, ValueType c2,
+			ValueType aLo, ValueType fLo, ValueType dLo,
+			ValueType aHi, ValueType fHi, ValueType dHi,
+			ValueType& alpha, VectorT& xOut, ValueType& fOut, VectorT& gOut, IndexType& evaluations
+		) {
+			VectorT xa = x, ga = x;
+			VectorT xLo, gLo;
+			bool hasLo = false;
+			ValueType fa = 0.0;
+
+			for (IndexType i = 0; i < MaxIterations; i++) {
+				ValueType a = Interpolate(aLo, fLo, dLo, aHi, std::isfinite(fHi) ? fHi : fLo, dHi);
+				Trial(f, x, d, a, xa, fa, ga);
+				evaluations++;
+				ValueType dphia = Dot(ga, d);
+
+				if (!std::isfinite(fa) || fa > f0 + C1 * a * dphi0 || fa >= fLo) {
+					aHi = a;
+					fHi = fa;
+					dHi = dphia;
+				} else {
+					if (std::fabs(dphia) <= -c2 * dphi0) {
+						alpha = a;
+						xOut = xa;
+						fOut = fa;
+						gOut = ga;
+						return true;
+					}
+
+					if (dphia * (aHi - aLo) >= 0) {
+						aHi = aLo;
+						fHi = fLo;
+						dHi = dLo;
+					}
+
+					aLo = a;
+					fLo = fa;
+					dLo = dphia;
+					xLo = xa;
+					gLo = ga;
+					hasLo = true;
+				}
+
+				if (std::fabs(aHi - aLo) <= 1e-14 * std::max(ValueType(1.0), std::fabs(aLo)))
+					break;
+			}
+
+			// interval collapsed: settle for the best point with sufficient decrease
+			if (hasLo) {
+				alpha = aLo;
+				xOut = xLo;
+				fOut = fLo;
+				gOut = gLo;
+				return true;
+			}
+
+			return false;
+		}
+	};
+
+	/**
+	 * @brief backtracking along the projected path x(a) = P( x + a * d ) on the box of F
+	 * f( x(a) ) <= f( x ) + C1 * grad( f( x ) )' * ( x(a) - x )	- sufficient decrease
+	 * The path bends where a variable reaches its bound, phi' jumps there and the curvature condition
+	 * of WolfeLineSearch means nothing, so only the decrease is checked and a rejected step shrinks
+	 * by safeguarded quadratic interpolation as in ExactLineSearch.
+	 * Bertsekas, "Projected Newton methods for optimization problems with simple constraints", 1982.
+	 */
+	template< typename F,
+		typename IndexType = size_t
+	>
+	class ProjectedLineSearch {
+	public: // == TYPES ==
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+	public: // == CONSTANTS ==
+		static constexpr ValueType	C1				= 1e-4;		//!< sufficient decrease
+		static constexpr IndexType	MaxIterations	= 40;		//!< backtracking steps per search
+	public:
+		/**
+		 * @param alpha		in: first trial step, out: accepted step
+		 * @return false if no step with sufficient decrease was found, or P( x + a * d ) no longer leaves x.
+		 * The other parameters are those of WolfeLineSearch::search.
+		 */
+		static bool search(const F& f, const VectorT& x, ValueType f0, const VectorT& g0, const VectorT& d,
+			ValueType& alpha, VectorT& xOut, ValueType& fOut, VectorT& gOut, IndexType& evaluations
+		) {
+			const ValueType dphi0 = WolfeLineSearch<F, IndexType>::Dot(g0, d);
+
+			if (!(dphi0 < 0))
+				return false;
+
+			ValueType a = alpha;
+			xOut = x;
+
+			for (IndexType i = 0; i < MaxIterations; i++) {
+				ValueType decrease = 0.0;	// grad( f( x ) )' * ( x(a) - x )
+
+				for (IndexType idx = 0; idx < x.size(); idx++)
+					xOut[idx] = x[idx] + a * d[idx];
+
+				Projection<F>::project(f, xOut);
+
+				for (IndexType idx = 0; idx < x.size(); idx++)
+					decrease += g0[idx] * (xOut[idx] - x[idx]);
+
+				if (!(decrease < 0))
+					return false;
+
+				Evaluator<F>::evaluate(f, xOut, fOut, gOut);
+				evaluations++;
+
+				if (std::isfinite(fOut) && fOut <= f0 + C1 * decrease) {
+					alpha = a;
+					return true;
+				}
+
+				// minimizer of the quadratic through phi(0), phi'(0) and phi(a) of the unbent ray, kept within [ a / 10, a / 2 ]
+				ValueType next = std::isfinite(fOut) ? -dphi0 * a * a / (2 * (fOut - f0 - dphi0 * a)) : a / 2;
+				a = std::min(std::max(next, a / 10), a / 2);
+			}
+
+			return false;
+		}
+	};
+
+	/**
+	 * @brief F( x + t * d ) - F( x ) of a penalty function with P = 2 along a ray, t >= 0:
+	 * phi(t) = slope * t + curvature * t^2 / 2 + weight * sum( max( 0, a[i] + b[i] * t )^2 )
+	 * a[i] = gi(x), b[i] = grad( gi(x) )' * d. Exact for a linear or quadratic f and linear gi,
+	 * other gi enter linearized. phi is convex and piecewise quadratic, its breakpoints are t[i] = -a[i] / b[i].
+	 */
+	template<typename T>
+	class PenaltyRay {
+	public: // == TYPES ==
+		using ValueType = T;
+	private: // == MEMBERS ==
+		T									mSlope		= T();	//!< grad( f(x) )' * d
+		T									mCurvature	= T();	//!< d' * hessian( f(x) ) * d
+		T									mWeight		= T();	//!< r[k]
+		std::vector<std::pair<T, T>>		mHinges;			//!< ( a[i], b[i] )
+		std::vector<std::pair<T, size_t>>	mBreaks;			//!< ( t[i], i ), scratch of minimize
+	public: // == METHODS ==
+		void reset(T slope, T curvature, T weight) {
+			mSlope = slope;
+			mCurvature = curvature;
+			mWeight = weight;
+			mHinges.clear();
+		}
+
+		void add(T a, T b) {
+			mHinges.emplace_back(a, b);
+		}
+
+		/**
+		 * argmin( phi(t) ), t >= 0: breakpoints are sorted and the segments scanned
+		 * until phi'(t) = S + K * t changes sign, O(m log m) for m hinges.
+		 * @return infinity when phi decreases without bound
+		 */
+		T minimize() {
+			T S = mSlope;		// phi'(t) = S + K * t on the current segment
+			T K = mCurvature;
+			size_t active = 0;
+			mBreaks.clear();
+
+			for (size_t i = 0; i < mHinges.size(); i++) {
+				const T a = mHinges[i].first;
+				const T b = mHinges[i].second;
+
+				if (Active(a, b)) {
+					S += 2 * mWeight * a * b;
+					K += 2 * mWeight * b * b;
+					active++;
+				}
+
+				// the sign of a + b * t changes ahead
+				if (b != 0 && -a / b > 0)
+					mBreaks.emplace_back(-a / b, i);
+			}
+
+			std::sort(mBreaks.begin(), mBreaks.end());
+			T lo = 0;
+
+			for (const auto& point : mBreaks) {
+				if (S + K * point.first >= 0)
+					return K > 0 ? std::max(lo, -S / K) : lo;
+
+				const T a = mHinges[point.second].first;
+				const T b = mHinges[point.second].second;
+				// b > 0 enters the penalty here, b < 0 leaves it
+				const T sign = b > 0 ? T(1) : T(-1);
+				S += sign * 2 * mWeight * a * b;
+				K += sign * 2 * mWeight * b * b;
+				active = b > 0 ? active + 1 : active - 1;
+				lo = point.first;
+
+				// drop the rounding the removed terms left behind
+				if (active == 0) {
+					S = mSlope;
+					K = mCurvature;
+				}
+			}
+
+			if (K > 0 && S + K * lo < 0)
+				return -S / K;
+
+			return S + K * lo < 0 ? std::numeric_limits<T>::infinity() : lo;
+		}
+
+	private:
+		static bool Active(T a, T b) {
+			return a > 0 || (a == 0 && b > 0);
+		}
+	};
+
+	/**
+	 * @brief line search that takes the minimizer of PenaltyRay in one step, for objectives providing
+	 * void ray(const VectorT& x, const VectorT& d, PenaltyRay<ValueType>& model) const;
+	 * as PenaltyFunction::FxRkFunction and CsrPenaltyFunction::FxRkFunction with IntegerPower<2> do.
+	 * The step is checked against the sufficient decrease condition of WolfeLineSearch and, when a nonlinear gi
+	 * made the model inexact, backtracked by safeguarded quadratic interpolation.
+	 */
+	template< typename F,
+		typename IndexType = size_t
+	>
+	class ExactLineSearch {
+	public: // == TYPES ==
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+		using ModelT	= PenaltyRay<ValueType>;
+	public: // == CONSTANTS ==
+		static constexpr ValueType	C1				= 1e-4;		//!< sufficient decrease
+		static constexpr IndexType	MaxIterations	= 40;		//!< backtracking steps per search
+	public:
+		/**
+		 * @param model		scratch of the ray, kept by the caller to reuse its storage
+		 * @param alpha		in: step taken when the model is unbounded along d, out: accepted step
+		 * @return false if no step with sufficient decrease was found.
+		 * The other parameters are those of WolfeLineSearch::search.
+		 */
+		static bool search(const F& f, const VectorT& x, ValueType f0, const VectorT& g0, const VectorT& d,
+			ValueType& alpha, ModelT& model,
+			VectorT& xOut, ValueType& fOut, VectorT& gOut, IndexType& evaluations
+		) {
+			const ValueType dphi0 = WolfeLineSearch<F, IndexType>::Dot(g0, d);
+
+			if (!(dphi0 < 0))
+				return false;
+
+			f.ray(x, d, model);
+			evaluations++;
+			ValueType a = model.minimize();
+
+			if (!std::isfinite(a))
+				a = alpha;
+
+			if (!(a > 0))
+				return false;
+
+			xOut = x;
+
+			for (IndexType i = 0; i < MaxIterations; i++) {
+				for (IndexType idx = 0; idx < x.size(); idx++)
+					xOut[idx] = x[idx] + a * d[idx];
+
+				Evaluator<F>::evaluate(f, xOut, fOut, gOut);
+				evaluations++;
+
+				if (std::isfinite(fOut) && fOut <= f0 + C1 * a * dphi0) {
+					alpha = a;
+					return true;
+				}
+
+				// minimizer of the quadratic through phi(0), phi'(0) and phi(a), kept within [ a / 10, a / 2 ]
+				ValueType next = std::isfinite(fOut) ? -dphi0 * a * a / (2 * (fOut - f0 - dphi0 * a)) : a / 2;
+				a = std::min(std::max(next, a / 10), a / 2);
+			}
+
+			return false;
+		}
+	};
+}// namespace tpr
@@ -0,0 +1,187 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+#include "Evaluator.hpp"
+#include "Hessian.hpp"
+#include "CsrModel.hpp"
+
+namespace tpr {
+	/**
+	 * @brief detects a chance row, a ChanceConstraint with its coeffs(), variances(), laplassInverse() and resource()
+	 */
+	template<typename G, typename = void>
+	struct IsChanceRow : std::false_type {};
+
+	template<typename G>
+	struct IsChanceRow<G, typename detail::VoidT<
+		decltype(G::coeffs()),
+		decltype(G::variances()),
+		decltype(G::laplassInverse()),
+		decltype(G::resource())
+	>::type> : std::true_type {};
+
+	/**
+	 * @brief detects functions declared linear, f(x) = a' * x + b, in the Fx or Gi type:
+	 * static constexpr bool Linear = true;
+	 * A ChanceConstraint is linear only for laplassInverse() == 0, which is a runtime value, see LinearModel.
+	 */
+	template<typename F, typename = void>
+	struct IsLinear : std::false_type {};
+
+	template<typename F>
+	struct IsLinear<F, typename detail::VoidT<
+		decltype(F::Linear)
+	>::type> : std::integral_constant<bool, F::Linear> {};
+
+	namespace detail {
+		template<bool ... Values>
+		struct BoolList {};
+
+		template<bool ... Values>
+		struct AllOf : std::is_same<BoolList<true, Values ...>, BoolList<Values ..., true>> {};
+
+		/**
+		 * laplassInverse() of a chance row, 0 for any other gi
+		 */
+		template<typename G, bool Chance = IsChanceRow<G>::value>
+		struct Quantile {
+			static CsrModel::ValueType value() {
+				return 0.0;
+			}
+		};
+
+		template<typename G>
+		struct Quantile<G, true> {
+			static CsrModel::ValueType value() {
+				return G::laplassInverse();
+			}
+		};
+	}// namespace detail
+
+	/**
+	 * @brief true when the model may be a linear program: Fx is linear and every gi is linear or a chance row.
+	 * holds() completes the test at runtime, a chance row is linear with a zero quantile,
+	 * on the types without building the CsrModel or on a model already built.
+	 */
+	template<typename FT, typename ... GiFuncTypes>
+	struct LinearModel : detail::AllOf<
+		IsLinear<FT>::value,
+		(IsLinear<GiFuncTypes>::value || IsChanceRow<GiFuncTypes>::value) ...
+	> {
+		static bool holds() {
+			const CsrModel::ValueType quantiles[] = { 0.0, detail::Quantile<GiFuncTypes>::value() ... };
+
+			for (CsrModel::ValueType quantile : quantiles)
+				if (quantile != 0)
+					return false;
+
+			return LinearModel::value;
+		}
+
+		static bool holds(const CsrModel& model) {
+			for (CsrModel::ValueType quantile : model.quantiles)
+				if (quantile != 0)
+					return false;
+
+			return LinearModel::value;
+		}
+	};
+
+	/**
+	 * @brief CsrModel of a compiled model, so the Fx and Gi types PenaltyFunction takes feed CsrPenaltyFunction
+	 * and SecondOrderConeSolver as well:
+	 * tpr::CsrModel model = tpr::ModelTable< Fx, G1<Cfg>, ..., GN<Cfg> >::build();
+	 * A ChanceConstraint becomes a chance row from its coeffs, variances, laplassInverse and resource.
+	 * Any other gi is linear, as HasHessian takes a type without add_hessian: a[k] = gi( e[k] ) - gi( 0 ), b = -gi( 0 ).
+	 * The same differences give c, so Fx has to be linear too, a constant term of f(x) is dropped.
+	 * Only apply is called, a gradient the type declares is not consulted. Variables are named x0, x1 ...
+	 */
+	template<typename FT, typename ... GiFuncTypes>
+	struct ModelTable {
+		using ValueType = typename FT::ValueType;
+		static constexpr size_t N = FT::N;
+
+		static CsrModel build() {
+			static_assert(!HasHessian<FT>::value, "the objective of a CsrModel is linear");
+			CsrModel model;
+			ValueType constant;
+
+			for (size_t idx = 0; idx < N; idx++)
+				model.names.push_back("x" + std::to_string(idx));
+
+			model.objective = Coefficients<FT>(constant);
+			int expand[] = { 0, (Row<GiFuncTypes>::append(model), 0) ... };
+			(void)expand;
+			return model;
+		}
+
+	private:
+		/**
+		 * f( e[k] ) - f( 0 ) for every k, exact for a linear f up to rounding
+		 * @param constant	out: f( 0 )
+		 */
+		template<typename F>
+		static std::vector<ValueType> Coefficients(ValueType& constant) {
+			typename F::VectorT xArgs{};
+			std::vector<ValueType> rval(N);
+			constant = F::apply(xArgs);
+
+			for (size_t idx = 0; idx < N; idx++) {
+				xArgs[idx] = 1.0;
+				rval[idx] = F::apply(xArgs) - constant;
+				xArgs[idx] = 0.0;
+			}
+
+			return rval;
+		}
+
+		template<typename G, bool Chance = IsChanceRow<G>::value>
+		struct Row {
+			static void append(CsrModel& model) {
+				static_assert(!HasHessian<G>::value, "a gi other than a ChanceConstraint has to be linear");
+				ValueType constant;
+				const std::vector<ValueType> coeffs = Coefficients<G>(constant);
+				std::vector<std::pair<size_t, double>> entries;
+
+				for (size_t idx = 0; idx < N; idx++)
+					if (coeffs[idx] != 0)
+						entries.emplace_back(idx, coeffs[idx]);
+
+				model.linear.append(std::move(entries));
+				model.bounds.push_back(-constant);
+			}
+		};
+
+		template<typename G>
+		struct Row<G, true> {
+			static void append(CsrModel& model) {
+				using Sparsity = typename G::Sparsity;
+				const auto coeffs = G::coeffs();
+				const auto variances = G::variances();
+				std::vector<std::pair<size_t, double>> entries;
+
+				for (size_t k = 0; k < Sparsity::Size; k++)
+					entries.emplace_back(Sparsity::at(k), coeffs[k]);
+
+				model.chance.append(std::move(entries));
+
+				// append sorts the row by column, the variances follow that order
+				for (CsrOffset k = model.chance.rowStart[model.chance.rows() - 1]; k < model.chance.rowStart.back(); k++) {
+					for (size_t j = 0; j < Sparsity::Size; j++) {
+						if (Sparsity::at(j) == model.chance.columns[k]) {
+							model.variances.push_back(variances[j]);
+							break;
+						}
+					}
+				}
+
+				model.quantiles.push_back(G::laplassInverse());
+				model.resources.push_back(G::resource());
+			}
+		};
+	};
+}// namespace tpr
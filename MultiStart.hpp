@@ -0,0 +1,139 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <algorithm>
+
+#include "GradientDescent.hpp"
+#include "Bounds.hpp"
+
+namespace tpr {
+	/**
+	 * @brief solves one model from several starting vectors on a pool of worker threads.
+	 * Every start runs solver.solve< GradientDescentT >( x0 ) on a SolverT object of its own, workers take
+	 * the next start from a shared counter until all of them are done.
+	 * SolverT is PenaltyFunction or AugmentedLagrangian, the solve state lives in the object,
+	 * so the same instantiation can run on all workers at once.
+	 * Bounds passed to solve are set on every solver object, GradientDescentT has to project then.
+	 *
+	 * using MS = MultiStart< PF >;
+	 * MS::Result r = MS::solve( starts, Box<double>::nonnegative( PF::N ) );
+	 * r.starts[ r.best ].xOpt
+	 */
+	template<
+		typename SolverT,
+		template<typename, typename> class GradientDescentT = StepSplitGradientDescent
+	>
+	class MultiStart {
+	public: // == TYPES ==
+		using ValueType = typename SolverT::ValueType;
+		using VectorT	= typename SolverT::VectorT;
+
+		/**
+		 * outcome of one start
+		 */
+		struct StartStats {
+			VectorT		x0;
+			VectorT		xOpt;
+			ValueType	value			= ValueType();	//!< f( xOpt )
+			ValueType	infeasibility	= ValueType();	//!< max( 0, max( gi( xOpt ) ) )
+			double		seconds			= 0.0;			//!< wall time of the solve
+			size_t		outerIterations	= 0;			//!< inner solves, i.e. r[k] / c updates
+			size_t		innerIterations	= 0;			//!< descent iterations over all inner solves
+		};
+
+		struct Result {
+			std::vector<StartStats>	starts;			//!< in the order of the starting vectors
+			size_t					best = 0;		//!< index into starts
+			bool					feasible = false;//!< starts[ best ] satisfies all gi within FeasibilityEpsilon
+		};
+
+	public: // == CONSTANTS ==
+		static constexpr ValueType	FeasibilityEpsilon = 1e-4;	//!< max( 0, gi(x) ) accepted as feasible
+
+	public: // == METHODS ==
+		/**
+		 * solves without bounds on x
+		 */
+		static Result solve(const std::vector<VectorT>& starts, size_t threads = 0) {
+			return solve(starts, Box<ValueType>(), threads);
+		}
+
+		/**
+		 * @param starts	starting vectors, solved independently
+		 * @param bounds	lower <= x <= upper of every solve, see SolverT::setBounds, empty for none
+		 * @param threads	number of workers, 0 - one per hardware thread
+		 * @return all starts with the lowest f( xOpt ) among the feasible ones as best,
+		 *		the least infeasible one if none is feasible.
+		 */
+		static Result solve(const std::vector<VectorT>& starts, const Box<ValueType>& bounds, size_t threads = 0) {
+			Result rval;
+			rval.starts.resize(starts.size());
+
+			if (starts.empty())
+				return rval;
+
+			if (threads == 0)
+				threads = std::max(1u, std::thread::hardware_concurrency());
+
+			threads = std::min(threads, starts.size());
+			std::atomic<size_t> next(0);
+			auto worker = [&]() {
+				for (size_t idx = next++; idx < starts.size(); idx = next++)
+					Run(starts[idx], bounds, rval.starts[idx]);
+			};
+
+			std::vector<std::thread> pool;
+
+			for (size_t idx = 1; idx < threads; idx++)
+				pool.emplace_back(worker);
+
+			// the calling thread is a worker too
+			worker();
+
+			for (std::thread& t : pool)
+				t.join();
+
+			rval.best = SelectBest(rval.starts);
+			rval.feasible = rval.starts[rval.best].infeasibility <= FeasibilityEpsilon;
+			return rval;
+		}
+
+	private:
+		static void Run(const VectorT& x0, const Box<ValueType>& bounds, StartStats& stats) {
+			auto started = std::chrono::steady_clock::now();
+			SolverT solver;
+			solver.setBounds(bounds);
+			stats.x0 = x0;
+			stats.xOpt = solver.template solve<GradientDescentT>(x0);
+			stats.outerIterations = solver.outerIterations();
+			stats.innerIterations = solver.innerIterations();
+			stats.value = SolverT::TargetF::apply(stats.xOpt);
+			stats.infeasibility = SolverT::infeasibility(stats.xOpt);
+			stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+		}
+
+		static size_t SelectBest(const std::vector<StartStats>& stats) {
+			size_t best = 0;
+
+			for (size_t idx = 1; idx < stats.size(); idx++) {
+				bool feasible = stats[idx].infeasibility <= FeasibilityEpsilon;
+				bool bestFeasible = stats[best].infeasibility <= FeasibilityEpsilon;
+
+				if (feasible != bestFeasible) {
+					if (feasible)
+						best = idx;
+				} else if (feasible) {
+					if (stats[idx].value < stats[best].value)
+						best = idx;
+				} else if (stats[idx].infeasibility < stats[best].infeasibility) {
+					best = idx;
+				}
+			}
+
+			return best;
+		}
+	};
+}// namespace tpr
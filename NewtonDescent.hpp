@@ -0,0 +1,133 @@
+#pragma once
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#include "Evaluator.hpp"
+#include "Hessian.hpp"
+#include "LineSearch.hpp"
+
+namespace tpr {
+	/**
+	 * @brief damped Newton method, drop-in replacement for StepSplitGradientDescent when F provides
+	 * void hessian(const VectorT& x, MatrixT& H) const;	// MatrixT = DenseMatrix<ValueType>
+	 * as PenaltyFunction::FxRkFunction does.
+	 * d[k] = -( H[k] + tau * I )^-1 * grad( f( x[k] ) ), tau by ModifiedCholesky, zero where H[k] is positive definite,
+	 * the step starts at 1 and is chosen by WolfeLineSearch, so x[k] converges quadratically near a minimum.
+	 * Far from it the penalty is piecewise quadratic and H[k] describes only the current piece:
+	 * when the search fails along d[k], tau grows tenfold (Levenberg damping) and decays again after successful steps.
+	 * The Hessian is dense and factorized in O(N^3), meant for models of tens of variables.
+	 */
+	template< typename F,
+		typename IndexType = size_t
+	>
+	class NewtonDescent {
+	public: // == TYPES ==
+		using ValueType		= typename F::ValueType;
+		using VectorT		= typename F::VectorT;
+		using MatrixT		= DenseMatrix<ValueType>;
+		using LineSearch	= WolfeLineSearch<F, IndexType>;
+	public: // == CONSTANTS ==
+		static constexpr ValueType	Epsilon			= 1e-10;	//!< relative decrease of f( x ) to stop at
+		static constexpr ValueType	GradientEpsilon	= 1e-8;		//!< max | grad( f( x ) ) | to stop at
+		static constexpr IndexType	MaxIterations	= 1'000;
+		static constexpr ValueType	Curvature		= 0.9;		//!< c2 of the Wolfe conditions
+		static constexpr ValueType	Lambda			= 1.0;		//!< length of a steepest descent step, used when the Newton step fails
+		static constexpr ValueType	Damping			= 10.0;		//!< growth and decay factor of tau
+		static constexpr IndexType	MaxDamping		= 8;		//!< damped retries along ( H[k] + tau * I )^-1 per iteration
+	public:
+		static VectorT calculate(const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(F(), x0, lambda, it, evaluations);
+		}
+
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(f, x0, lambda, it, evaluations);
+		}
+
+		/**
+		 * @param f				objective, called through the object so it may carry state
+		 * @param lambda		in: length of a steepest descent step, out: last accepted step
+		 * @param evaluations	incremented by the number of value + gradient evaluations, line search included
+		 */
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it, IndexType& evaluations) {
+			IndexType N = x0.size();// take num of vars from x0, runtime models have no F::N
+			VectorT currentXVec = x0;
+			VectorT gradientVec;
+			VectorT nextXVec;
+			VectorT nextGradientVec;
+			VectorT direction;
+			MatrixT hessian;
+			ModifiedCholesky<ValueType> factor;
+			ValueType currentValue = 0.0;
+			ValueType nextValue = 0.0;
+			ValueType damping = 0.0;	// lower bound of tau, kept between iterations
+
+			Evaluator<F>::evaluate(f, currentXVec, currentValue, gradientVec);
+			evaluations++;
+
+			for (it = 0; it < MaxIterations; it++) {
+				ValueType gradientNorm = 0.0;
+
+				for (IndexType idx = 0; idx < N; idx++)
+					gradientNorm = std::max(gradientNorm, std::fabs(gradientVec[idx]));
+
+				if (gradientNorm <= GradientEpsilon)
+					return currentXVec;
+
+				f.hessian(currentXVec, hessian);
+				const ValueType unit = ModifiedCholesky<ValueType>::MinShift * ModifiedCholesky<ValueType>::scale(hessian);
+				ValueType step = 1.0;
+				bool found = false;
+
+				for (IndexType attempt = 0; attempt < MaxDamping && !found && factor.factorize(hessian, damping); attempt++) {
+					factor.solve(gradientVec, direction);
+
+					for (IndexType j = 0; j < N; j++)
+						direction[j] = -direction[j];
+
+					step = 1.0;
+					found = LineSearch::search(f, currentXVec, currentValue, gradientVec, direction, step, Curvature,
+						nextXVec, nextValue, nextGradientVec, evaluations);
+
+					if (!found)
+						damping = std::max(Damping * factor.shift(), unit);
+				}
+
+				if (found)
+					damping = factor.shift() / Damping < unit ? ValueType() : factor.shift() / Damping;
+
+				if (!found) {
+					// H is useless here (NaN, or the quadratic model disagrees with f), fall back to steepest descent
+					direction = gradientVec;
+
+					for (IndexType j = 0; j < N; j++)
+						direction[j] = -direction[j];
+
+					step = lambda / std::sqrt(LineSearch::Dot(gradientVec, gradientVec));
+
+					// no decrease along -grad( f( x ) ) is representable, x[k] is as good as it gets
+					if (!LineSearch::search(f, currentXVec, currentValue, gradientVec, direction, step, Curvature,
+						nextXVec, nextValue, nextGradientVec, evaluations))
+						return currentXVec;
+				}
+
+				lambda = step;
+
+				ValueType diff = std::fabs(nextValue - currentValue);
+				ValueType scale = std::max(ValueType(1.0), std::max(std::fabs(nextValue), std::fabs(currentValue)));
+
+				currentXVec = nextXVec;
+				currentValue = nextValue;
+				gradientVec = nextGradientVec;
+
+				if (diff <= Epsilon * scale)
+					return currentXVec;
+			}// for
+
+			assert(0 && "Failed");
+			return currentXVec;
+		}
+	};
+}// namespace tpr
@@ -0,0 +1,255 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <cstddef>
+#include <algorithm>
+
+#include "GradientDescent.hpp"
+#include "Bounds.hpp"
+
+namespace tpr {
+	/**
+	 * @brief cartesian grid of what-if scenarios.
+	 * Every parameter not added keeps the value of the base scenario.
+	 *
+	 * SweepGrid<Scenario> grid(base);
+	 * grid.add(&Scenario::Resource11, SweepGrid<Scenario>::range(200, 300, 5))
+	 *     .add(&Scenario::ASum, { 250, 300, 350 });
+	 * grid.scenarios(); // 15 scenarios, the last added parameter varies fastest
+	 */
+	template<typename ScenarioT>
+	class SweepGrid {
+	public: // == TYPES ==
+		using ParameterT = double ScenarioT::*;
+
+	public: // == METHODS ==
+		explicit SweepGrid(const ScenarioT& base) : mBase(base) {}
+
+		SweepGrid& add(ParameterT parameter, std::vector<double> values) {
+			mAxes.push_back({ parameter, std::move(values) });
+			return *this;
+		}
+
+		/**
+		 * count values evenly spaced over [ first, last ]
+		 */
+		static std::vector<double> range(double first, double last, size_t count) {
+			std::vector<double> rval(count, first);
+
+			for (size_t idx = 1; idx < count; idx++)
+				rval[idx] = first + (last - first) * idx / (count - 1);
+
+			return rval;
+		}
+
+		std::vector<ScenarioT> scenarios() const {
+			std::vector<ScenarioT> rval;
+			std::vector<size_t> digits(mAxes.size(), 0);
+
+			for (const Axis& axis : mAxes) {
+				if (axis.values.empty())
+					return rval;
+			}
+
+			while (true) {
+				ScenarioT scenario = mBase;
+
+				for (size_t idx = 0; idx < mAxes.size(); idx++)
+					scenario.*mAxes[idx].parameter = mAxes[idx].values[digits[idx]];
+
+				rval.push_back(scenario);
+
+				// odometer increment, neighbouring scenarios differ in one parameter
+				size_t axis = mAxes.size();
+
+				while (axis > 0 && ++digits[axis - 1] == mAxes[axis - 1].values.size())
+					digits[--axis] = 0;
+
+				if (axis == 0)
+					return rval;
+			}
+		}
+
+	private:
+		struct Axis {
+			ParameterT			parameter;
+			std::vector<double>	values;
+		};
+
+		ScenarioT			mBase;
+		std::vector<Axis>	mAxes;
+	};
+
+	/**
+	 * @brief solves one model for many runtime scenarios on a pool of worker threads.
+	 * SolverT is built over constraints of ConfigT, a runtime config such as subj_17::RuntimeConfig:
+	 *		ConfigT::Scenario				- the parameter values
+	 *		ConfigT::set( scenario )		- makes them current for the calling thread
+	 *		ConfigT::Parameters				- member pointers of Scenario, used to measure scenario distance
+	 * Each solve starts from xOpt of the nearest scenario solved so far,
+	 * distances are normalized by the spread of every parameter over the sweep.
+	 * The lock is only held to pick the start point and to publish the result, never around a solve.
+	 */
+	template<
+		typename SolverT,
+		typename ConfigT,
+		template<typename, typename> class GradientDescentT = StepSplitGradientDescent
+	>
+	class ParameterSweep {
+	public: // == TYPES ==
+		using ValueType = typename SolverT::ValueType;
+		using VectorT	= typename SolverT::VectorT;
+		using Scenario	= typename ConfigT::Scenario;
+
+		/**
+		 * outcome of one scenario
+		 */
+		struct ScenarioStats {
+			Scenario	scenario;
+			VectorT		xOpt;
+			ValueType	value			= ValueType();	//!< f( xOpt )
+			ValueType	infeasibility	= ValueType();	//!< max( 0, max( gi( xOpt ) ) )
+			double		seconds			= 0.0;			//!< wall time of the solve
+			size_t		outerIterations	= 0;
+			size_t		innerIterations	= 0;
+			size_t		warmStart		= NoWarmStart;	//!< scenario whose xOpt was the start point
+		};
+
+	public: // == CONSTANTS ==
+		static constexpr size_t	NoWarmStart = std::numeric_limits<size_t>::max();	//!< solved from x0
+
+	public: // == METHODS ==
+		/**
+		 * solves without bounds on x
+		 */
+		static std::vector<ScenarioStats> solve(const std::vector<Scenario>& scenarios, const VectorT& x0, size_t threads = 0) {
+			return solve(scenarios, x0, Box<ValueType>(), threads);
+		}
+
+		/**
+		 * @param scenarios	solved in this order as far as the workers allow, keep neighbours adjacent (SweepGrid does)
+		 * @param x0		start point of scenarios without a solved neighbour
+		 * @param bounds	lower <= x <= upper of every scenario, see SolverT::setBounds, empty for none
+		 * @param threads	number of workers, 0 - one per hardware thread
+		 * @return results in the order of scenarios
+		 */
+		static std::vector<ScenarioStats> solve(const std::vector<Scenario>& scenarios, const VectorT& x0, const Box<ValueType>& bounds, size_t threads = 0) {
+			std::vector<ScenarioStats> rval(scenarios.size());
+
+			if (scenarios.empty())
+				return rval;
+
+			if (threads == 0)
+				threads = std::max(1u, std::thread::hardware_concurrency());
+
+			threads = std::min(threads, scenarios.size());
+			const std::vector<double> scale = Spread(scenarios);
+			std::vector<size_t> solved;	// indices of finished scenarios
+			std::mutex solvedLock;
+			std::atomic<size_t> next(0);
+
+			auto worker = [&]() {
+				for (size_t idx = next++; idx < scenarios.size(); idx = next++) {
+					ScenarioStats& stats = rval[idx];
+					VectorT start = x0;
+					stats.scenario = scenarios[idx];
+
+					{
+						std::lock_guard<std::mutex> guard(solvedLock);
+						stats.warmStart = Nearest(scenarios, solved, scale, scenarios[idx]);
+
+						if (stats.warmStart != NoWarmStart)
+							start = rval[stats.warmStart].xOpt;
+					}
+
+					Run(start, bounds, stats);
+					std::lock_guard<std::mutex> guard(solvedLock);
+					solved.push_back(idx);
+				}
+			};
+
+			std::vector<std::thread> pool;
+
+			for (size_t idx = 1; idx < threads; idx++)
+				pool.emplace_back(worker);
+
+			// the calling thread is a worker too
+			worker();
+
+			for (std::thread& t : pool)
+				t.join();
+
+			return rval;
+		}
+
+	private:
+		static void Run(const VectorT& x0, const Box<ValueType>& bounds, ScenarioStats& stats) {
+			auto started = std::chrono::steady_clock::now();
+			ConfigT::set(stats.scenario);
+			SolverT solver;
+			solver.setBounds(bounds);
+			stats.xOpt = solver.template solve<GradientDescentT>(x0);
+			stats.value = SolverT::TargetF::apply(stats.xOpt);
+			stats.infeasibility = SolverT::infeasibility(stats.xOpt);
+			stats.outerIterations = solver.outerIterations();
+			stats.innerIterations = solver.innerIterations();
+			stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+		}
+
+		/**
+		 * max - min of every parameter over the sweep, 1 for parameters that do not vary
+		 */
+		static std::vector<double> Spread(const std::vector<Scenario>& scenarios) {
+			std::vector<double> rval;
+
+			for (auto parameter : ConfigT::Parameters) {
+				double lo = scenarios.front().*parameter;
+				double hi = lo;
+
+				for (const Scenario& scenario : scenarios) {
+					lo = std::min(lo, scenario.*parameter);
+					hi = std::max(hi, scenario.*parameter);
+				}
+
+				rval.push_back(hi > lo ? hi - lo : 1.0);
+			}
+
+			return rval;
+		}
+
+		static size_t Nearest(const std::vector<Scenario>& scenarios, const std::vector<size_t>& solved,
+			const std::vector<double>& scale, const Scenario& scenario
+		) {
+			size_t rval = NoWarmStart;
+			double best = std::numeric_limits<double>::max();
+
+			for (size_t idx : solved) {
+				double distance = 0.0;
+				size_t k = 0;
+
+				for (auto parameter : ConfigT::Parameters) {
+					double d = (scenarios[idx].*parameter - scenario.*parameter) / scale[k++];
+					distance += d * d;
+				}
+
+				if (distance < best) {
+					best = distance;
+					rval = idx;
+				}
+			}
+
+			return rval;
+		}
+	};
+
+	template<
+		typename SolverT,
+		typename ConfigT,
+		template<typename, typename> class GradientDescentT
+	>
+	constexpr size_t ParameterSweep<SolverT, ConfigT, GradientDescentT>::NoWarmStart;
+}// namespace tpr
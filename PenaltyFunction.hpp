@@ -1,8 +1,23 @@
 #pragma once
 #include <functional>
 #include <cmath>
+#include <algorithm>
+#include <type_traits>
 
 #include "GradientDescent.hpp"
+#include "LBFGSDescent.hpp"
+#include "ConjugateGradientDescent.hpp"
+#include "NewtonDescent.hpp"
+#include "TruncatedNewtonDescent.hpp"
+#include "LevenbergMarquardtDescent.hpp"
+#include "ExactStepGradientDescent.hpp"
+#include "SpectralGradientDescent.hpp"
+#include "Evaluator.hpp"
+#include "Bounds.hpp"
+#include "PenaltyPower.hpp"
+#include "Batch.hpp"
+#include "ModelTable.hpp"
+#include "SimplexSolver.hpp"
 
 namespace tpr {
 	/**
@@ -11,7 +26,7 @@ namespace tpr {
 	 * with contraints
 	 * gi(x) <= 0
 	 * alpha(x) = sum( R1( gi(x) ) ) + sum( R2( hj(x) ) )
-	 * R1(gi(x)) = max( 0, gi(x) )^P
+	 * R1(gi(x)) = max( 0, gi(x) )^P, P is the PowerT policy: IntegerPower<P>, ExactPenalty, RealPower<Num, Den>
 	 * R2(gj(x)) = hj(x)^ 2 * P
 	 * penalty function itself: F(x,rk) = f(x) + rk * alpha(x) --> min
 	 * min(F(x, rk)) may be found by gradient descent, for example.
@@ -31,16 +46,18 @@ namespace tpr {
 	 * done
 	 */
 	template<
+		typename PowerT, //exponent of R1
 		typename FT, //minimizing function
 		typename IndexType,
 		typename ... GiFuncTypes
 	>
-	class PenaltyFunction {
+	class BasicPenaltyFunction {
 	public: // == TYPES ==
 		using TargetF	= FT;
 		using ValueType = typename TargetF::ValueType;
 		using VectorT	= typename TargetF::VectorT;
-		using ThisT		= PenaltyFunction<FT, IndexType, GiFuncTypes ...>;
+		using Power		= PowerT;
+		using ThisT		= BasicPenaltyFunction<PowerT, FT, IndexType, GiFuncTypes ...>;
 
 		template<typename VecT, int N>
 		struct InitArray;
@@ -72,77 +89,181 @@ namespace tpr {
 		/**
 		 * R1
 		 */
-		template<typename ValueT, typename VecT, int PParam, typename G, typename... GiFuncTypes>
-		struct R1 : R1<ValueT, VecT, PParam, G>
-			, R1< ValueT, VecT, PParam, GiFuncTypes ... > {
-			using Tail = R1< ValueT, VecT, PParam, GiFuncTypes ... >;
+		template<typename ValueT, typename VecT, typename PowT, typename G, typename... GiTail>
+		struct R1 {
+			using Head = R1< ValueT, VecT, PowT, G >;
+			using Tail = R1< ValueT, VecT, PowT, GiTail ... >;
 
 			static ValueT apply(const VecT& xArgs) {
-				return std::pow(std::max(0.0, double(1.0 * G::apply(xArgs))), PParam) + Tail::apply(xArgs);
+				return Head::apply(xArgs) + Tail::apply(xArgs);
+			}
+
+			template<typename BatchVecT>
+			static auto apply_batch(const BatchVecT& xArgs) -> decltype(Head::apply_batch(xArgs) + Tail::apply_batch(xArgs)) {
+				return Head::apply_batch(xArgs) + Tail::apply_batch(xArgs);
+			}
+
+			/**
+			 * value += sum( R1( gi(x) ) ), grad += sum( grad( R1( gi(x) ) ) )
+			 */
+			static void accumulate(const VecT& xArgs, ValueT& value, VecT& grad) {
+				Head::accumulate(xArgs, value, grad);
+				Tail::accumulate(xArgs, value, grad);
+			}
+
+			/**
+			 * H += coef * sum( hessian( R1( gi(x) ) ) )
+			 */
+			static void accumulate_hessian(const VecT& xArgs, ValueT coef, DenseMatrix<ValueT>& H) {
+				Head::accumulate_hessian(xArgs, coef, H);
+				Tail::accumulate_hessian(xArgs, coef, H);
+			}
+
+			/**
+			 * hv += coef * sum( hessian( R1( gi(x) ) ) ) * v
+			 */
+			static void accumulate_hessian_vector(const VecT& xArgs, const VecT& v, ValueT coef, VecT& hv) {
+				Head::accumulate_hessian_vector(xArgs, v, coef, hv);
+				Tail::accumulate_hessian_vector(xArgs, v, coef, hv);
+			}
+
+			/**
+			 * H += coef * sum( R1''( gi ) * grad( gi ) * grad( gi )' ), the Gauss-Newton part of the hessian
+			 */
+			static void accumulate_gauss_newton(const VecT& xArgs, ValueT coef, DenseMatrix<ValueT>& H) {
+				Head::accumulate_gauss_newton(xArgs, coef, H);
+				Tail::accumulate_gauss_newton(xArgs, coef, H);
+			}
+
+			/**
+			 * adds ( gi(x), grad( gi(x) )' * d ) of every gi to the ray model
+			 */
+			static void accumulate_ray(const VecT& xArgs, const VecT& d, PenaltyRay<ValueT>& model) {
+				Head::accumulate_ray(xArgs, d, model);
+				Tail::accumulate_ray(xArgs, d, model);
+			}
+
+			static void evaluate(const VecT& xArgs, ValueT& value, VecT& grad) {
+				value = ValueT();
+				grad.fill(ValueT());
+				accumulate(xArgs, value, grad);
 			}
 
 			static VecT gradient(const VecT& xArgs) {
-				ValueT f = G::apply(xArgs);
-				//ValueT v = std::pow(std::max(0.0, 1.0 * f), PParam);
+				ValueT value;
 				VecT ret;
-				memset(&ret[0], 0, sizeof(ValueT) * ret.size());
-
-				if (f > 0) {
-					/**
-					 * f(x) = (x1 + x2 - 7 )^3
-					 * dfdx1 = 3*(x1+x2 - 7)^2 * (x1+x2 - 7)' = 3*(x1+x2 - 7)^2 * 1
-					 */
-					VecT g = G::gradient(xArgs);
-					
-					for (IndexType idx = 0; idx < g.size(); idx++) {
-						ret[idx] = PParam * std::pow(1.0 * f, PParam - 1) * g[idx];
-						//g[idx] = PParam * std::pow(1.0 * f, PParam - 1) * std::pow(g[idx], PParam -1);
-					}
-				}
-				
-				VecT tailGrad = Tail::gradient(xArgs);
-
-				for (IndexType idx = 0; idx < ret.size(); idx++) {
-					ret[idx] += tailGrad[idx];
-				}
-
+				evaluate(xArgs, value, ret);
 				return ret;
 			}
 		};
 
 		// end of recursion.
-		template<typename ValueT, typename VecT, int PParam, typename G>
-		struct R1<ValueT, VecT, PParam, G> {
+		template<typename ValueT, typename VecT, typename PowT, typename G>
+		struct R1<ValueT, VecT, PowT, G> {
 			static ValueT apply(const VecT& xArgs) {
-				return std::pow(std::max(0.0, 1.0 * G::apply(xArgs)), PParam );
+				return PowT::apply(ValueT(G::apply(xArgs)));
 			}
 
-			static VecT gradient(const VecT& xArgs) {
-				ValueT f = G::apply(xArgs);
-				//ValueT v = std::pow(std::max(0.0, 1.0 * f), PParam);
-				VecT ret;
-				memset(&ret[0], 0, sizeof(ValueT) * ret.size());
+			/**
+			 * R1( gi(x) ) of a Batch of points, gi needs a templated apply
+			 */
+			template<typename BatchVecT>
+			static auto apply_batch(const BatchVecT& xArgs) -> decltype(PowT::apply(G::apply(xArgs))) {
+				return PowT::apply(G::apply(xArgs));
+			}
+
+			static void accumulate(const VecT& xArgs, ValueT& value, VecT& grad) {
+				using GiEvaluator = SparseEvaluator<G>;
+				ValueT f;
+				typename GiEvaluator::GradientT g;
 
-				if (f > 0) {
+				// gi(x) is evaluated once, the gradient only counts when max( 0, gi(x) ) > 0
+				if (GiEvaluator::evaluate_active(xArgs, f, g)) {
 					/**
 					 * f(x) = (x1 + x2 - 7 )^3
 					 * dfdx1 = 3*(x1+x2 - 7)^2 * (x1+x2 - 7)' = 3*(x1+x2 - 7)^2 * 1
 					 */
-					VecT g = G::gradient(xArgs);
+					ValueT fPow, slope;
+					PowT::evaluate(f, fPow, slope);
+					value += fPow;
+					// only the variables gi depends on are touched
+					GiEvaluator::scatter(slope, g, grad);
+				}
+			}
+
+			/**
+			 * hessian( R1( gi(x) ) ) = R1''( gi ) * grad( gi ) * grad( gi )' + R1'( gi ) * hessian( gi ),
+			 * zero for an inactive gi.
+			 */
+			static void accumulate_hessian(const VecT& xArgs, ValueT coef, DenseMatrix<ValueT>& H) {
+				using GiEvaluator = SparseEvaluator<G>;
+				ValueT f;
+				typename GiEvaluator::GradientT g;
+
+				if (GiEvaluator::evaluate_active(xArgs, f, g)) {
+					ValueT fPow, slope;
+					PowT::evaluate(f, fPow, slope);
+					GiEvaluator::scatter_outer(coef * PowT::curvature(f), g, H);
+					HessianEvaluator<G>::accumulate(xArgs, coef * slope, H);
+				}
+			}
+
+			/**
+			 * the same terms applied to v: R1''( gi ) * ( grad( gi )' * v ) * grad( gi ) + R1'( gi ) * hessian( gi ) * v
+			 */
+			static void accumulate_hessian_vector(const VecT& xArgs, const VecT& v, ValueT coef, VecT& hv) {
+				using GiEvaluator = SparseEvaluator<G>;
+				ValueT f;
+				typename GiEvaluator::GradientT g;
 
-					for (IndexType idx = 0; idx < g.size(); idx++) {
-						ret[idx] = PParam * std::pow(1.0 * f, PParam - 1) * g[idx];
-						//g[idx] = PParam * std::pow(1.0 * f, PParam - 1) * std::pow(g[idx], PParam -1);
-					}
+				if (GiEvaluator::evaluate_active(xArgs, f, g)) {
+					ValueT fPow, slope;
+					PowT::evaluate(f, fPow, slope);
+					GiEvaluator::scatter(coef * PowT::curvature(f) * GiEvaluator::dot(g, v), g, hv);
+					HessianVectorEvaluator<G>::accumulate(xArgs, v, coef * slope, hv);
 				}
+			}
 
+			/**
+			 * the first term of accumulate_hessian only: J' * J of the residual max( 0, gi ) for P = 2,
+			 * needs no second derivatives of gi and is positive semidefinite.
+			 */
+			static void accumulate_gauss_newton(const VecT& xArgs, ValueT coef, DenseMatrix<ValueT>& H) {
+				using GiEvaluator = SparseEvaluator<G>;
+				ValueT f;
+				typename GiEvaluator::GradientT g;
+
+				if (GiEvaluator::evaluate_active(xArgs, f, g))
+					GiEvaluator::scatter_outer(coef * PowT::curvature(f), g, H);
+			}
+
+			/**
+			 * gi( x + t * d ) = gi(x) + t * grad( gi(x) )' * d, exact for a linear gi.
+			 * Inactive gi are added too, the ray may cross into them.
+			 */
+			static void accumulate_ray(const VecT& xArgs, const VecT& d, PenaltyRay<ValueT>& model) {
+				using GiEvaluator = SparseEvaluator<G>;
+				ValueT f;
+				typename GiEvaluator::GradientT g;
+				GiEvaluator::evaluate(xArgs, f, g);
+				model.add(f, GiEvaluator::dot(g, d));
+			}
+
+			static void evaluate(const VecT& xArgs, ValueT& value, VecT& grad) {
+				value = ValueT();
+				grad.fill(ValueT());
+				accumulate(xArgs, value, grad);
+			}
+
+			static VecT gradient(const VecT& xArgs) {
+				ValueT value;
+				VecT ret;
+				evaluate(xArgs, value, ret);
 				return ret;
 			}
 		};
 
-		static constexpr int		PCoef = 2;//!< Power of gi, R1(gi(x)) = max( 0, gi(x) )^P
-
-		using R1Sum = R1<ValueType, VectorT, ThisT::PCoef, GiFuncTypes ...>;
+		using R1Sum = R1<ValueType, VectorT, Power, GiFuncTypes ...>;
 
 		/**
 		 * alpha(x) = sum( R1( gi(x) ) ) + sum( R2( hi(x) ) )
@@ -154,8 +275,33 @@ namespace tpr {
 				return ROneSum::apply( xArgs );
 			}
 
+			template<typename BatchVecT>
+			static auto apply_batch(const BatchVecT& xArgs) -> decltype(ROneSum::apply_batch(xArgs)) {
+				return ROneSum::apply_batch(xArgs);
+			}
+
 			static VecT gradient(const VecT& xArgs) {
 				return ROneSum::gradient(xArgs);
+			}
+
+			static void evaluate(const VecT& xArgs, ValueT& value, VecT& grad) {
+				ROneSum::evaluate(xArgs, value, grad);
+			}
+
+			static void accumulate_hessian(const VecT& xArgs, ValueT coef, DenseMatrix<ValueT>& H) {
+				ROneSum::accumulate_hessian(xArgs, coef, H);
+			}
+
+			static void accumulate_hessian_vector(const VecT& xArgs, const VecT& v, ValueT coef, VecT& hv) {
+				ROneSum::accumulate_hessian_vector(xArgs, v, coef, hv);
+			}
+
+			static void accumulate_gauss_newton(const VecT& xArgs, ValueT coef, DenseMatrix<ValueT>& H) {
+				ROneSum::accumulate_gauss_newton(xArgs, coef, H);
+			}
+
+			static void accumulate_ray(const VecT& xArgs, const VecT& d, PenaltyRay<ValueT>& model) {
+				ROneSum::accumulate_ray(xArgs, d, model);
 			}
 		};
 
@@ -168,13 +314,12 @@ namespace tpr {
 		static constexpr IndexType	N				= TargetF::N;	//!< sizeof Xopt vector
 		static constexpr IndexType	MaxPIterations	= 100'000;
 
-		static ValueType	sC;										//!< rk
-
 	public: // == TYPES ==
 
 		/**
 		 * Penalty function routine
 		 * F(x, r[k]) = f(x) + r[k] * alpha(x)
+		 * r[k] is held by reference, the solver raises it between inner solves, so are the bounds of x if any.
 		 */
 		template<
 			typename ValueT,
@@ -186,18 +331,110 @@ namespace tpr {
 
 			using ValueType = ValueT;
 			using VectorT	= VecT;
+			using MatrixT	= DenseMatrix<ValueT>;
 			static constexpr int N = ThisT::N;
 
-			static ValueT apply(const VecT& xArgs) {
-				return F::apply(xArgs) + ThisT::sC * A::apply( xArgs );
+			const ValueT&		rk;
+			const Box<ValueT>*	bounds = nullptr;
+
+			explicit FxRkFunction(const ValueT& rkRef) : rk(rkRef) {}
+
+			FxRkFunction(const ValueT& rkRef, const Box<ValueT>& boundsRef) : rk(rkRef), bounds(&boundsRef) {}
+
+			/**
+			 * box the projecting descents keep x in, empty when there is none
+			 */
+			const Box<ValueT>& box() const {
+				static const Box<ValueT> none;
+				return bounds ? *bounds : none;
 			}
 
-			static VecT gradient(const VecT& xArgs) {
+			ValueT apply(const VecT& xArgs) const {
+				return F::apply(xArgs) + rk * A::apply( xArgs );
+			}
+
+			/**
+			 * F(x, r[k]) of K points at once, xArgs[i].lane[k] is x[i] of point k, see BatchEvaluator.
+			 * Available when f and every gi have a templated apply.
+			 */
+			template<size_t K>
+			auto apply_batch(const BatchVector<N, ValueT, K>& xArgs) const -> decltype(F::apply(xArgs) + rk * A::apply_batch(xArgs)) {
+				return F::apply(xArgs) + rk * A::apply_batch(xArgs);
+			}
+
+			/**
+			 * F(x, r[k]) and its gradient in one pass,
+			 * each gi(x) is evaluated once for both alpha(x) and grad( alpha(x) ).
+			 */
+			void evaluate(const VecT& xArgs, ValueT& value, VecT& grad) const {
+				ValueT alphaValue;
+				VecT alphaGrad;
+				Evaluator<F>::evaluate(xArgs, value, grad);
+				A::evaluate(xArgs, alphaValue, alphaGrad);
+				value += rk * alphaValue;
+
+				for (IndexType idx = 0; idx < grad.size(); idx++)
+					grad[idx] += rk * alphaGrad[idx];
+			}
+
+			/**
+			 * H = hessian( f(x) ) + r[k] * hessian( alpha(x) ), for NewtonDescent.
+			 * Only active gi contribute, f and gi without add_hessian count as linear.
+			 */
+			void hessian(const VecT& xArgs, MatrixT& H) const {
+				H.resize(xArgs.size());
+				H.fill(ValueT());
+				HessianEvaluator<F>::accumulate(xArgs, ValueT(1), H);
+				A::accumulate_hessian(xArgs, rk, H);
+			}
+
+			/**
+			 * H = hessian( f(x) ) + r[k] * J' * J, the Gauss-Newton matrix for LevenbergMarquardtDescent.
+			 * J holds the gradients of the active gi scaled by sqrt( R1''( gi ) ), for P = 2 the residuals max( 0, gi ) are squared as is.
+			 */
+			void gauss_newton(const VecT& xArgs, MatrixT& H) const {
+				H.resize(xArgs.size());
+				H.fill(ValueT());
+				HessianEvaluator<F>::accumulate(xArgs, ValueT(1), H);
+				A::accumulate_gauss_newton(xArgs, rk, H);
+			}
+
+			/**
+			 * F(x + t * d, r[k]) as a PenaltyRay, for ExactLineSearch. f is taken as quadratic: its slope and d' * hessian * d at x.
+			 */
+			void ray(const VecT& xArgs, const VecT& d, PenaltyRay<ValueT>& model) const {
+				static_assert(std::is_same<PowerT, IntegerPower<2>>::value, "the penalty is piecewise quadratic along a ray for P = 2 only");
+				ValueT value, slope = ValueT(), curvature = ValueT();
+				VecT grad, hd = d;
+				Evaluator<F>::evaluate(xArgs, value, grad);
+				std::fill(hd.begin(), hd.end(), ValueT());
+				HessianVectorEvaluator<F>::accumulate(xArgs, d, ValueT(1), hd);
+
+				for (IndexType idx = 0; idx < d.size(); idx++) {
+					slope += grad[idx] * d[idx];
+					curvature += hd[idx] * d[idx];
+				}
+
+				model.reset(slope, curvature, rk);
+				A::accumulate_ray(xArgs, d, model);
+			}
+
+			/**
+			 * hv = hessian( F(x, r[k]) ) * v without forming the matrix, for TruncatedNewtonDescent.
+			 * Costs about one evaluation of the active gi.
+			 */
+			void hessian_vector(const VecT& xArgs, const VecT& v, VecT& hv) const {
+				hv = v;
+				std::fill(hv.begin(), hv.end(), ValueT());
+				HessianVectorEvaluator<F>::accumulate(xArgs, v, ValueT(1), hv);
+				A::accumulate_hessian_vector(xArgs, v, rk, hv);
+			}
+
+			VecT gradient(const VecT& xArgs) const {
 				VecT fGrad = F::gradient(xArgs);
 				VecT alphaGrad = A::gradient(xArgs);
-				bool tmp = true;
 				for( IndexType idx = 0; idx < alphaGrad.size(); idx++)
-					alphaGrad[ idx ] *= ThisT::sC;
+					alphaGrad[ idx ] *= rk;
 				
 				
 				assert(fGrad.size() == alphaGrad.size());
@@ -209,32 +446,145 @@ namespace tpr {
 				return rval;
 			}
 		};
-		
+
+		using FxRk = FxRkFunction<ValueType, VectorT, TargetF, Alpha>;
+
+		/**
+		 * min( f(x) ) of a linear program by SimplexSolver, on the CsrModel ModelTable builds from the types.
+		 * Whether Fx and every gi are linear is known at compile time, see LinearModel, the quantiles of the
+		 * chance rows only at runtime, they are read off the types before the model is built.
+		 */
+		template<bool Linear = LinearModel<TargetF, GiFuncTypes ...>::value, typename Dummy = void>
+		struct LinearProgram {
+			/**
+			 * @param it	out: simplex iterations
+			 * @return false for a model with a quantile > 0 or without optimal vertex, the penalty loop takes over then
+			 */
+			static bool solve(const Box<ValueType>& bounds, VectorT& xArgs, IndexType& it) {
+				if (!LinearModel<TargetF, GiFuncTypes ...>::holds())
+					return false;
+
+				const CsrModel model = ModelTable<TargetF, GiFuncTypes ...>::build();
+				SimplexSolver<IndexType> simplex(model);
+				simplex.setBounds(bounds);
+				const CsrModel::VectorT x = simplex.solve();
+				it = simplex.iterations();
+
+				if (simplex.status() != SimplexSolver<IndexType>::Optimal)
+					return false;
+
+				std::copy(x.begin(), x.end(), std::begin(xArgs));
+				return true;
+			}
+		};
+
+		template<typename Dummy>
+		struct LinearProgram<false, Dummy> {
+			static bool solve(const Box<ValueType>&, VectorT&, IndexType&) {
+				return false;
+			}
+		};
+
+	private: // == MEMBERS ==
+		ValueType	mC			= DefaultC;		//!< r[k]
+		Box<ValueType>	mBounds;				//!< bounds of x, enforced by the descent
+		ValueType	mLambda		= ValueType();	//!< step of the last inner solve
+		IndexType	mOuterIterations = 0;		//!< inner solves done
+		IndexType	mInnerIterations = 0;		//!< descent iterations over all inner solves
+		IndexType	mTruncatedSolves = 0;		//!< inner solves the descent ended at its MaxIterations
+		bool		mLinearProgram = false;		//!< solve a linear program by the simplex method, see setLinearProgram
 
 	public: // == METHODS ==
+		/**
+		 * max( 0, max( gi(x) ) ), zero for a feasible x
+		 */
+		static ValueType infeasibility(const VectorT& xArgs) {
+			ValueType values[] = { ValueType(), GiFuncTypes::apply(xArgs) ... };
+			return *std::max_element(std::begin(values), std::end(values));
+		}
+
+		/**
+		 * solves with a solver object of its own, see solve.
+		 */
+		template<template<typename, typename> class GradientDescentT = StepSplitGradientDescent>
 		static VectorT evaluate(const VectorT& x0) {
-			ThisT::sC = DefaultC;
+			ThisT solver;
+			return solver.template solve<GradientDescentT>(x0);
+		}
+
+		/**
+		 * lower <= x <= upper, kept by projection instead of penalty terms,
+		 * so only descents with Projects set may solve: StepSplitGradientDescent, FastestGradientDescent, SpectralGradientDescent,
+		 * LBFGSDescent, ConjugateGradientDescent. solve throws std::invalid_argument for the others.
+		 * @param bounds	N entries or empty to drop them
+		 */
+		void setBounds(const Box<ValueType>& bounds) {
+			assert(bounds.empty() || bounds.size() == N);
+			mBounds = bounds;
+		}
+
+		const Box<ValueType>& bounds() const {
+			return mBounds;
+		}
+
+		/**
+		 * solve takes a linear program, see LinearProgram, to SimplexSolver instead of the descent when set,
+		 * x0 and GradientDescentT are not used then and innerIterations() counts the simplex iterations.
+		 * An infeasible or unbounded one, or a model with a quantile > 0, goes through the penalty loop. Off by default.
+		 */
+		void setLinearProgram(bool enabled) {
+			mLinearProgram = enabled;
+		}
+
+		bool linearProgram() const {
+			return mLinearProgram;
+		}
+
+		/**
+		 * The state of a solve lives in this object, so separate objects may solve concurrently.
+		 * With setLinearProgram( true ) a linear program is solved by the simplex method instead.
+		 * @tparam GradientDescentT	minimizer of F(x, r[k]), any class template with
+		 *		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it)
+		 *		and a Lambda constant: StepSplitGradientDescent, ConstStepGradientDescent, LBFGS<Depth>::Descent, PolakRibiereDescent, NewtonDescent, TruncatedNewtonDescent,
+		 *		LevenbergMarquardtDescent, ExactStepGradientDescent, BarzilaiBorweinDescent ...
+		 */
+		template<template<typename, typename> class GradientDescentT = StepSplitGradientDescent>
+		VectorT solve(const VectorT& x0) {
+			mC = DefaultC;
+			mOuterIterations = 0;
+			mInnerIterations = 0;
+			mTruncatedSolves = 0;
 			VectorT xArgs = x0;
+
+			if (mLinearProgram && LinearProgram<>::solve(mBounds, xArgs, mInnerIterations))
+				return xArgs;
+
+			xArgs = x0;
+			mInnerIterations = 0;
 			// prepare new penalty function
-			using FxRk = FxRkFunction<ValueType, VectorT, TargetF, Alpha>;
+			const FxRk fxRk(mC, mBounds);
 
-			using GradientDescent = StepSplitGradientDescent<FxRk>;
-			//using GradientDescent = ConstStepGradientDescent<FxRk>;
+			using GradientDescent = GradientDescentT<FxRk, IndexType>;
+			requireProjection<GradientDescent>(mBounds);
+			mBounds.project(xArgs);
 			IndexType idx = 0;
 
 			for (; idx < MaxPIterations; idx++ ) {
 				IndexType it = 0;
 
 				// find min( F(x, rk) )
-				ValueType l = GradientDescent::Lambda;
-				VectorT xOptLoc = GradientDescent::calculate(xArgs, l, it);
+				mLambda = GradientDescent::Lambda;
+				VectorT xOptLoc = GradientDescent::calculate(fxRk, xArgs, mLambda, it);
 				ValueType eps = std::fabs(TargetF::apply(xOptLoc) - TargetF::apply(xArgs));
+				mOuterIterations++;
+				mInnerIterations += it;
+				mTruncatedSolves += it >= GradientDescent::MaxIterations ? 1 : 0;
 
 				if (eps <= Epsilon) {
 					return xOptLoc;
 				}else {
 					// r[k+1] = r[k] * B
-					ThisT::sC *= ThisT::Beta;
+					mC *= ThisT::Beta;
 					xArgs = xOptLoc;
 				}
 			}
@@ -245,12 +595,34 @@ namespace tpr {
 
 			return {};
 		}
+
+		ValueType coefficient() const {
+			return mC;
+		}
+
+		ValueType lambda() const {
+			return mLambda;
+		}
+
+		IndexType outerIterations() const {
+			return mOuterIterations;
+		}
+
+		IndexType innerIterations() const {
+			return mInnerIterations;
+		}
+
+		/**
+		 * inner solves of the last solve that ran out of descent iterations, a bounded descent returns its best x then
+		 */
+		IndexType truncatedSolves() const {
+			return mTruncatedSolves;
+		}
 	};
 
-	template<
-		typename FT, //minimizing function
-		typename IndexType,
-		typename ... GiFuncTypes
-	>
-	typename PenaltyFunction<FT, IndexType, GiFuncTypes ...>::ValueType PenaltyFunction<FT, IndexType, GiFuncTypes ...>::sC = 0.0f;
+	/**
+	 * penalty function with R1(gi(x)) = max( 0, gi(x) )^2
+	 */
+	template<typename FT, typename IndexType, typename ... GiFuncTypes>
+	using PenaltyFunction = BasicPenaltyFunction<IntegerPower<2>, FT, IndexType, GiFuncTypes ...>;
 }
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+
+namespace tpr {
+	/**
+	 * @brief x^P for a compile-time P >= 0, expanded to multiplications by squaring:
+	 * x^4 = ( x^2 )^2, x^5 = x^4 * x.
+	 */
+	template<int P, bool Odd = (P % 2 == 1)>
+	struct PowerOf {
+		template<typename T>
+		static T apply(const T& x) {
+			T half = PowerOf<P / 2>::apply(x);
+			return half * half;
+		}
+	};
+
+	template<int P>
+	struct PowerOf<P, true> {
+		template<typename T>
+		static T apply(const T& x) {
+			return PowerOf<P - 1>::apply(x) * x;
+		}
+	};
+
+	template<>
+	struct PowerOf<1, true> {
+		template<typename T>
+		static T apply(const T& x) {
+			return x;
+		}
+	};
+
+	template<>
+	struct PowerOf<0, false> {
+		template<typename T>
+		static T apply(const T&) {
+			return T(1);
+		}
+	};
+
+	/**
+	 * @brief exponent policy of the penalty term R1(g) = max( 0, g )^P.
+	 * apply:		max( 0, g )^P, works on plain values and on Dual
+	 * evaluate:	for an active g > 0, value = g^P and slope = P * g^(P - 1), sharing g^(P - 1)
+	 * curvature:	for an active g > 0, P * (P - 1) * g^(P - 2), used by NewtonDescent
+	 *
+	 * IntegerPower<P> multiplies, PowerOf<P> is unrolled at compile time.
+	 */
+	template<int P>
+	struct IntegerPower {
+		static_assert(P >= 2, "IntegerPower<1> is the exact penalty, lower exponents are not convex");
+
+		template<typename T>
+		static T apply(const T& g) {
+			using std::max;
+			return PowerOf<P>::apply(max(T(), g));
+		}
+
+		template<typename T>
+		static void evaluate(T g, T& value, T& slope) {
+			T head = PowerOf<P - 1>::apply(g);
+			value = head * g;
+			slope = P * head;
+		}
+
+		template<typename T>
+		static T curvature(T g) {
+			return P * (P - 1) * PowerOf<P - 2>::apply(g);
+		}
+	};
+
+	/**
+	 * @brief exact (L1) penalty R1(g) = max( 0, g ).
+	 * The minimizer of F(x, r[k]) is feasible once r[k] exceeds the largest multiplier,
+	 * but F is not differentiable on gi(x) = 0, descents stall there instead of converging smoothly.
+	 */
+	template<>
+	struct IntegerPower<1> {
+		template<typename T>
+		static T apply(const T& g) {
+			using std::max;
+			return max(T(), g);
+		}
+
+		template<typename T>
+		static void evaluate(T g, T& value, T& slope) {
+			value = g;
+			slope = T(1);
+		}
+
+		template<typename T>
+		static T curvature(T) {
+			return T();
+		}
+	};
+
+	using ExactPenalty = IntegerPower<1>;
+
+	/**
+	 * @brief R1(g) = max( 0, g )^( Num / Den ) for a non-integer exponent, goes through pow.
+	 * e.g. RealPower<3, 2> for max( 0, g )^1.5
+	 */
+	template<int Num, int Den>
+	struct RealPower {
+		static_assert(Den > 0 && Num >= Den, "exponents below 1 are not convex");
+
+		static constexpr double Exponent() {
+			return double(Num) / Den;
+		}
+
+		template<typename T>
+		static T apply(const T& g) {
+			using std::max;
+			using std::pow;
+			return pow(max(T(), g), Exponent());
+		}
+
+		template<typename T>
+		static void evaluate(T g, T& value, T& slope) {
+			using std::pow;
+			T head = pow(g, Exponent() - 1);
+			value = head * g;
+			slope = Exponent() * head;
+		}
+
+		/**
+		 * grows without bound as g -> 0 for exponents below 2
+		 */
+		template<typename T>
+		static T curvature(T g) {
+			using std::pow;
+			return Exponent() * (Exponent() - 1) * pow(g, Exponent() - 2);
+		}
+	};
+}// namespace tpr
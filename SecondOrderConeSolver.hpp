@@ -0,0 +1,720 @@
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+
+#include "Bounds.hpp"
+#include "Hessian.hpp"
+#include "CsrModel.hpp"
+
+namespace tpr {
+	/**
+	 * @brief primal-dual interior point solver for the second-order cone program a CsrModel describes.
+	 * A chance row M[i] * x + quantile[i] * sqrt( sum( V[i][k] * x[k]^2 ) ) <= resource[i], quantile[i] >= 0, is the cone
+	 *	( resource[i] - M[i] * x, -quantile[i] * sqrt( V[i][k] ) * x[k] ... ) in Q = { ( u0, u1 ) : u0 >= | u1 | },
+	 * linear rows and finite box bounds are rows of the nonnegative orthant, so the model reads
+	 *	min( c' * x ) with G * x + s = h, s in K
+	 * and its dual max( -h' * z ) with G' * z + c = 0, z in K, K the orthant times one Q per chance row.
+	 *
+	 * Every iteration takes a Mehrotra predictor-corrector step towards the central path s o z = mu * e,
+	 * in the Nesterov-Todd scaling W * z = W^-1 * s = lambda, which treats the primal and the dual alike:
+	 *	( G' * W^-2 * G ) * dx = -rx - G' * W^-1 * ( W^-1 * rz + u ),	rx = G' * z + c, rz = G * x + s - h
+	 * the other unknowns follow from dx. The N x N matrix is dense and factorized once per iteration by ModifiedCholesky,
+	 * O(N^3) as in NewtonDescent, a chance row adds a low rank update of its own block.
+	 * Neither x nor z has to be feasible at the start, the residuals and the gap s' * z shrink together
+	 * in a few dozen iterations, independent of the conditioning that holds PenaltyFunction to short steps.
+	 * Vandenberghe "The CVXOPT linear and quadratic cone program solvers", 2010, coneqp without P and equality rows.
+	 */
+	template<typename IndexType = size_t>
+	class SecondOrderConeSolver {
+	public: // == TYPES ==
+		using ValueType = CsrModelView::ValueType;
+		using VectorT	= CsrModelView::VectorT;
+
+		enum Status {
+			Optimal,		//!< residuals and gap below the tolerances
+			Infeasible,		//!< z certifies that no x satisfies the constraints
+			Unbounded,		//!< x is a direction along which c' * x decreases without bound
+			Unsolved		//!< MaxIterations or no step left, x is the iterate closest to the tolerances
+		};
+
+	public: // == CONSTANTS ==
+		static constexpr ValueType	FeasibilityEpsilon	= 1e-8;		//!< | rz | / max( 1, | h | ) and | rx | / max( 1, | c | ) to stop at
+		static constexpr ValueType	GapEpsilon			= 1e-8;		//!< s' * z / max( 1, | c' * x | ) to stop at
+		static constexpr ValueType	CertificateEpsilon	= 1e-9;		//!< | G' * z | / -h' * z, | G * x + s | / -c' * x of a certificate
+		static constexpr ValueType	StepFraction		= 0.99;		//!< part of the way to the cone boundary a step goes
+		static constexpr ValueType	MinStep				= 1e-10;	//!< shorter steps make no progress
+		static constexpr IndexType	MaxIterations		= 100;
+		static constexpr IndexType	Refinements			= 3;		//!< iterative refinement rounds of a Newton solve on a shifted factorization
+
+	private: // == MEMBERS ==
+		CsrModelView		mModel;
+		Box<ValueType>		mBounds;
+		CsrMatrix			mRows;				//!< orthant rows of G, the linear rows then the bounds
+		VectorT				mRowBounds;			//!< h of the orthant rows
+		std::vector<size_t>	mConeStart;			//!< offset of each cone in s and z, the orthant comes first
+		VectorT				mDeviations;		//!< quantile * sqrt( V ), parallel to chanceValues
+		VectorT				mWeights;			//!< orthant: w = sqrt( s / z ), cone: v of W, see Scale
+		VectorT				mBeta;				//!< ( ( s' * J * s ) / ( z' * J * z ) )^1/4 of each cone
+		VectorT				mLambda;			//!< W * z = W^-1 * s
+		VectorT				mEquilibration;		//!< D, the factorized matrix is D * H * D with unit diagonal
+		VectorT				mMultipliers;		//!< z per constraint of the model
+		Status				mStatus				= Unsolved;
+		IndexType			mIterations			= 0;
+		ValueType			mGap				= ValueType();
+		ValueType			mResidual			= ValueType();
+
+	public: // == METHODS ==
+		/**
+		 * @param model	the arrays are held by reference, see CsrModelView
+		 */
+		explicit SecondOrderConeSolver(const CsrModelView& model) : mModel(model) {}
+
+		/**
+		 * @param model	held by reference, its vectors must not change while the solver is used
+		 */
+		explicit SecondOrderConeSolver(const CsrModel& model) : mModel(model.view()) {}
+
+		/**
+		 * box bounds become rows of G, unlike the descents no projection is involved. An empty box bounds nothing.
+		 */
+		void setBounds(Box<ValueType> bounds) {
+			assert((bounds.empty() || bounds.size() == mModel.size()) && "one bound pair per variable");
+			mBounds = std::move(bounds);
+		}
+
+		const Box<ValueType>& bounds() const {
+			return mBounds;
+		}
+
+		/**
+		 * The iterates start from the least squares point of G * x + s = h, no x0 is taken.
+		 * @return the optimum when status() is Optimal, the certificate for Infeasible / Unbounded, see Status
+		 */
+		VectorT solve() {
+			Build();
+			const size_t N = mModel.size();
+			const size_t M = mConeStart.back();
+			const ValueType degree = static_cast<ValueType>(mRows.rows() + mModel.chanceRows);
+			const VectorT c(mModel.objective, mModel.objective + N);
+			VectorT h(M);
+			VectorT x(N), s(M), z(M), rx(N), rz(M), gz(N), gx(M), rhs(N);
+			VectorT u(M), dx(N), dz(M), ds(M), dxa(N), dza(M), dsa(M), product(M);
+			DenseMatrix<ValueType> H(N);
+			ModifiedCholesky<ValueType> factor;
+
+			std::copy(mRowBounds.begin(), mRowBounds.end(), h.begin());
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++)
+				h[mConeStart[cone]] = mModel.resources[cone];
+
+			const ValueType hNorm = std::max(ValueType(1.0), Norm(h));
+			const ValueType cNorm = std::max(ValueType(1.0), Norm(c));
+
+			// x = ( G' * G )^-1 * G' * h, z = -G * ( G' * G )^-1 * c, both moved inside K along e
+			Identity();
+			Assemble(H);
+			Factorize(H, factor);
+			MultiplyTranspose(h, rhs);
+			Solve(factor, rhs, x);
+			Multiply(x, s);
+
+			for (size_t idx = 0; idx < M; idx++)
+				s[idx] = h[idx] - s[idx];
+
+			Solve(factor, c, dx);
+			Multiply(dx, z);
+
+			for (size_t idx = 0; idx < M; idx++)
+				z[idx] = -z[idx];
+
+			Center(s);
+			Center(z);
+			mStatus = Unsolved;
+			VectorT bestX = x, bestZ = z;
+			ValueType bestScore = std::numeric_limits<ValueType>::infinity();
+			ValueType bestGap = ValueType(), bestResidual = ValueType();
+
+			for (mIterations = 0; mIterations < MaxIterations; mIterations++) {
+				MultiplyTranspose(z, gz);
+				Multiply(x, gx);
+
+				for (size_t idx = 0; idx < N; idx++)
+					rx[idx] = gz[idx] + c[idx];
+
+				for (size_t idx = 0; idx < M; idx++)
+					rz[idx] = gx[idx] + s[idx] - h[idx];
+
+				const ValueType objective = Dot(c, x);
+				mGap = Dot(s, z);
+				mResidual = std::max(Norm(rz) / hNorm, Norm(rx) / cNorm);
+
+				if (mResidual <= FeasibilityEpsilon && mGap <= GapEpsilon * std::max(ValueType(1.0), std::fabs(objective))) {
+					mStatus = Optimal;
+					break;
+				}
+
+				// rounding may end the solve with a worse iterate than an earlier one
+				const ValueType score = std::max(mResidual / FeasibilityEpsilon, mGap / (GapEpsilon * std::max(ValueType(1.0), std::fabs(objective))));
+
+				if (score < bestScore) {
+					bestScore = score;
+					bestX = x;
+					bestZ = z;
+					bestGap = mGap;
+					bestResidual = mResidual;
+				}
+
+				// G' * z -> 0 while h' * z -> -inf: the dual is unbounded, so the primal has no feasible x
+				const ValueType hz = Dot(h, z);
+
+				if (hz < 0 && Norm(gz) <= CertificateEpsilon * -hz) {
+					mStatus = Infeasible;
+					break;
+				}
+
+				// G * x + s -> 0 while c' * x -> -inf: x is a recession direction
+				for (size_t idx = 0; idx < M; idx++)
+					gx[idx] += s[idx];
+
+				if (objective < 0 && Norm(gx) <= CertificateEpsilon * -objective) {
+					mStatus = Unbounded;
+					break;
+				}
+
+				Scale(s, z);
+				Assemble(H);
+
+				// H holds NaN, the iterates left the representable range
+				if (!Factorize(H, factor))
+					break;
+
+				// predictor, lambda o ( ds + dz ) = -lambda o lambda
+				for (size_t idx = 0; idx < M; idx++)
+					u[idx] = -mLambda[idx];
+
+				Direction(factor, rx, rz, u, dxa, dza, dsa);
+				const ValueType affine = std::min(ValueType(1.0), std::min(Boundary(mLambda, dsa), Boundary(mLambda, dza)));
+				const ValueType mu = mGap / degree;
+				const ValueType sigma = (1 - affine) * (1 - affine) * (1 - affine);
+
+				// corrector, lambda o ( ds + dz ) = -lambda o lambda - dsa o dza + sigma * mu * e
+				Product(mLambda, mLambda, u);
+				Product(dsa, dza, product);
+
+				for (size_t idx = 0; idx < M; idx++)
+					product[idx] = -u[idx] - product[idx];
+
+				AddIdentity(sigma * mu, product);
+				Divide(mLambda, product, u);
+				Direction(factor, rx, rz, u, dx, dz, ds);
+
+				const ValueType step = std::min(ValueType(1.0), StepFraction * std::min(Boundary(mLambda, ds), Boundary(mLambda, dz)));
+
+				if (!(step >= MinStep))
+					break;
+
+				// back from the scaled space, ds = W * ds~, dz = W^-1 * dz~
+				Apply(ds, product, false);
+				Apply(dz, u, true);
+
+				for (size_t idx = 0; idx < N; idx++)
+					x[idx] += step * dx[idx];
+
+				for (size_t idx = 0; idx < M; idx++) {
+					s[idx] += step * product[idx];
+					z[idx] += step * u[idx];
+				}
+			}// for
+
+			if (mStatus == Unsolved) {
+				x = bestX;
+				z = bestZ;
+				mGap = bestGap;
+				mResidual = bestResidual;
+			}
+
+			// z of a linear row, z0 of a cone is the multiplier of gi(x) <= 0
+			mMultipliers.assign(z.begin(), z.begin() + mModel.linearRows);
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++)
+				mMultipliers.push_back(z[mConeStart[cone]]);
+
+			return x;
+		}
+
+		Status status() const {
+			return mStatus;
+		}
+
+		IndexType iterations() const {
+			return mIterations;
+		}
+
+		/**
+		 * s' * z of the last iterate, bounds c' * x - min( c' * x ) once the residuals vanish
+		 */
+		ValueType gap() const {
+			return mGap;
+		}
+
+		/**
+		 * max( | rz | / max( 1, | h | ), | rx | / max( 1, | c | ) ) of the last iterate
+		 */
+		ValueType residual() const {
+			return mResidual;
+		}
+
+		/**
+		 * Lagrange multipliers of the model constraints, linear rows first, as CsrModelView::constraintValues
+		 */
+		const VectorT& multipliers() const {
+			return mMultipliers;
+		}
+
+	private:
+		/**
+		 * orthant rows of G and h from the linear rows and the bounds, the cone offsets
+		 */
+		void Build() {
+			mRows = CsrMatrix();
+			mRowBounds.clear();
+
+			for (size_t row = 0; row < mModel.linearRows; row++) {
+				std::vector<std::pair<size_t, double>> entries;
+
+				for (CsrOffset k = mModel.linearStart[row]; k < mModel.linearStart[row + 1]; k++)
+					entries.emplace_back(mModel.linearColumns[k], mModel.linearValues[k]);
+
+				mRows.append(std::move(entries));
+				mRowBounds.push_back(mModel.bounds[row]);
+			}
+
+			// lower <= x[idx] is -x[idx] <= -lower, x[idx] <= upper as is
+			for (size_t idx = 0; idx < mBounds.size(); idx++) {
+				if (mBounds.lower(idx) > -std::numeric_limits<ValueType>::infinity()) {
+					mRows.append({ { idx, -1.0 } });
+					mRowBounds.push_back(-mBounds.lower(idx));
+				}
+
+				if (mBounds.upper(idx) < std::numeric_limits<ValueType>::infinity()) {
+					mRows.append({ { idx, 1.0 } });
+					mRowBounds.push_back(mBounds.upper(idx));
+				}
+			}
+
+			mConeStart.assign(1, mRows.rows());
+			mDeviations.clear();
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				assert(mModel.quantiles[cone] >= 0 && "a chance row with p < 0.5 is not convex");
+				const CsrOffset first = mModel.chanceStart[cone];
+				const CsrOffset last = mModel.chanceStart[cone + 1];
+
+				for (CsrOffset k = first; k < last; k++)
+					mDeviations.push_back(mModel.quantiles[cone] * std::sqrt(mModel.variances[k]));
+
+				mConeStart.push_back(mConeStart.back() + 1 + static_cast<size_t>(last - first));
+			}
+
+			mWeights.assign(mConeStart.back(), ValueType());
+			mBeta.assign(mModel.chanceRows, ValueType());
+			mLambda.assign(mConeStart.back(), ValueType());
+		}
+
+		/**
+		 * out = G * x, a cone is ( M[i] * x, quantile * sqrt( V[i][k] ) * x[k] ... ), s = h - G * x negates the tail
+		 */
+		void Multiply(const VectorT& x, VectorT& out) const {
+			for (size_t row = 0; row < mRows.rows(); row++) {
+				ValueType sum = 0.0;
+
+				for (CsrOffset k = mRows.rowStart[row]; k < mRows.rowStart[row + 1]; k++)
+					sum += mRows.values[k] * x[mRows.columns[k]];
+
+				out[row] = sum;
+			}
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				size_t offset = mConeStart[cone];
+				ValueType sum = 0.0;
+
+				for (CsrOffset k = mModel.chanceStart[cone]; k < mModel.chanceStart[cone + 1]; k++) {
+					const ValueType xk = x[mModel.chanceColumns[k]];
+					sum += mModel.chanceValues[k] * xk;
+					out[++offset] = mDeviations[k] * xk;
+				}
+
+				out[mConeStart[cone]] = sum;
+			}
+		}
+
+		/**
+		 * out = G' * z
+		 */
+		void MultiplyTranspose(const VectorT& z, VectorT& out) const {
+			std::fill(out.begin(), out.end(), ValueType());
+
+			for (size_t row = 0; row < mRows.rows(); row++)
+				for (CsrOffset k = mRows.rowStart[row]; k < mRows.rowStart[row + 1]; k++)
+					out[mRows.columns[k]] += mRows.values[k] * z[row];
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				size_t offset = mConeStart[cone];
+				const ValueType z0 = z[offset];
+
+				for (CsrOffset k = mModel.chanceStart[cone]; k < mModel.chanceStart[cone + 1]; k++)
+					out[mModel.chanceColumns[k]] += mModel.chanceValues[k] * z0 + mDeviations[k] * z[++offset];
+			}
+		}
+
+		/**
+		 * W = I: w = 1 on the orthant, w = e and beta = 1 on the cones
+		 */
+		void Identity() {
+			std::fill(mWeights.begin(), mWeights.end(), ValueType());
+			std::fill(mWeights.begin(), mWeights.begin() + mRows.rows(), ValueType(1.0));
+			std::fill(mBeta.begin(), mBeta.end(), ValueType(1.0));
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++)
+				mWeights[mConeStart[cone]] = 1.0;
+		}
+
+		/**
+		 * Nesterov-Todd scaling of s and z and lambda = W * z.
+		 * cone: s~ = s / sqrt( s' * J * s ), z~ = z / sqrt( z' * J * z ), gamma = sqrt( ( 1 + s~' * z~ ) / 2 ),
+		 * w~ = ( s~ + J * z~ ) / ( 2 * gamma ) has ( 2 * w~ * w~' - J ) * z~ = s~, W is its square root:
+		 * v = ( w~ + e ) / sqrt( 2 * ( w~0 + 1 ) ), W = beta * ( 2 * v * v' - J ), W^-1 = ( 2 * J * v * v' * J - J ) / beta, J = diag( 1, -I )
+		 */
+		void Scale(const VectorT& s, const VectorT& z) {
+			for (size_t row = 0; row < mRows.rows(); row++) {
+				mWeights[row] = std::sqrt(s[row] / z[row]);
+				mLambda[row] = std::sqrt(s[row] * z[row]);
+			}
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				const size_t first = mConeStart[cone];
+				const size_t last = mConeStart[cone + 1];
+				const ValueType sNorm = std::sqrt(JNorm(s, first, last));
+				const ValueType zNorm = std::sqrt(JNorm(z, first, last));
+				ValueType sz = 0.0;
+
+				for (size_t idx = first; idx < last; idx++)
+					sz += s[idx] * z[idx];
+
+				const ValueType gamma = std::sqrt((1 + sz / (sNorm * zNorm)) / 2);
+				const ValueType w0 = (s[first] / sNorm + z[first] / zNorm) / (2 * gamma);
+				const ValueType norm = std::sqrt(2 * (w0 + 1));
+				mWeights[first] = (w0 + 1) / norm;
+
+				for (size_t idx = first + 1; idx < last; idx++)
+					mWeights[idx] = (s[idx] / sNorm - z[idx] / zNorm) / (2 * gamma * norm);
+
+				mBeta[cone] = std::sqrt(sNorm / zNorm);
+			}
+
+			Apply(z, mLambda, false, mRows.rows());
+		}
+
+		/**
+		 * out = W * y, or W^-1 * y with inverse, on the blocks from the orthant row first on
+		 */
+		void Apply(const VectorT& y, VectorT& out, bool inverse, size_t first = 0) const {
+			for (size_t row = first; row < mRows.rows(); row++)
+				out[row] = inverse ? y[row] / mWeights[row] : y[row] * mWeights[row];
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				const size_t start = mConeStart[cone];
+				const size_t end = mConeStart[cone + 1];
+				// W * y = beta * ( 2 * v * ( v' * y ) - J * y ), W^-1 * y = ( 2 * J * v * ( v' * J * y ) - J * y ) / beta
+				const ValueType sign = inverse ? -1.0 : 1.0;
+				ValueType wy = mWeights[start] * y[start];
+
+				for (size_t idx = start + 1; idx < end; idx++)
+					wy += sign * mWeights[idx] * y[idx];
+
+				const ValueType scale = inverse ? 1 / mBeta[cone] : mBeta[cone];
+				out[start] = scale * (2 * mWeights[start] * wy - y[start]);
+
+				for (size_t idx = start + 1; idx < end; idx++)
+					out[idx] = scale * (2 * sign * mWeights[idx] * wy + y[idx]);
+			}
+		}
+
+		/**
+		 * H = G' * W^-2 * G.
+		 * cone: ( W^-1 * G )' * ( W^-1 * G ) = ( 4 * v' * v * p * p' - 2 * ( p * r' + r * p' ) + G' * G ) / beta^2,
+		 * p = G' * J * v, r = G' * v, G' * G = M' * M + diag( quantile^2 * V ) on the columns of the row
+		 */
+		void Assemble(DenseMatrix<ValueType>& H) const {
+			H.fill(ValueType());
+
+			for (size_t row = 0; row < mRows.rows(); row++) {
+				const ValueType weight = 1 / (mWeights[row] * mWeights[row]);
+
+				for (CsrOffset j = mRows.rowStart[row]; j < mRows.rowStart[row + 1]; j++)
+					for (CsrOffset k = mRows.rowStart[row]; k < mRows.rowStart[row + 1]; k++)
+						H(mRows.columns[j], mRows.columns[k]) += weight * mRows.values[j] * mRows.values[k];
+			}
+
+			VectorT p, r;
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				const CsrOffset first = mModel.chanceStart[cone];
+				const CsrOffset last = mModel.chanceStart[cone + 1];
+				const size_t start = mConeStart[cone];
+				const ValueType w0 = mWeights[start];
+				const ValueType weight = 1 / (mBeta[cone] * mBeta[cone]);
+				ValueType ww = w0 * w0;
+				p.assign(static_cast<size_t>(last - first), ValueType());
+				r.assign(p.size(), ValueType());
+
+				for (CsrOffset k = first; k < last; k++) {
+					const ValueType wk = mWeights[start + 1 + (k - first)];
+					ww += wk * wk;
+					p[k - first] = mModel.chanceValues[k] * w0 - mDeviations[k] * wk;
+					r[k - first] = mModel.chanceValues[k] * w0 + mDeviations[k] * wk;
+				}
+
+				for (CsrOffset j = first; j < last; j++) {
+					const size_t a = j - first;
+					const CsrColumn col = mModel.chanceColumns[j];
+					H(col, col) += weight * mDeviations[j] * mDeviations[j];
+
+					for (CsrOffset k = first; k < last; k++) {
+						const size_t b = k - first;
+						H(col, mModel.chanceColumns[k]) += weight * (4 * ww * p[a] * p[b] - 2 * (p[a] * r[b] + r[a] * p[b])
+							+ mModel.chanceValues[j] * mModel.chanceValues[k]);
+					}
+				}
+			}
+		}
+
+		/**
+		 * factorizes D * H * D, D = diag( H )^-1/2. W^-2 spans many orders of magnitude as s o z -> 0,
+		 * with a unit diagonal the rounding left in the factorization stays at the level of the direction.
+		 */
+		bool Factorize(DenseMatrix<ValueType>& H, ModifiedCholesky<ValueType>& factor) {
+			const size_t N = H.size();
+			mEquilibration.resize(N);
+
+			for (size_t idx = 0; idx < N; idx++)
+				mEquilibration[idx] = H(idx, idx) > 0 ? 1 / std::sqrt(H(idx, idx)) : 1.0;
+
+			for (size_t row = 0; row < N; row++)
+				for (size_t col = 0; col < N; col++)
+					H(row, col) *= mEquilibration[row] * mEquilibration[col];
+
+			return factor.factorize(H);
+		}
+
+		/**
+		 * x = H^-1 * b = D * ( D * H * D )^-1 * D * b
+		 */
+		void Solve(const ModifiedCholesky<ValueType>& factor, const VectorT& b, VectorT& x) const {
+			VectorT scaled(b.size());
+
+			for (size_t idx = 0; idx < b.size(); idx++)
+				scaled[idx] = mEquilibration[idx] * b[idx];
+
+			factor.solve(scaled, x);
+
+			for (size_t idx = 0; idx < b.size(); idx++)
+				x[idx] *= mEquilibration[idx];
+		}
+
+		/**
+		 * solves the scaled Newton system for lambda o ( ds + dz ) = lambda o u:
+		 * v = W^-1 * rz + u, H * dx = -rx - G' * W^-1 * v, dz = W^-1 * G * dx + v, ds = u - dz
+		 */
+		void Direction(const ModifiedCholesky<ValueType>& factor, const VectorT& rx, const VectorT& rz, const VectorT& u,
+			VectorT& dx, VectorT& dz, VectorT& ds) const {
+			const size_t M = u.size();
+			VectorT v(M), t(M), rhs(rx.size()), correction(rx.size()), refined(rx.size());
+			Apply(rz, v, true);
+
+			for (size_t idx = 0; idx < M; idx++)
+				v[idx] += u[idx];
+
+			Apply(v, t, true);
+			MultiplyTranspose(t, rhs);
+
+			for (size_t idx = 0; idx < rhs.size(); idx++)
+				rhs[idx] = -rx[idx] - rhs[idx];
+
+			Solve(factor, rhs, dx);
+
+			// ModifiedCholesky shifted the matrix, rounds against the exact G' * W^-2 * G recover the direction
+			for (IndexType round = 0; factor.shift() > 0 && round < Refinements; round++) {
+				Multiply(dx, t);
+				Apply(t, dz, true);
+				Apply(dz, t, true);
+				MultiplyTranspose(t, correction);
+
+				for (size_t idx = 0; idx < rhs.size(); idx++)
+					correction[idx] = rhs[idx] - correction[idx];
+
+				Solve(factor, correction, refined);
+
+				for (size_t idx = 0; idx < rhs.size(); idx++)
+					dx[idx] += refined[idx];
+			}
+
+			Multiply(dx, t);
+			Apply(t, dz, true);
+
+			for (size_t idx = 0; idx < M; idx++) {
+				dz[idx] += v[idx];
+				ds[idx] = u[idx] - dz[idx];
+			}
+		}
+
+		/**
+		 * out = a o b, elementwise on the orthant, ( a' * b, a0 * b1 + b0 * a1 ) on a cone
+		 */
+		void Product(const VectorT& a, const VectorT& b, VectorT& out) const {
+			for (size_t row = 0; row < mRows.rows(); row++)
+				out[row] = a[row] * b[row];
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				const size_t first = mConeStart[cone];
+				const size_t last = mConeStart[cone + 1];
+				ValueType dot = 0.0;
+
+				for (size_t idx = first; idx < last; idx++)
+					dot += a[idx] * b[idx];
+
+				for (size_t idx = first + 1; idx < last; idx++)
+					out[idx] = a[first] * b[idx] + b[first] * a[idx];
+
+				out[first] = dot;
+			}
+		}
+
+		/**
+		 * u with l o u = r, l inside K:
+		 * u0 = ( l0 * r0 - l1' * r1 ) / ( l' * J * l ), u1 = ( r1 - u0 * l1 ) / l0 on a cone
+		 */
+		void Divide(const VectorT& l, const VectorT& r, VectorT& u) const {
+			for (size_t row = 0; row < mRows.rows(); row++)
+				u[row] = r[row] / l[row];
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				const size_t first = mConeStart[cone];
+				const size_t last = mConeStart[cone + 1];
+				ValueType cross = l[first] * r[first];
+
+				for (size_t idx = first + 1; idx < last; idx++)
+					cross -= l[idx] * r[idx];
+
+				const ValueType u0 = cross / JNorm(l, first, last);
+
+				for (size_t idx = first + 1; idx < last; idx++)
+					u[idx] = (r[idx] - u0 * l[idx]) / l[first];
+
+				u[first] = u0;
+			}
+		}
+
+		/**
+		 * out += coef * e, e = 1 on the orthant, ( 1, 0 ) on a cone
+		 */
+		void AddIdentity(ValueType coef, VectorT& out) const {
+			for (size_t row = 0; row < mRows.rows(); row++)
+				out[row] += coef;
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++)
+				out[mConeStart[cone]] += coef;
+		}
+
+		/**
+		 * moves u inside K along e when it is not well inside already:
+		 * u += ( 1 + t ) * e, t = -min eigenvalue, u0 - | u1 | on a cone
+		 */
+		void Center(VectorT& u) const {
+			ValueType depth = std::numeric_limits<ValueType>::infinity();
+
+			for (size_t row = 0; row < mRows.rows(); row++)
+				depth = std::min(depth, u[row]);
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				const size_t first = mConeStart[cone];
+				ValueType tail = 0.0;
+
+				for (size_t idx = first + 1; idx < mConeStart[cone + 1]; idx++)
+					tail += u[idx] * u[idx];
+
+				depth = std::min(depth, u[first] - std::sqrt(tail));
+			}
+
+			if (depth <= 1e-8 * std::max(ValueType(1.0), Norm(u)))
+				AddIdentity(1 - depth, u);
+		}
+
+		/**
+		 * max( t ) with u + t * d in K, u inside K, +inf when d never leaves it.
+		 * On a cone ( u0 + t * d0 )^2 - | u1 + t * d1 |^2 = a * t^2 + 2 * b * t + c reaches zero first at
+		 * t = c / ( -b + sqrt( b^2 - a * c ) ), written so no root is lost to cancellation.
+		 */
+		ValueType Boundary(const VectorT& u, const VectorT& d) const {
+			ValueType rval = std::numeric_limits<ValueType>::infinity();
+
+			for (size_t row = 0; row < mRows.rows(); row++)
+				if (d[row] < 0)
+					rval = std::min(rval, -u[row] / d[row]);
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				const size_t first = mConeStart[cone];
+				const size_t last = mConeStart[cone + 1];
+				ValueType a = d[first] * d[first];
+				ValueType b = u[first] * d[first];
+				const ValueType c = JNorm(u, first, last);
+
+				for (size_t idx = first + 1; idx < last; idx++) {
+					a -= d[idx] * d[idx];
+					b -= u[idx] * d[idx];
+				}
+
+				const ValueType discriminant = b * b - a * c;
+
+				if (discriminant < 0)
+					continue;
+
+				const ValueType denominator = -b + std::sqrt(discriminant);
+
+				if (denominator > 0)
+					rval = std::min(rval, c / denominator);
+			}
+
+			return rval;
+		}
+
+		/**
+		 * u0^2 - | u1 |^2 of the cone [ first, last )
+		 */
+		static ValueType JNorm(const VectorT& u, size_t first, size_t last) {
+			ValueType rval = u[first] * u[first];
+
+			for (size_t idx = first + 1; idx < last; idx++)
+				rval -= u[idx] * u[idx];
+
+			return rval;
+		}
+
+		static ValueType Dot(const VectorT& a, const VectorT& b) {
+			ValueType rval = 0.0;
+
+			for (size_t idx = 0; idx < a.size(); idx++)
+				rval += a[idx] * b[idx];
+
+			return rval;
+		}
+
+		static ValueType Norm(const VectorT& a) {
+			return std::sqrt(Dot(a, a));
+		}
+	};
+}// namespace tpr
@@ -0,0 +1,505 @@
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+
+#include "Bounds.hpp"
+#include "CsrModel.hpp"
+
+namespace tpr {
+	/**
+	 * @brief bounded revised simplex method for a CsrModel without cones, every chance row with quantile 0:
+	 *	min( c' * x ) with A * x + s = b, s >= 0, lower <= x <= upper
+	 * A holds the linear rows and the chance rows M[i] * x <= resource[i]. The bounds come from a Box, an empty one
+	 * leaves x free; a nonbasic x sits at one of its bounds, or at 0 when it has none, and a bound flip needs no pivot.
+	 * The start basis is the slack of each row, a row the nonbasic x violate gets an artificial variable instead,
+	 * phase 1 drives their sum to zero, phase 2 minimizes c' * x. Entering variables are priced by Dantzig's rule,
+	 * after DegenerateLimit pivots without progress by Bland's rule, which cannot cycle.
+	 * B^-1 is dense, updated per pivot in O(M^2) and computed anew every RefactorInterval pivots.
+	 * The result is a vertex, exact up to rounding, so a small model takes microseconds instead of the
+	 * thousands of gradient steps PenaltyFunction spends approaching it from outside.
+	 * Chvatal "Linear programming", 1983, chapters 7 and 8.
+	 */
+	template<typename IndexType = size_t>
+	class SimplexSolver {
+	public: // == TYPES ==
+		using ValueType = CsrModelView::ValueType;
+		using VectorT	= CsrModelView::VectorT;
+
+		enum Status {
+			Optimal,		//!< a vertex with no improving edge
+			Infeasible,		//!< phase 1 ends with a positive sum of artificial variables
+			Unbounded,		//!< an edge along which c' * x decreases without bound
+			Unsolved		//!< MaxIterations reached
+		};
+
+	public: // == CONSTANTS ==
+		static constexpr ValueType	FeasibilityEpsilon	= 1e-9;		//!< violation of a bound taken as none, relative to max( 1, | b | )
+		static constexpr ValueType	OptimalityEpsilon	= 1e-9;		//!< reduced cost taken as zero
+		static constexpr ValueType	PivotEpsilon		= 1e-9;		//!< smallest entry of B^-1 * a a ratio test pivots on
+		static constexpr IndexType	RefactorInterval	= 64;
+		static constexpr IndexType	DegenerateLimit		= 50;		//!< zero length steps before Bland's rule
+		static constexpr IndexType	MaxIterations		= 100'000;
+
+	private: // == MEMBERS ==
+		static constexpr size_t		None	= static_cast<size_t>(-1);
+
+		CsrModelView		mModel;
+		Box<ValueType>		mBounds;
+		size_t				mRowCount		= 0;	//!< M, linear rows then chance rows
+		size_t				mColumnCount	= 0;	//!< x, slacks, artificials
+		CsrMatrix			mColumns;				//!< A column by column, A' in CSR
+		VectorT				mRhs;					//!< b
+		std::vector<size_t>	mArtificialRow;			//!< row of each artificial variable
+		VectorT				mLower;
+		VectorT				mUpper;
+		VectorT				mCost;
+		VectorT				mValues;				//!< every variable, basic or not
+		std::vector<size_t>	mBasis;					//!< variable of each row of B
+		std::vector<size_t>	mPosition;				//!< row of B of a basic variable, None otherwise
+		std::vector<ValueType>	mInverse;			//!< B^-1, row major
+		VectorT				mMultipliers;
+		Status				mStatus			= Unsolved;
+		IndexType			mIterations		= 0;
+
+	public: // == METHODS ==
+		/**
+		 * @param model	the arrays are held by reference, see CsrModelView
+		 */
+		explicit SimplexSolver(const CsrModelView& model) : mModel(model) {}
+
+		/**
+		 * @param model	held by reference, its vectors must not change while the solver is used
+		 */
+		explicit SimplexSolver(const CsrModel& model) : mModel(model.view()) {}
+
+		/**
+		 * lower <= x <= upper, an empty box leaves every x free
+		 */
+		void setBounds(Box<ValueType> bounds) {
+			assert((bounds.empty() || bounds.size() == mModel.size()) && "one bound pair per variable");
+			mBounds = std::move(bounds);
+		}
+
+		const Box<ValueType>& bounds() const {
+			return mBounds;
+		}
+
+		/**
+		 * @return the optimal vertex when status() is Optimal, the last basic solution otherwise
+		 */
+		VectorT solve() {
+			Build();
+			mIterations = 0;
+			mStatus = Unsolved;
+
+			// phase 1: min( sum( artificials ) )
+			std::fill(mCost.begin(), mCost.end(), ValueType());
+
+			for (size_t idx = 0; idx < mArtificialRow.size(); idx++)
+				mCost[mModel.size() + mRowCount + idx] = 1.0;
+
+			if (!mArtificialRow.empty()) {
+				const Status phase = Iterate();
+				ValueType shortfall = 0.0;
+				ValueType scale = 1.0;
+
+				for (size_t idx = 0; idx < mArtificialRow.size(); idx++)
+					shortfall += mValues[mModel.size() + mRowCount + idx];
+
+				for (ValueType b : mRhs)
+					scale = std::max(scale, std::fabs(b));
+
+				if (phase == Unsolved || shortfall > FeasibilityEpsilon * scale) {
+					mStatus = phase == Unsolved ? Unsolved : Infeasible;
+					return Result();
+				}
+
+				// artificials are 0 from here on, one left in the basis leaves at the next pivot on its row
+				for (size_t idx = 0; idx < mArtificialRow.size(); idx++) {
+					const size_t var = mModel.size() + mRowCount + idx;
+					mUpper[var] = 0.0;
+					mValues[var] = 0.0;
+					mCost[var] = 0.0;
+				}
+
+				Refactor();
+			}
+
+			// phase 2: min( c' * x )
+			std::copy(mModel.objective, mModel.objective + mModel.size(), mCost.begin());
+			mStatus = Iterate();
+			return Result();
+		}
+
+		Status status() const {
+			return mStatus;
+		}
+
+		/**
+		 * pivots and bound flips of both phases
+		 */
+		IndexType iterations() const {
+			return mIterations;
+		}
+
+		/**
+		 * Lagrange multipliers of the rows, linear rows first, as CsrModelView::constraintValues
+		 */
+		const VectorT& multipliers() const {
+			return mMultipliers;
+		}
+
+	private:
+		/**
+		 * columns, bounds and the slack / artificial start basis, x at a bound or 0
+		 */
+		void Build() {
+			const size_t N = mModel.size();
+			mRowCount = mModel.linearRows + mModel.chanceRows;
+			std::vector<std::vector<std::pair<size_t, double>>> columns(N);
+			mRhs.assign(mRowCount, ValueType());
+
+			for (size_t row = 0; row < mModel.linearRows; row++) {
+				for (CsrOffset k = mModel.linearStart[row]; k < mModel.linearStart[row + 1]; k++)
+					columns[mModel.linearColumns[k]].emplace_back(row, mModel.linearValues[k]);
+
+				mRhs[row] = mModel.bounds[row];
+			}
+
+			for (size_t cone = 0; cone < mModel.chanceRows; cone++) {
+				assert(mModel.quantiles[cone] == 0 && "a chance row with quantile > 0 is no linear row, see SecondOrderConeSolver");
+				const size_t row = mModel.linearRows + cone;
+
+				for (CsrOffset k = mModel.chanceStart[cone]; k < mModel.chanceStart[cone + 1]; k++)
+					columns[mModel.chanceColumns[k]].emplace_back(row, mModel.chanceValues[k]);
+
+				mRhs[row] = mModel.resources[cone];
+			}
+
+			mColumns = CsrMatrix();
+
+			for (std::vector<std::pair<size_t, double>>& column : columns)
+				mColumns.append(std::move(column));
+
+			const ValueType infinity = std::numeric_limits<ValueType>::infinity();
+			mLower.assign(N + mRowCount, ValueType());
+			mUpper.assign(N + mRowCount, infinity);
+			mValues.assign(N + mRowCount, ValueType());
+
+			for (size_t idx = 0; idx < N; idx++) {
+				mLower[idx] = mBounds.empty() ? -infinity : mBounds.lower(idx);
+				mUpper[idx] = mBounds.empty() ? infinity : mBounds.upper(idx);
+				mValues[idx] = std::isfinite(mLower[idx]) ? mLower[idx] : std::isfinite(mUpper[idx]) ? mUpper[idx] : ValueType();
+			}
+
+			// s = b - A * x, a negative s is replaced in the basis by an artificial a = -s
+			VectorT residual = mRhs;
+
+			for (size_t col = 0; col < N; col++)
+				for (CsrOffset k = mColumns.rowStart[col]; k < mColumns.rowStart[col + 1]; k++)
+					residual[mColumns.columns[k]] -= mColumns.values[k] * mValues[col];
+
+			mArtificialRow.clear();
+			mBasis.resize(mRowCount);
+
+			for (size_t row = 0; row < mRowCount; row++) {
+				if (residual[row] >= 0) {
+					mBasis[row] = N + row;
+					mValues[N + row] = residual[row];
+				} else {
+					mBasis[row] = N + mRowCount + mArtificialRow.size();
+					mArtificialRow.push_back(row);
+				}
+			}
+
+			mColumnCount = N + mRowCount + mArtificialRow.size();
+			mLower.resize(mColumnCount, ValueType());
+			mUpper.resize(mColumnCount, infinity);
+			mValues.resize(mColumnCount, ValueType());
+			mCost.assign(mColumnCount, ValueType());
+			mPosition.assign(mColumnCount, size_t(None));
+
+			for (size_t row = 0; row < mRowCount; row++)
+				mPosition[mBasis[row]] = row;
+
+			Refactor();
+		}
+
+		/**
+		 * simplex iterations for the current mCost from the current basis
+		 */
+		Status Iterate() {
+			const size_t M = mRowCount;
+			VectorT duals(M), alpha(M);
+			IndexType degenerate = 0;
+			IndexType sinceRefactor = 0;
+
+			for (; mIterations < MaxIterations; mIterations++) {
+				if (sinceRefactor >= RefactorInterval) {
+					Refactor();
+					sinceRefactor = 0;
+				}
+
+				// y = B^-T * c[B]
+				std::fill(duals.begin(), duals.end(), ValueType());
+
+				for (size_t row = 0; row < M; row++) {
+					const ValueType cost = mCost[mBasis[row]];
+
+					if (cost != 0)
+						for (size_t col = 0; col < M; col++)
+							duals[col] += cost * mInverse[row * M + col];
+				}
+
+				// pricing, d[j] = c[j] - y' * a[j] against the room x[j] has to move
+				const bool bland = degenerate >= DegenerateLimit;
+				size_t entering = None;
+				ValueType direction = 0.0;
+				ValueType best = 0.0;
+
+				for (size_t var = 0; var < mColumnCount; var++) {
+					if (mPosition[var] != None)
+						continue;
+
+					const ValueType reduced = mCost[var] - Dot(var, duals);
+					ValueType dir = 0.0;
+
+					if (reduced < -OptimalityEpsilon && mValues[var] < mUpper[var])
+						dir = 1.0;
+					else if (reduced > OptimalityEpsilon && mValues[var] > mLower[var])
+						dir = -1.0;
+
+					if (dir != 0 && std::fabs(reduced) > best) {
+						entering = var;
+						direction = dir;
+						best = std::fabs(reduced);
+
+						if (bland)
+							break;
+					}
+				}
+
+				if (entering == None) {
+					Duals(duals);
+					return Optimal;
+				}
+
+				// alpha = B^-1 * a[entering], x[B] moves by -direction * t * alpha
+				Column(entering, alpha);
+				ValueType step = direction > 0 ? mUpper[entering] - mValues[entering] : mValues[entering] - mLower[entering];
+				size_t leaving = None;
+				ValueType pivot = 0.0;
+
+				for (size_t row = 0; row < M; row++) {
+					const ValueType rate = direction * alpha[row];
+					const size_t var = mBasis[row];
+					ValueType limit = std::numeric_limits<ValueType>::infinity();
+
+					if (rate > PivotEpsilon && std::isfinite(mLower[var]))
+						limit = std::max(ValueType(), (mValues[var] - mLower[var]) / rate);
+					else if (rate < -PivotEpsilon && std::isfinite(mUpper[var]))
+						limit = std::max(ValueType(), (mUpper[var] - mValues[var]) / -rate);
+					else
+						continue;
+
+					// ties go to the larger pivot, or to the lower index under Bland's rule
+					if (limit < step || (leaving != None && limit == step &&
+						(bland ? var < mBasis[leaving] : std::fabs(alpha[row]) > pivot))) {
+						step = limit;
+						leaving = row;
+						pivot = std::fabs(alpha[row]);
+					}
+				}
+
+				if (!std::isfinite(step))
+					return Unbounded;
+
+				degenerate = step > 0 ? 0 : degenerate + 1;
+				mValues[entering] += direction * step;
+
+				for (size_t row = 0; row < M; row++)
+					mValues[mBasis[row]] -= direction * step * alpha[row];
+
+				// x[entering] reached its other bound first, the basis stays
+				if (leaving == None)
+					continue;
+
+				// the leaving variable sits exactly on the bound it hit
+				const size_t var = mBasis[leaving];
+				mValues[var] = direction * alpha[leaving] > 0 ? mLower[var] : mUpper[var];
+				mPosition[var] = None;
+				mBasis[leaving] = entering;
+				mPosition[entering] = leaving;
+				Pivot(leaving, alpha);
+				sinceRefactor++;
+			}
+
+			return Unsolved;
+		}
+
+		/**
+		 * B^-1 for the new column alpha in row r: row r / alpha[r], row i - alpha[i] * row r
+		 */
+		void Pivot(size_t leaving, const VectorT& alpha) {
+			const size_t M = mRowCount;
+			const ValueType scale = 1 / alpha[leaving];
+
+			for (size_t col = 0; col < M; col++)
+				mInverse[leaving * M + col] *= scale;
+
+			for (size_t row = 0; row < M; row++) {
+				if (row == leaving || alpha[row] == 0)
+					continue;
+
+				const ValueType factor = alpha[row];
+
+				for (size_t col = 0; col < M; col++)
+					mInverse[row * M + col] -= factor * mInverse[leaving * M + col];
+			}
+		}
+
+		/**
+		 * B^-1 by Gauss-Jordan elimination with partial pivoting, then x[B] = B^-1 * ( b - N * x[N] ),
+		 * which drops the rounding the pivots accumulated
+		 */
+		void Refactor() {
+			const size_t M = mRowCount;
+			std::vector<ValueType> matrix(M * M, ValueType());
+			mInverse.assign(M * M, ValueType());
+
+			for (size_t row = 0; row < M; row++) {
+				mInverse[row * M + row] = 1.0;
+				Scatter(mBasis[row], row, matrix);
+			}
+
+			for (size_t col = 0; col < M; col++) {
+				size_t pivot = col;
+
+				for (size_t row = col + 1; row < M; row++)
+					if (std::fabs(matrix[row * M + col]) > std::fabs(matrix[pivot * M + col]))
+						pivot = row;
+
+				for (size_t k = 0; k < M; k++) {
+					std::swap(matrix[col * M + k], matrix[pivot * M + k]);
+					std::swap(mInverse[col * M + k], mInverse[pivot * M + k]);
+				}
+
+				const ValueType scale = 1 / matrix[col * M + col];
+
+				for (size_t k = 0; k < M; k++) {
+					matrix[col * M + k] *= scale;
+					mInverse[col * M + k] *= scale;
+				}
+
+				for (size_t row = 0; row < M; row++) {
+					const ValueType factor = matrix[row * M + col];
+
+					if (row == col || factor == 0)
+						continue;
+
+					for (size_t k = 0; k < M; k++) {
+						matrix[row * M + k] -= factor * matrix[col * M + k];
+						mInverse[row * M + k] -= factor * mInverse[col * M + k];
+					}
+				}
+			}
+
+			VectorT residual = mRhs;
+			VectorT column(M);
+
+			for (size_t var = 0; var < mColumnCount; var++)
+				if (mPosition[var] == None && mValues[var] != 0)
+					AddColumn(var, -mValues[var], residual);
+
+			for (size_t row = 0; row < M; row++) {
+				ValueType sum = 0.0;
+
+				for (size_t k = 0; k < M; k++)
+					sum += mInverse[row * M + k] * residual[k];
+
+				mValues[mBasis[row]] = sum;
+			}
+		}
+
+		/**
+		 * column of B: matrix[ * ][ position ] = a[var]
+		 */
+		void Scatter(size_t var, size_t position, std::vector<ValueType>& matrix) const {
+			VectorT column(mRowCount, ValueType());
+			AddColumn(var, 1.0, column);
+
+			for (size_t row = 0; row < mRowCount; row++)
+				matrix[row * mRowCount + position] = column[row];
+		}
+
+		/**
+		 * out += coef * a[var], slack columns are e[row], artificial columns -e[row]
+		 */
+		void AddColumn(size_t var, ValueType coef, VectorT& out) const {
+			const size_t N = mModel.size();
+
+			if (var < N) {
+				for (CsrOffset k = mColumns.rowStart[var]; k < mColumns.rowStart[var + 1]; k++)
+					out[mColumns.columns[k]] += coef * mColumns.values[k];
+			} else if (var < N + mRowCount) {
+				out[var - N] += coef;
+			} else {
+				out[mArtificialRow[var - N - mRowCount]] -= coef;
+			}
+		}
+
+		/**
+		 * y' * a[var]
+		 */
+		ValueType Dot(size_t var, const VectorT& duals) const {
+			const size_t N = mModel.size();
+
+			if (var < N) {
+				ValueType rval = 0.0;
+
+				for (CsrOffset k = mColumns.rowStart[var]; k < mColumns.rowStart[var + 1]; k++)
+					rval += mColumns.values[k] * duals[mColumns.columns[k]];
+
+				return rval;
+			}
+
+			return var < N + mRowCount ? duals[var - N] : -duals[mArtificialRow[var - N - mRowCount]];
+		}
+
+		/**
+		 * alpha = B^-1 * a[var]
+		 */
+		void Column(size_t var, VectorT& alpha) const {
+			const size_t M = mRowCount;
+			VectorT column(M, ValueType());
+			AddColumn(var, 1.0, column);
+			std::fill(alpha.begin(), alpha.end(), ValueType());
+
+			for (size_t k = 0; k < M; k++) {
+				if (column[k] == 0)
+					continue;
+
+				for (size_t row = 0; row < M; row++)
+					alpha[row] += mInverse[row * M + k] * column[k];
+			}
+		}
+
+		/**
+		 * the multiplier of row i <= 0 is -y[i], nonnegative at the optimum
+		 */
+		void Duals(const VectorT& duals) {
+			mMultipliers.resize(duals.size());
+
+			for (size_t row = 0; row < duals.size(); row++)
+				mMultipliers[row] = -duals[row];
+		}
+
+		VectorT Result() const {
+			return VectorT(mValues.begin(), mValues.begin() + mModel.size());
+		}
+	};
+}// namespace tpr
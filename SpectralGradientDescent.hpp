@@ -0,0 +1,190 @@
+#pragma once
+#include <cmath>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+
+#include "Evaluator.hpp"
+#include "Bounds.hpp"
+#include "LineSearch.hpp"
+
+namespace tpr {
+	/**
+	 * @brief alpha[k+1] = s' * s / s' * y, s = x[k+1] - x[k], y = g[k+1] - g[k]
+	 * The inverse of the Rayleigh quotient of the mean Hessian along s, the longer of the two steps.
+	 */
+	struct BarzilaiBorwein1 {
+		template<typename ValueType>
+		static ValueType step(ValueType ss, ValueType sy, ValueType) {
+			return ss / sy;
+		}
+	};
+
+	/**
+	 * @brief alpha[k+1] = s' * y / y' * y
+	 * Least squares fit of alpha * y to s, never longer than BB1 and steadier on ill-conditioned problems such as the big CSR models.
+	 */
+	struct BarzilaiBorwein2 {
+		template<typename ValueType>
+		static ValueType step(ValueType, ValueType sy, ValueType yy) {
+			return sy / yy;
+		}
+	};
+
+	/**
+	 * @brief spectral (Barzilai-Borwein) gradient method, drop-in replacement for StepSplitGradientDescent.
+	 * x[k+1] = x[k] + t[k] * d[k], d[k] = P( x[k] - alpha[k] * grad( f( x[k] ) ) ) - x[k], alpha[k] is given by StepT
+	 * from the last two iterates and gradients, so unlike SplitDelta it grows back as soon as the curvature allows.
+	 * P projects onto the box of F (spectral projected gradient), without one d[k] = -alpha[k] * grad( f( x[k] ) ).
+	 * Memory is a few vectors of size N.
+	 * The BB step does not decrease f monotonically, t[k] is accepted by the nonmonotone test
+	 *	f( x[k+1] ) <= max( f( x[k-j] ), 0 <= j < Memory ) + C1 * t[k] * grad' * d[k]
+	 * of Grippo, Lampariello, Lucidi and otherwise backtracked by safeguarded quadratic interpolation, t[k] = 1 mostly.
+	 * When s' * y <= 0 alpha keeps the length of the last step. Stops once max | P( x - grad ) - x | <= GradientEpsilon.
+	 * Raydan "The Barzilai and Borwein gradient method for the large scale unconstrained minimization problem", 1997;
+	 * Birgin, Martinez, Raydan "Nonmonotone spectral projected gradient methods on convex sets", 2000, SPG2.
+	 */
+	template< typename F,
+		typename IndexType = size_t,
+		typename StepT = BarzilaiBorwein1
+	>
+	class SpectralGradientDescent {
+	public: // == TYPES ==
+		using ValueType		= typename F::ValueType;
+		using VectorT		= typename F::VectorT;
+		using LineSearch	= WolfeLineSearch<F, IndexType>;
+		using Step			= StepT;
+	public: // == CONSTANTS ==
+		static constexpr ValueType	Epsilon			= 1e-10;	//!< mean relative decrease of f( x ) over the last Memory steps to stop at
+		static constexpr ValueType	GradientEpsilon	= 1e-8;		//!< max | P( x - grad( f( x ) ) ) - x | to stop at
+		static constexpr IndexType	MaxIterations	= 1'000'000;	//!< BB1 needs several 100'000 on big CSR models at small r[k]
+		static constexpr ValueType	Lambda			= 1.0;		//!< length of the first step along -grad( f( x0 ) )
+		static constexpr IndexType	Memory			= 10;		//!< f values the nonmonotone test takes the max over
+		static constexpr ValueType	C1				= 1e-4;		//!< sufficient decrease
+		static constexpr ValueType	MinShrink		= 0.1;		//!< safeguard of the backtracking interpolation
+		static constexpr ValueType	MaxShrink		= 0.5;
+		static constexpr IndexType	MaxBacktracks	= 40;
+		static constexpr ValueType	MinStep			= 1e-30;	//!< bounds of alpha
+		static constexpr ValueType	MaxStep			= 1e30;
+		static constexpr bool		Projects		= true;		//!< keeps x inside the box of F, see Bounds.hpp
+	public:
+		static VectorT calculate(const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(F(), x0, lambda, it, evaluations);
+		}
+
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(f, x0, lambda, it, evaluations);
+		}
+
+		/**
+		 * @param f				objective, called through the object so it may carry state
+		 * @param lambda		in: length of the first step, out: length of the last step
+		 * @param evaluations	incremented by the number of value + gradient evaluations, backtracking included
+		 */
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it, IndexType& evaluations) {
+			IndexType N = x0.size();// take num of vars from x0, runtime models have no F::N
+			VectorT currentXVec = x0;
+			VectorT gradientVec;
+			VectorT nextXVec;
+			VectorT nextGradientVec;
+			VectorT direction;
+			std::vector<ValueType> history(Memory);	// f( x[k-j] ), ring buffer
+			ValueType currentValue = 0.0;
+			ValueType nextValue = 0.0;
+
+			Projection<F>::project(f, currentXVec);
+			Evaluator<F>::evaluate(f, currentXVec, currentValue, gradientVec);
+			evaluations++;
+			std::fill(history.begin(), history.end(), currentValue);
+
+			ValueType squaredNorm = LineSearch::Dot(gradientVec, gradientVec);
+			ValueType alpha = lambda / std::sqrt(squaredNorm);
+
+			for (it = 0; it < MaxIterations; it++) {
+				if (Projection<F>::stationarity(f, currentXVec, gradientVec) <= GradientEpsilon)
+					return currentXVec;
+
+				const ValueType reference = *std::max_element(history.begin(), history.end());
+				direction = gradientVec;
+
+				for (IndexType j = 0; j < N; j++)
+					direction[j] = -alpha * gradientVec[j];
+
+				Projection<F>::clip(f, currentXVec, direction);
+				const ValueType slope = LineSearch::Dot(gradientVec, direction);
+				ValueType step = 1.0;
+				IndexType backtracks = 0;
+				nextXVec = currentXVec;
+
+				for (;;) {
+					for (IndexType j = 0; j < N; j++)
+						nextXVec[j] = currentXVec[j] + step * direction[j];
+
+					// x[k] and P( x[k] - alpha * grad ) are inside, so is the segment up to rounding
+					Projection<F>::project(f, nextXVec);
+					Evaluator<F>::evaluate(f, nextXVec, nextValue, nextGradientVec);
+					evaluations++;
+
+					if (std::isfinite(nextValue) && nextValue <= reference + C1 * step * slope)
+						break;
+
+					// no decrease along d is representable, x[k] is as good as it gets
+					if (++backtracks > MaxBacktracks)
+						return currentXVec;
+
+					// minimizer of the parabola through phi( 0 ), phi'( 0 ) and phi( step ), kept in [0.1, 0.5] * step
+					const ValueType excess = nextValue - currentValue - step * slope;
+					ValueType shrunk = std::isfinite(excess) && excess > 0 ? -slope * step * step / (2 * excess) : MinShrink * step;
+					step = std::min(std::max(shrunk, MinShrink * step), MaxShrink * step);
+				}
+
+				ValueType ss = 0.0, sy = 0.0, yy = 0.0;
+
+				for (IndexType j = 0; j < N; j++) {
+					const ValueType s = nextXVec[j] - currentXVec[j];
+					const ValueType y = nextGradientVec[j] - gradientVec[j];
+					ss += s * s;
+					sy += s * y;
+					yy += y * y;
+				}
+
+				lambda = std::sqrt(ss);
+
+				currentXVec = nextXVec;
+				currentValue = nextValue;
+				gradientVec = nextGradientVec;
+				history[(it + 1) % Memory] = currentValue;
+				squaredNorm = LineSearch::Dot(gradientVec, gradientVec);
+
+				// negative curvature along s, keep the length of the last step
+				alpha = sy > 0 ? Step::step(ss, sy, yy) : lambda / std::sqrt(squaredNorm);
+				alpha = std::min(std::max(alpha, ValueType(MinStep)), ValueType(MaxStep));
+
+				// f( x ) rises now and then, a single step says little, so the decrease is averaged over the history
+				if (it + 1 >= Memory) {
+					const auto range = std::minmax_element(history.begin(), history.end());
+					ValueType diff = *range.second - *range.first;
+					ValueType scale = std::max(ValueType(1.0), std::max(std::fabs(*range.first), std::fabs(*range.second)));
+
+					if (diff <= Epsilon * scale * Memory)
+						return currentXVec;
+				}
+			}// for
+
+			assert(0 && "Failed");
+			return currentXVec;
+		}
+	};
+
+	/**
+	 * SpectralGradientDescent with a fixed step rule, fit a template<typename F, typename IndexType> class parameter:
+	 * PF::evaluate< BarzilaiBorweinDescent >( x0 );
+	 */
+	template<typename F, typename IndexType = size_t>
+	using BarzilaiBorweinDescent = SpectralGradientDescent<F, IndexType, BarzilaiBorwein1>;
+
+	template<typename F, typename IndexType = size_t>
+	using BarzilaiBorwein2Descent = SpectralGradientDescent<F, IndexType, BarzilaiBorwein2>;
+}// namespace tpr
@@ -1,5 +1,7 @@
 #pragma once
 #include <array>
+
+#include "Hessian.hpp"
 namespace tpr {
 	namespace TrainingModel {
 		/**
@@ -24,6 +26,19 @@ namespace tpr {
 				tmp[1] = 2 * (args[1] - 7);
 				return tmp;
 			}
+
+			/**
+			 * hessian = diag( 2, 2 )
+			 */
+			static void add_hessian(const VectorT&, ValueType coef, DenseMatrix<ValueType>& H) {
+				H(0, 0) += 2 * coef;
+				H(1, 1) += 2 * coef;
+			}
+
+			static void add_hessian_vector(const VectorT&, const VectorT& v, ValueType coef, VectorT& hv) {
+				hv[0] += 2 * coef * v[0];
+				hv[1] += 2 * coef * v[1];
+			}
 		};
 
 		/**
@@ -36,6 +51,7 @@ namespace tpr {
 			static constexpr size_t N = 2;
 			using ValueType = double;
 			using VectorT = std::array<ValueType, N>;
+			static constexpr bool Linear = true;
 
 			static ValueType apply(const VectorT& args) {
 				auto vvv = -3.0f * args[0] - 2 * args[1] + 6;
@@ -63,6 +79,7 @@ namespace tpr {
 			static constexpr size_t N = 2;
 			using ValueType = double;
 			using VectorT = std::array<ValueType, N>;
+			static constexpr bool Linear = true;
 
 			static ValueType apply(const VectorT& args) {
 				auto vvv = -1.0f * args[0] + args[1] - 3.0f;
@@ -90,6 +107,7 @@ namespace tpr {
 			static constexpr size_t N = 2;
 			using ValueType = double;
 			using VectorT = std::array<ValueType, N>;
+			static constexpr bool Linear = true;
 
 			static ValueType apply(const VectorT& args) {
 				auto vvv = 1.0f * args[0] + args[1] - 7;
@@ -117,6 +135,7 @@ namespace tpr {
 			static constexpr size_t N = 2;
 			using ValueType = double;
 			using VectorT = std::array<ValueType, N>;
+			static constexpr bool Linear = true;
 
 			static ValueType apply(const VectorT& args) {
 				auto vvv = (2.0f / 3.0f) * args[0] - args[1] - (4.0f / 3.0f);
@@ -0,0 +1,286 @@
+#pragma once
+#include <cmath>
+#include <cassert>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+
+#include "Evaluator.hpp"
+#include "LineSearch.hpp"
+
+namespace tpr {
+	/**
+	 * @brief detects the matrix-free Hessian of an objective
+	 * void hessian_vector(const VectorT& x, const VectorT& v, VectorT& hv) const;	// hv = hessian( f( x ) ) * v
+	 */
+	template<typename F, typename = void>
+	struct HasHessianProduct : std::false_type {};
+
+	template<typename F>
+	struct HasHessianProduct<F, typename detail::VoidT<
+		decltype(std::declval<const F&>().hessian_vector(
+			std::declval<const typename F::VectorT&>(),
+			std::declval<const typename F::VectorT&>(),
+			std::declval<typename F::VectorT&>()
+		))
+	>::type> : std::true_type {};
+
+	/**
+	 * @brief hessian( f( x ) ) * v, by F::hessian_vector when F provides it,
+	 * otherwise by a forward difference of the gradient:
+	 * hv = ( grad( f( x + h * v ) ) - grad( f( x ) ) ) / h, h = sqrt( eps ) * ( 1 + |x| ) / |v|
+	 * which costs one gradient evaluation and is accurate to about sqrt( eps ).
+	 */
+	template<typename F, bool Exact = HasHessianProduct<F>::value>
+	struct HessianProduct {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+
+		/**
+		 * @param grad		grad( f( x ) ), unused here
+		 * @param scratch	work vectors, unused here
+		 * @return number of gradient evaluations spent
+		 */
+		static size_t apply(const F& f, const VectorT& x, const VectorT&, const VectorT& v, VectorT& hv, VectorT&, VectorT&) {
+			f.hessian_vector(x, v, hv);
+			return 0;
+		}
+	};
+
+	template<typename F>
+	struct HessianProduct<F, false> {
+		using ValueType = typename F::ValueType;
+		using VectorT	= typename F::VectorT;
+
+		static size_t apply(const F& f, const VectorT& x, const VectorT& grad, const VectorT& v, VectorT& hv, VectorT& xTrial, VectorT& gTrial) {
+			const size_t N = x.size();
+			ValueType xNorm = 0.0, vNorm = 0.0;
+
+			for (size_t j = 0; j < N; j++) {
+				xNorm += x[j] * x[j];
+				vNorm += v[j] * v[j];
+			}
+
+			hv = v;
+
+			if (!(vNorm > 0)) {
+				std::fill(hv.begin(), hv.end(), ValueType());
+				return 0;
+			}
+
+			const ValueType h = std::sqrt(std::numeric_limits<ValueType>::epsilon()) * (1 + std::sqrt(xNorm)) / std::sqrt(vNorm);
+			ValueType value;
+			xTrial = x;
+
+			for (size_t j = 0; j < N; j++)
+				xTrial[j] += h * v[j];
+
+			Evaluator<F>::evaluate(f, xTrial, value, gTrial);
+
+			for (size_t j = 0; j < N; j++)
+				hv[j] = (gTrial[j] - grad[j]) / h;
+
+			return 1;
+		}
+	};
+
+	/**
+	 * @brief truncated Newton (Newton-CG), drop-in replacement for StepSplitGradientDescent.
+	 * The Newton system H[k] * d = -grad( f( x[k] ) ) is solved approximately by conjugate gradients
+	 * that only need products H[k] * p, see HessianProduct, so memory stays O(N):
+	 *	- CG stops once | H[k] * d + g[k] | <= eta[k] * | g[k] |, eta[k] is the Eisenstat-Walker forcing term
+	 *		eta[k] = Gamma * ( | g[k] | / | g[k-1] | )^2, loose far from the minimum and tightening near it,
+	 *	- or on a direction of nonpositive curvature, returning the iterate so far ( -g[k] on the first CG step ),
+	 * the step then starts at 1 and is chosen by WolfeLineSearch.
+	 * The penalty is linear along most directions far from the minimum, where the Newton step is unbounded:
+	 * CG runs on H[k] + tau * I as NewtonDescent factorizes it. When the search accepts a step a < 1, the model was 1 / a times
+	 * too flat and tau is raised to match, after full steps it decays tenfold, never below MinShift * g' * H * g / g' * g.
+	 * Nocedal, Wright "Numerical Optimization", algorithm 7.1; Eisenstat, Walker 1996, choice 2.
+	 */
+	template< typename F,
+		typename IndexType = size_t
+	>
+	class TruncatedNewtonDescent {
+	public: // == TYPES ==
+		using ValueType		= typename F::ValueType;
+		using VectorT		= typename F::VectorT;
+		using LineSearch	= WolfeLineSearch<F, IndexType>;
+		using Product		= HessianProduct<F>;
+	public: // == CONSTANTS ==
+		static constexpr ValueType	Epsilon			= 1e-10;	//!< relative decrease of f( x ) to stop at
+		static constexpr ValueType	GradientEpsilon	= 1e-8;		//!< max | grad( f( x ) ) | to stop at
+		static constexpr IndexType	MaxIterations	= 10'000;
+		static constexpr ValueType	Curvature		= 0.9;		//!< c2 of the Wolfe conditions
+		static constexpr ValueType	Lambda			= 1.0;		//!< length of a steepest descent step, used when the Newton step fails
+		static constexpr ValueType	Gamma			= 0.9;		//!< Eisenstat-Walker
+		static constexpr ValueType	MaxForcing		= 0.9;		//!< upper bound of eta[k], also eta[0]
+		static constexpr ValueType	Damping			= 10.0;		//!< growth and decay factor of tau
+		static constexpr ValueType	MinShift		= 1e-3;		//!< lower bound of tau, relative to g' * H * g / g' * g
+	public:
+		static VectorT calculate(const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(F(), x0, lambda, it, evaluations);
+		}
+
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it) {
+			IndexType evaluations = 0;
+			return calculate(f, x0, lambda, it, evaluations);
+		}
+
+		/**
+		 * @param f				objective, called through the object so it may carry state
+		 * @param lambda		in: length of a steepest descent step, out: last accepted step
+		 * @param evaluations	incremented by the number of value + gradient evaluations,
+		 *						line search and finite difference products included
+		 */
+		static VectorT calculate(const F& f, const VectorT& x0, ValueType& lambda, IndexType& it, IndexType& evaluations) {
+			IndexType N = x0.size();// take num of vars from x0, runtime models have no F::N
+			VectorT currentXVec = x0;
+			VectorT gradientVec;
+			VectorT nextXVec;
+			VectorT nextGradientVec;
+			VectorT direction;
+			VectorT residual, conjugate, product, xTrial, gTrial;	// CG work vectors
+			ValueType currentValue = 0.0;
+			ValueType nextValue = 0.0;
+			ValueType forcing = MaxForcing;
+			ValueType previousNorm = 0.0;	// | g[k-1] |
+			ValueType damping = 0.0;		// tau
+			ValueType rayleigh = 0.0;		// g' * H * g / g' * g of the last solve
+
+			Evaluator<F>::evaluate(f, currentXVec, currentValue, gradientVec);
+			evaluations++;
+
+			for (it = 0; it < MaxIterations; it++) {
+				ValueType gradientNorm = 0.0;
+
+				for (IndexType idx = 0; idx < N; idx++)
+					gradientNorm = std::max(gradientNorm, std::fabs(gradientVec[idx]));
+
+				if (gradientNorm <= GradientEpsilon)
+					return currentXVec;
+
+				ValueType squaredNorm = LineSearch::Dot(gradientVec, gradientVec);
+
+				if (it > 0) {
+					ValueType ratio = std::sqrt(squaredNorm) / previousNorm;
+					ValueType safeguard = Gamma * forcing * forcing;
+					forcing = Gamma * ratio * ratio;
+
+					// do not let eta drop faster than the convergence allows
+					if (safeguard > 0.1)
+						forcing = std::max(forcing, safeguard);
+
+					forcing = std::min(forcing, MaxForcing);
+				}
+
+				previousNorm = std::sqrt(squaredNorm);
+				evaluations += Solve(f, currentXVec, gradientVec, squaredNorm, forcing, damping, N,
+					direction, residual, conjugate, product, xTrial, gTrial, rayleigh);
+
+				const ValueType unit = MinShift * std::fabs(rayleigh);
+				ValueType step = 1.0;
+
+				if (LineSearch::search(f, currentXVec, currentValue, gradientVec, direction, step, Curvature,
+					nextXVec, nextValue, nextGradientVec, evaluations)) {
+					// ( g' * H * g / g' * g + tau ) / step is the curvature f( x ) showed along d
+					if (step < 1.0)
+						damping = std::max(unit, (std::fabs(rayleigh) + damping) / step - std::fabs(rayleigh));
+					else
+						damping = std::max(unit, damping / Damping);
+				} else {
+					// inexact products or a kink right ahead, fall back to steepest descent
+					damping = std::max(Damping * damping, unit);
+
+					for (IndexType j = 0; j < N; j++)
+						direction[j] = -gradientVec[j];
+
+					step = lambda / std::sqrt(squaredNorm);
+
+					// no decrease along -grad( f( x ) ) is representable, x[k] is as good as it gets
+					if (!LineSearch::search(f, currentXVec, currentValue, gradientVec, direction, step, Curvature,
+						nextXVec, nextValue, nextGradientVec, evaluations))
+						return currentXVec;
+				}
+
+				lambda = step;
+
+				ValueType diff = std::fabs(nextValue - currentValue);
+				ValueType scale = std::max(ValueType(1.0), std::max(std::fabs(nextValue), std::fabs(currentValue)));
+
+				currentXVec = nextXVec;
+				currentValue = nextValue;
+				gradientVec = nextGradientVec;
+
+				if (diff <= Epsilon * scale)
+					return currentXVec;
+			}// for
+
+			assert(0 && "Failed");
+			return currentXVec;
+		}
+
+	private:
+		/**
+		 * CG on ( H + shift * I ) * d = -g from d = 0, at most N products.
+		 * @param rayleigh	out: g' * H * g / g' * g, the curvature along the first product
+		 * @return gradient evaluations spent on products
+		 */
+		static IndexType Solve(const F& f, const VectorT& x, const VectorT& g, ValueType squaredNorm, ValueType forcing, ValueType shift, IndexType N,
+			VectorT& d, VectorT& r, VectorT& p, VectorT& hp, VectorT& xTrial, VectorT& gTrial, ValueType& rayleigh
+		) {
+			const ValueType tolerance = forcing * forcing * squaredNorm;
+			IndexType spent = 0;
+			d = g;
+			r = g;
+			p = g;
+
+			for (IndexType j = 0; j < N; j++) {
+				d[j] = ValueType();
+				p[j] = -g[j];
+			}
+
+			ValueType rr = squaredNorm;
+
+			for (IndexType k = 0; k < N; k++) {
+				spent += Product::apply(f, x, g, p, hp, xTrial, gTrial);
+
+				for (IndexType j = 0; j < N; j++)
+					hp[j] += shift * p[j];
+
+				ValueType curvature = LineSearch::Dot(p, hp);
+
+				if (k == 0)
+					rayleigh = curvature / squaredNorm - shift;
+
+				if (!(curvature > 0)) {
+					// H is not positive definite along p, keep what we have
+					if (k == 0)
+						d = p;
+
+					return spent;
+				}
+
+				ValueType alpha = rr / curvature;
+
+				for (IndexType j = 0; j < N; j++) {
+					d[j] += alpha * p[j];
+					r[j] += alpha * hp[j];
+				}
+
+				ValueType rrNext = LineSearch::Dot(r, r);
+
+				if (rrNext <= tolerance)
+					return spent;
+
+				ValueType beta = rrNext / rr;
+				rr = rrNext;
+
+				for (IndexType j = 0; j < N; j++)
+					p[j] = beta * p[j] - r[j];
+			}
+
+			return spent;
+		}
+	};
+}// namespace tpr
@@ -3,12 +3,28 @@
 #include <map>
 #include <cmath>
 #include <fstream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <cassert>
 
 #include "GradientDescent.hpp"
 #include "PenaltyFunction.hpp"
+#include "MultiStart.hpp"
+#include "ParameterSweep.hpp"
+#include "CsrPenaltyFunction.hpp"
+#include "AugmentedLagrangian.hpp"
+#include "BarrierFunction.hpp"
+#include "ModelTable.hpp"
+#include "SecondOrderConeSolver.hpp"
+#include "BinaryModel.hpp"
+#include "Batch.hpp"
 #include "subj_17.hpp"
 #include "TrainingModel.hpp"
 #include "subj_17_p4.hpp"
+#include "subj_17_simplified.hpp"
 
 ///**
 //  * f(x) = 10 * x1^2 + x2 ^ 2
@@ -44,8 +60,8 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 template<typename CfgParam>
-static void test_subj_17( std::string result_name, size_t startx = 18){
-	assert(tpr::subj_17::model_index_to_index.size() == 18);
+static void test_subj_17( std::string result_name, std::vector<size_t> startValues = { 18 }){
+	static_assert(tpr::subj_17::ModelIndexCount == 18, "subj_17 has 18 variables");
 	using PF = tpr::PenaltyFunction<
 		tpr::subj_17::Fx, 
 		size_t, 
@@ -59,40 +75,52 @@ static void test_subj_17( std::string result_name, size_t startx = 18){
 		tpr::subj_17::G8<CfgParam>,
 		tpr::subj_17::G9<CfgParam>
 	>;
-	typename PF::VectorT x0;
+	using MS = tpr::MultiStart<PF>;
+	std::vector<typename PF::VectorT> starts;
 
-	for (size_t idx = 0; idx < x0.size(); idx++)
-		x0[idx] = startx;
+	for (size_t startx : startValues) {
+		typename PF::VectorT x0;
+		x0.fill(startx);
+		starts.push_back(x0);
+	}
 
-	typename PF::VectorT xOpt = PF::evaluate(x0);
+	typename MS::Result result = MS::solve(starts);
+	typename PF::VectorT xOpt = result.starts[result.best].xOpt;
 	//std::ofstream out("x_opt.txt");
 	std::ofstream out(result_name.c_str());
 
+	for (size_t idx = 0; idx < result.starts.size(); idx++) {
+		const typename MS::StartStats& stats = result.starts[idx];
+		out << "start x0 = " << startValues[idx] << ": f = " << stats.value << ", max(gi) = " << stats.infeasibility
+			<< ", " << stats.outerIterations << " / " << stats.innerIterations << " outer / inner iterations, "
+			<< stats.seconds << " s" << (idx == result.best ? " <-- best" : "") << '\n';
+	}
+
 	for (size_t idx = 0; idx < PF::N; idx++) {
 		int modelIndex = tpr::subj_17::index_to_model_index_converter[idx];
 		out << "x[ " << modelIndex << " ]opt = " << std::round(xOpt[idx]) << " --> " << tpr::subj_17::model_index_to_description_conv[modelIndex] << '\n';
 	}
 
-	typename PF::ValueType sumProdA = xOpt[tpr::subj_17::model_index_to_index[111]]
-		+ xOpt[tpr::subj_17::model_index_to_index[112]]
-		+ xOpt[tpr::subj_17::model_index_to_index[211]]
-		+ xOpt[tpr::subj_17::model_index_to_index[212]]
-		+ xOpt[tpr::subj_17::model_index_to_index[311]]
-		+ xOpt[tpr::subj_17::model_index_to_index[312]]
+	typename PF::ValueType sumProdA = xOpt[tpr::subj_17::x111]
+		+ xOpt[tpr::subj_17::x112]
+		+ xOpt[tpr::subj_17::x211]
+		+ xOpt[tpr::subj_17::x212]
+		+ xOpt[tpr::subj_17::x311]
+		+ xOpt[tpr::subj_17::x312]
 		;
-	typename PF::ValueType sumProdB = xOpt[tpr::subj_17::model_index_to_index[121]]
-		+ xOpt[tpr::subj_17::model_index_to_index[122]]
-		+ xOpt[tpr::subj_17::model_index_to_index[221]]
-		+ xOpt[tpr::subj_17::model_index_to_index[222]]
-		+ xOpt[tpr::subj_17::model_index_to_index[321]]
-		+ xOpt[tpr::subj_17::model_index_to_index[322]]
+	typename PF::ValueType sumProdB = xOpt[tpr::subj_17::x121]
+		+ xOpt[tpr::subj_17::x122]
+		+ xOpt[tpr::subj_17::x221]
+		+ xOpt[tpr::subj_17::x222]
+		+ xOpt[tpr::subj_17::x321]
+		+ xOpt[tpr::subj_17::x322]
 		;
-	typename PF::ValueType sumProdC = xOpt[tpr::subj_17::model_index_to_index[131]]
-		+ xOpt[tpr::subj_17::model_index_to_index[132]]
-		+ xOpt[tpr::subj_17::model_index_to_index[231]]
-		+ xOpt[tpr::subj_17::model_index_to_index[232]]
-		+ xOpt[tpr::subj_17::model_index_to_index[331]]
-		+ xOpt[tpr::subj_17::model_index_to_index[332]]
+	typename PF::ValueType sumProdC = xOpt[tpr::subj_17::x131]
+		+ xOpt[tpr::subj_17::x132]
+		+ xOpt[tpr::subj_17::x231]
+		+ xOpt[tpr::subj_17::x232]
+		+ xOpt[tpr::subj_17::x331]
+		+ xOpt[tpr::subj_17::x332]
 		;
 
 	out << "sum(A) = " << sumProdA << ", threshold: " << CfgParam::ASum << std::endl;
@@ -114,8 +142,8 @@ static void test_subj_17( std::string result_name, size_t startx = 18){
 
 
 template<typename CfgParam>
-static void test_subj_17_p4(std::string result_name, size_t startx = 24) {
-	assert(tpr::subj_17_p4::model_index_to_index.size() == CfgParam::NVariables);
+static void test_subj_17_p4(std::string result_name, std::vector<size_t> startValues = { 24 }) {
+	static_assert(tpr::subj_17_p4::ModelIndexCount == CfgParam::NVariables, "index table does not match config");
 	using PF = tpr::PenaltyFunction<
 		tpr::subj_17_p4::Fx,
 		size_t,
@@ -130,49 +158,61 @@ static void test_subj_17_p4(std::string result_name, size_t startx = 24) {
 		tpr::subj_17_p4::G9<CfgParam>,
 		tpr::subj_17_p4::G10<CfgParam>
 	>;
-	typename PF::VectorT x0;
+	using MS = tpr::MultiStart<PF>;
+	std::vector<typename PF::VectorT> starts;
 
-	for (size_t idx = 0; idx < x0.size(); idx++)
-		x0[idx] = startx;
+	for (size_t startx : startValues) {
+		typename PF::VectorT x0;
+		x0.fill(startx);
+		starts.push_back(x0);
+	}
 
-	typename PF::VectorT xOpt = PF::evaluate(x0);
+	typename MS::Result result = MS::solve(starts);
+	typename PF::VectorT xOpt = result.starts[result.best].xOpt;
 	//std::ofstream out("x_opt.txt");
 	std::ofstream out(result_name.c_str());
 
+	for (size_t idx = 0; idx < result.starts.size(); idx++) {
+		const typename MS::StartStats& stats = result.starts[idx];
+		out << "start x0 = " << startValues[idx] << ": f = " << stats.value << ", max(gi) = " << stats.infeasibility
+			<< ", " << stats.outerIterations << " / " << stats.innerIterations << " outer / inner iterations, "
+			<< stats.seconds << " s" << (idx == result.best ? " <-- best" : "") << '\n';
+	}
+
 	for (size_t idx = 0; idx < PF::N; idx++) {
 		int modelIndex = tpr::subj_17_p4::index_to_model_index_converter[idx];
 		out << "x[ " << modelIndex << " ]opt = " << std::round(xOpt[idx]) << " --> " << tpr::subj_17_p4::model_index_to_description_conv[modelIndex] << '\n';
 	}
 
-	typename PF::ValueType sumProdA = xOpt[tpr::subj_17_p4::model_index_to_index[111]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[112]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[211]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[212]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[311]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[312]]
+	typename PF::ValueType sumProdA = xOpt[tpr::subj_17_p4::x111]
+		+ xOpt[tpr::subj_17_p4::x112]
+		+ xOpt[tpr::subj_17_p4::x211]
+		+ xOpt[tpr::subj_17_p4::x212]
+		+ xOpt[tpr::subj_17_p4::x311]
+		+ xOpt[tpr::subj_17_p4::x312]
 		;
-	typename PF::ValueType sumProdB = xOpt[tpr::subj_17_p4::model_index_to_index[121]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[122]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[221]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[222]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[321]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[322]]
+	typename PF::ValueType sumProdB = xOpt[tpr::subj_17_p4::x121]
+		+ xOpt[tpr::subj_17_p4::x122]
+		+ xOpt[tpr::subj_17_p4::x221]
+		+ xOpt[tpr::subj_17_p4::x222]
+		+ xOpt[tpr::subj_17_p4::x321]
+		+ xOpt[tpr::subj_17_p4::x322]
 		;
-	typename PF::ValueType sumProdC = xOpt[tpr::subj_17_p4::model_index_to_index[131]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[132]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[231]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[232]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[331]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[332]]
+	typename PF::ValueType sumProdC = xOpt[tpr::subj_17_p4::x131]
+		+ xOpt[tpr::subj_17_p4::x132]
+		+ xOpt[tpr::subj_17_p4::x231]
+		+ xOpt[tpr::subj_17_p4::x232]
+		+ xOpt[tpr::subj_17_p4::x331]
+		+ xOpt[tpr::subj_17_p4::x332]
 		;
 
 	typename PF::ValueType sumProdD = 
-		  xOpt[tpr::subj_17_p4::model_index_to_index[141]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[142]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[241]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[242]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[341]]
-		+ xOpt[tpr::subj_17_p4::model_index_to_index[342]]
+		  xOpt[tpr::subj_17_p4::x141]
+		+ xOpt[tpr::subj_17_p4::x142]
+		+ xOpt[tpr::subj_17_p4::x241]
+		+ xOpt[tpr::subj_17_p4::x242]
+		+ xOpt[tpr::subj_17_p4::x341]
+		+ xOpt[tpr::subj_17_p4::x342]
 		;
 
 	out << "sum(A) = " << sumProdA << std::endl;
@@ -192,6 +232,452 @@ static void test_subj_17_p4(std::string result_name, size_t startx = 24) {
 	out.flush();
 }
 
+/**
+ * x with descriptions and gi( x ) of a subj_17 solution.
+ */
+template<typename CfgParam, typename VecT>
+static void write_subj_17_x(std::ofstream& out, const VecT& xOpt) {
+	for (size_t idx = 0; idx < xOpt.size(); idx++) {
+		int modelIndex = tpr::subj_17::index_to_model_index_converter[idx];
+		out << "x[ " << modelIndex << " ]opt = " << std::round(xOpt[idx]) << " --> " << tpr::subj_17::model_index_to_description_conv[modelIndex] << '\n';
+	}
+
+	const double values[] = {
+		tpr::subj_17::G1<CfgParam>::apply(xOpt), tpr::subj_17::G2<CfgParam>::apply(xOpt), tpr::subj_17::G3<CfgParam>::apply(xOpt),
+		tpr::subj_17::G4<CfgParam>::apply(xOpt), tpr::subj_17::G5<CfgParam>::apply(xOpt), tpr::subj_17::G6<CfgParam>::apply(xOpt),
+		tpr::subj_17::G7<CfgParam>::apply(xOpt), tpr::subj_17::G8<CfgParam>::apply(xOpt), tpr::subj_17::G9<CfgParam>::apply(xOpt)
+	};
+
+	for (size_t idx = 0; idx < sizeof(values) / sizeof(values[0]); idx++)
+		out << 'g' << idx + 1 << " = " << values[idx] << '\n';
+}
+
+/**
+ * subj_17 by the augmented Lagrangian with x >= 0.
+ * Config2ResourceChanged has its optimum at f = 2490, Config0 has no feasible x >= 0.
+ */
+template<typename CfgParam>
+static void test_augmented_lagrangian(std::string result_name, double expected, size_t startx = 18) {
+	using AL = tpr::AugmentedLagrangian<
+		tpr::subj_17::Fx,
+		size_t,
+		tpr::subj_17::G1<CfgParam>,
+		tpr::subj_17::G2<CfgParam>,
+		tpr::subj_17::G3<CfgParam>,
+		tpr::subj_17::G4<CfgParam>,
+		tpr::subj_17::G5<CfgParam>,
+		tpr::subj_17::G6<CfgParam>,
+		tpr::subj_17::G7<CfgParam>,
+		tpr::subj_17::G8<CfgParam>,
+		tpr::subj_17::G9<CfgParam>
+	>;
+	AL solver;
+	solver.setBounds(tpr::Box<double>::nonnegative(AL::N));
+	typename AL::VectorT x0;
+	x0.fill(startx);
+	auto started = std::chrono::steady_clock::now();
+	typename AL::VectorT xOpt = solver.solve(x0);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	double value = tpr::subj_17::Fx::apply(xOpt);
+	std::ofstream out(result_name.c_str());
+
+	out << "start x0 = " << startx << ": f = " << value << ", max(gi) = " << AL::infeasibility(xOpt)
+		<< ", " << solver.outerIterations() << " / " << solver.innerIterations() << " outer / inner iterations, c = " << solver.coefficient()
+		<< ", " << seconds << " s" << '\n';
+	write_subj_17_x<CfgParam>(out, xOpt);
+	out.flush();
+	assert(std::fabs(value - expected) <= 1e-3 * expected && "augmented Lagrangian missed the optimum");
+	assert(AL::infeasibility(xOpt) <= AL::FeasibilityEpsilon && "augmented Lagrangian left x infeasible");
+}
+
+/**
+ * subj_17 with x >= 0 kept by the barrier terms of BarrierFunction from startx, asserts f is expected.
+ */
+template<typename CfgParam>
+static void test_barrier(std::string result_name, double expected, size_t startx = 18) {
+	using BF = tpr::BarrierFunction<
+		tpr::subj_17::Fx,
+		size_t,
+		tpr::subj_17::G1<CfgParam>,
+		tpr::subj_17::G2<CfgParam>,
+		tpr::subj_17::G3<CfgParam>,
+		tpr::subj_17::G4<CfgParam>,
+		tpr::subj_17::G5<CfgParam>,
+		tpr::subj_17::G6<CfgParam>,
+		tpr::subj_17::G7<CfgParam>,
+		tpr::subj_17::G8<CfgParam>,
+		tpr::subj_17::G9<CfgParam>
+	>;
+	BF solver;
+	solver.setBounds(tpr::Box<double>::nonnegative(BF::N));
+	typename BF::VectorT x0;
+	x0.fill(startx);
+	auto started = std::chrono::steady_clock::now();
+	typename BF::VectorT xOpt = solver.solve(x0);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	double value = tpr::subj_17::Fx::apply(xOpt);
+	std::ofstream out(result_name.c_str());
+
+	out << "start x0 = " << startx << ": f = " << value << ", max(gi) = " << BF::infeasibility(xOpt)
+		<< ", " << solver.outerIterations() << " / " << solver.innerIterations() << " outer / inner iterations, mu = " << solver.coefficient()
+		<< ", " << seconds << " s" << '\n';
+	write_subj_17_x<CfgParam>(out, xOpt);
+	out.flush();
+	assert(solver.feasible() && "barrier found no interior");
+	assert(std::fabs(value - expected) <= 1e-3 * expected && "barrier missed the optimum");
+}
+
+/**
+ * subj_17 as the CsrModel ModelTable builds, solved with x >= 0 by SecondOrderConeSolver, asserts it is Optimal at f = expected.
+ */
+template<typename CfgParam>
+static void test_cone_solver(std::string result_name, double expected) {
+	const tpr::CsrModel model = tpr::ModelTable<
+		tpr::subj_17::Fx,
+		tpr::subj_17::G1<CfgParam>,
+		tpr::subj_17::G2<CfgParam>,
+		tpr::subj_17::G3<CfgParam>,
+		tpr::subj_17::G4<CfgParam>,
+		tpr::subj_17::G5<CfgParam>,
+		tpr::subj_17::G6<CfgParam>,
+		tpr::subj_17::G7<CfgParam>,
+		tpr::subj_17::G8<CfgParam>,
+		tpr::subj_17::G9<CfgParam>
+	>::build();
+	tpr::SecondOrderConeSolver<> cone(model);
+	cone.setBounds(tpr::Box<double>::nonnegative(model.size()));
+	auto started = std::chrono::steady_clock::now();
+	const std::vector<double> xOpt = cone.solve();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	std::array<double, tpr::subj_17::Fx::N> x;
+	std::copy(xOpt.begin(), xOpt.end(), x.begin());
+	double value = tpr::subj_17::Fx::apply(x);
+	double lowest = *std::min_element(x.begin(), x.end());
+	std::ofstream out(result_name.c_str());
+
+	out << "status " << cone.status() << ": f = " << value << ", min(x) = " << lowest << ", gap = " << cone.gap()
+		<< ", " << cone.iterations() << " iterations, " << seconds << " s" << '\n';
+	write_subj_17_x<CfgParam>(out, x);
+	out.flush();
+	assert(xOpt.size() == x.size() && "ModelTable changed the number of variables");
+	assert(cone.status() == tpr::SecondOrderConeSolver<>::Optimal && "cone solver did not reach the optimum");
+	assert(std::fabs(value - expected) <= 1e-3 * expected && "cone solver missed the optimum");
+	assert(lowest >= -tpr::SecondOrderConeSolver<>::FeasibilityEpsilon * expected && "cone solver left x < 0");
+}
+
+/**
+ * subj_17_p4 with quantile 0 and x >= 0, a linear program, by PenaltyFunction with setLinearProgram, asserts f is expected.
+ */
+static void test_linear_program(std::string result_name, double expected) {
+	using Cfg = tpr::subj_17_p4::RuntimeConfig<tpr::subj_17_p4::Config0>;
+	using PF = tpr::PenaltyFunction<
+		tpr::subj_17_p4::Fx,
+		size_t,
+		tpr::subj_17_p4::G1<Cfg>,
+		tpr::subj_17_p4::G2<Cfg>,
+		tpr::subj_17_p4::G3<Cfg>,
+		tpr::subj_17_p4::G4<Cfg>,
+		tpr::subj_17_p4::G5<Cfg>,
+		tpr::subj_17_p4::G6<Cfg>,
+		tpr::subj_17_p4::G7<Cfg>,
+		tpr::subj_17_p4::G8<Cfg>,
+		tpr::subj_17_p4::G9<Cfg>,
+		tpr::subj_17_p4::G10<Cfg>
+	>;
+	Cfg::FLaplassInverse = 0.0;
+	PF solver;
+	solver.setBounds(tpr::Box<double>::nonnegative(PF::N));
+	solver.setLinearProgram(true);
+	typename PF::VectorT x0;
+	x0.fill(24);
+	auto started = std::chrono::steady_clock::now();
+	typename PF::VectorT xOpt = solver.solve(x0);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	double value = tpr::subj_17_p4::Fx::apply(xOpt);
+	std::ofstream out(result_name.c_str());
+
+	out << "quantile 0: f = " << value << ", max(gi) = " << PF::infeasibility(xOpt)
+		<< ", " << solver.outerIterations() << " / " << solver.innerIterations() << " outer / simplex iterations, " << seconds << " s" << '\n';
+
+	for (size_t idx = 0; idx < PF::N; idx++) {
+		int modelIndex = tpr::subj_17_p4::index_to_model_index_converter[idx];
+		out << "x[ " << modelIndex << " ]opt = " << std::round(xOpt[idx]) << " --> " << tpr::subj_17_p4::model_index_to_description_conv[modelIndex] << '\n';
+	}
+
+	out.flush();
+	Cfg::FLaplassInverse = tpr::subj_17_p4::Config0::FLaplassInverse;
+	assert(solver.outerIterations() == 0 && "the linear program went through the penalty loop");
+	assert(std::fabs(value - expected) <= 1e-6 * expected && "simplex missed the optimum");
+}
+
+/**
+ * model PF from several starts with x >= 0 by GradientDescentT, one line per start, asserts the best f is expected.
+ */
+template<template<typename, typename> class GradientDescentT, typename PF>
+static void bounded_descent(std::ofstream& out, const std::string& name, double expected, const std::vector<size_t>& startValues) {
+	using MS = tpr::MultiStart<PF, GradientDescentT>;
+	std::vector<typename PF::VectorT> starts;
+
+	for (size_t startx : startValues) {
+		typename PF::VectorT x0;
+		x0.fill(startx);
+		starts.push_back(x0);
+	}
+
+	typename MS::Result result = MS::solve(starts, tpr::Box<double>::nonnegative(PF::N));
+
+	for (size_t idx = 0; idx < result.starts.size(); idx++) {
+		const typename MS::StartStats& stats = result.starts[idx];
+		out << name << ", start x0 = " << startValues[idx] << ": f = " << stats.value << ", max(gi) = " << stats.infeasibility
+			<< ", " << stats.outerIterations << " / " << stats.innerIterations << " outer / inner iterations, "
+			<< stats.seconds << " s" << (idx == result.best ? " <-- best" : "") << '\n';
+	}
+
+	const double value = result.starts[result.best].value;
+	out << name << ": best f = " << value << ", expected " << expected << '\n';
+	assert(result.feasible && std::fabs(value - expected) <= 1e-3 * expected && "bounded descent missed the optimum");
+}
+
+/**
+ * L-BFGS and conjugate gradients keep x >= 0 by projection, on subj_17 Config2 ( f = 2490 ) and subj_17_p4 ( f = 3390 ).
+ */
+static void test_bounded_descents(std::string result_name) {
+	using Cfg17 = tpr::subj_17::Config2ResourceChanged;
+	using CfgP4 = tpr::subj_17_p4::Config0;
+	using PF17 = tpr::PenaltyFunction<tpr::subj_17::Fx, size_t, tpr::subj_17::G1<Cfg17>, tpr::subj_17::G2<Cfg17>, tpr::subj_17::G3<Cfg17>,
+		tpr::subj_17::G4<Cfg17>, tpr::subj_17::G5<Cfg17>, tpr::subj_17::G6<Cfg17>, tpr::subj_17::G7<Cfg17>, tpr::subj_17::G8<Cfg17>, tpr::subj_17::G9<Cfg17>>;
+	using PFP4 = tpr::PenaltyFunction<tpr::subj_17_p4::Fx, size_t, tpr::subj_17_p4::G1<CfgP4>, tpr::subj_17_p4::G2<CfgP4>, tpr::subj_17_p4::G3<CfgP4>,
+		tpr::subj_17_p4::G4<CfgP4>, tpr::subj_17_p4::G5<CfgP4>, tpr::subj_17_p4::G6<CfgP4>, tpr::subj_17_p4::G7<CfgP4>, tpr::subj_17_p4::G8<CfgP4>,
+		tpr::subj_17_p4::G9<CfgP4>, tpr::subj_17_p4::G10<CfgP4>>;
+	std::ofstream out(result_name.c_str());
+
+	bounded_descent<tpr::LBFGS<8>::Descent, PF17>(out, "subj_17 Config2, L-BFGS", 2490, { 15, 18, 20, 24 });
+	bounded_descent<tpr::PolakRibiereDescent, PF17>(out, "subj_17 Config2, PR+ CG", 2490, { 15, 18, 20, 24 });
+	bounded_descent<tpr::LBFGS<8>::Descent, PFP4>(out, "subj_17_p4, L-BFGS", 3390, { 15, 18, 20, 24 });
+	bounded_descent<tpr::PolakRibiereDescent, PFP4>(out, "subj_17_p4, PR+ CG", 3390, { 15, 18, 20, 24 });
+}
+
+/**
+ * what-if study over runtime values of Resource11 and ASum with x >= 0, one line per scenario.
+ * The other parameters keep the values of Config2ResourceChanged, Config0 has no feasible x >= 0.
+ */
+static void sweep_subj_17(std::string result_name, size_t startx = 15) {
+	using Cfg = tpr::subj_17::RuntimeConfig<tpr::subj_17::Config2ResourceChanged>;
+	using Scenario = Cfg::Scenario;
+	using PF = tpr::PenaltyFunction<
+		tpr::subj_17::Fx,
+		size_t,
+		tpr::subj_17::G1<Cfg>,
+		tpr::subj_17::G2<Cfg>,
+		tpr::subj_17::G3<Cfg>,
+		tpr::subj_17::G4<Cfg>,
+		tpr::subj_17::G5<Cfg>,
+		tpr::subj_17::G6<Cfg>,
+		tpr::subj_17::G7<Cfg>,
+		tpr::subj_17::G8<Cfg>,
+		tpr::subj_17::G9<Cfg>
+	>;
+	using Sweep = tpr::ParameterSweep<PF, Cfg>;
+	tpr::SweepGrid<Scenario> grid(Cfg::base());
+	grid.add(&Scenario::Resource11, tpr::SweepGrid<Scenario>::range(200, 400, 5))
+		.add(&Scenario::ASum, tpr::SweepGrid<Scenario>::range(250, 350, 5));
+
+	PF::VectorT x0;
+	x0.fill(startx);
+	std::vector<Sweep::ScenarioStats> results = Sweep::solve(grid.scenarios(), x0, tpr::Box<double>::nonnegative(PF::N));
+	std::ofstream out(result_name.c_str());
+
+	for (size_t idx = 0; idx < results.size(); idx++) {
+		const Sweep::ScenarioStats& stats = results[idx];
+		out << "R1 = " << stats.scenario.Resource11 << ", A = " << stats.scenario.ASum
+			<< ": f = " << stats.value << ", max(gi) = " << stats.infeasibility
+			<< ", " << stats.outerIterations << " / " << stats.innerIterations << " outer / inner iterations";
+
+		if (stats.warmStart != Sweep::NoWarmStart)
+			out << ", warm start from #" << stats.warmStart;
+
+		out << '\n';
+	}
+}
+
+/**
+ * F(x, r[k]) of points, K at a time, appends ns per point and the largest difference to the values of apply.
+ */
+template<size_t K, typename FxRk>
+static void batch_throughput(std::ofstream& out, const FxRk& fxRk, const std::vector<typename FxRk::VectorT>& points, const std::vector<double>& expected) {
+	std::vector<double> values;
+	auto started = std::chrono::steady_clock::now();
+	tpr::BatchEvaluator<FxRk, K>::apply(fxRk, points, values);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	double difference = 0.0;
+
+	for (size_t idx = 0; idx < points.size(); idx++)
+		difference = std::max(difference, std::fabs(values[idx] - expected[idx]) / std::max(1.0, std::fabs(expected[idx])));
+
+	out << "K = " << K << ": " << seconds * 1e9 / points.size() << " ns / point, max relative difference " << difference << '\n';
+}
+
+static void batch_subj_17_p4(std::string result_name, size_t count = 1 << 16) {
+	using Cfg = tpr::subj_17_p4::Config0;
+	using PF = tpr::PenaltyFunction<
+		tpr::subj_17_p4::Fx,
+		size_t,
+		tpr::subj_17_p4::G1<Cfg>,
+		tpr::subj_17_p4::G2<Cfg>,
+		tpr::subj_17_p4::G3<Cfg>,
+		tpr::subj_17_p4::G4<Cfg>,
+		tpr::subj_17_p4::G5<Cfg>,
+		tpr::subj_17_p4::G6<Cfg>,
+		tpr::subj_17_p4::G7<Cfg>,
+		tpr::subj_17_p4::G8<Cfg>,
+		tpr::subj_17_p4::G9<Cfg>,
+		tpr::subj_17_p4::G10<Cfg>
+	>;
+	const double rk = 64.0;
+	const PF::FxRk fxRk(rk);
+	std::mt19937 random(17);
+	std::uniform_real_distribution<double> value(0.0, 200.0);
+	std::vector<PF::VectorT> points(count);
+
+	for (PF::VectorT& point : points)
+		for (double& x : point)
+			x = value(random);
+
+	std::vector<double> expected(count);
+	auto started = std::chrono::steady_clock::now();
+
+	for (size_t idx = 0; idx < count; idx++)
+		expected[idx] = fxRk.apply(points[idx]);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	std::ofstream out(result_name.c_str());
+	out << "apply: " << seconds * 1e9 / count << " ns / point" << '\n';
+	out << "native K = " << tpr::NativeLanes << '\n';
+	batch_throughput<2>(out, fxRk, points, expected);
+	batch_throughput<4>(out, fxRk, points, expected);
+	batch_throughput<8>(out, fxRk, points, expected);
+}
+
+static void write_model_result(std::string result_name, const tpr::CsrPenaltyFunction<>& solver, const tpr::CsrModel::VectorT& xOpt,
+	const std::vector<std::string>& names
+) {
+	std::ofstream out(result_name.c_str());
+
+	out << "f = " << solver.model().objectiveValue(xOpt) << ", max(gi) = " << solver.infeasibility(xOpt)
+		<< ", " << solver.outerIterations() << " / " << solver.innerIterations() << " outer / inner iterations" << '\n';
+
+	for (size_t idx = 0; idx < names.size(); idx++)
+		out << names[idx] << " = " << std::round(xOpt[idx]) << '\n';
+
+	tpr::CsrModel::VectorT g = solver.model().constraintValues(xOpt);
+
+	for (size_t idx = 0; idx < g.size(); idx++)
+		out << "g" << idx + 1 << " = " << g[idx] << '\n';
+}
+
+/**
+ * model read at runtime, no rebuild for a new layout.
+ */
+static void solve_model(std::string model_name, std::string result_name, double startx = 15) {
+	tpr::CsrModel model;
+	std::string error;
+
+	if (!tpr::ModelLoader::load(model_name, model, error)) {
+		std::cerr << model_name << ": " << error << std::endl;
+		return;
+	}
+
+	tpr::CsrPenaltyFunction<> solver(model);
+	tpr::CsrModel::VectorT xOpt = solver.solve(tpr::CsrModel::VectorT(model.size(), startx));
+	write_model_result(result_name, solver, xOpt, model.names);
+}
+
+static void solve_mapped_model(std::string model_name, std::string binary_name, std::string result_name, double startx = 15) {
+	tpr::CsrModel model;
+	std::string error;
+
+	if (!tpr::ModelLoader::load(model_name, model, error) || !tpr::BinaryModelWriter::write(model, binary_name, error)) {
+		std::cerr << model_name << ": " << error << std::endl;
+		return;
+	}
+
+	tpr::MappedModel mapped;
+
+	if (!mapped.open(binary_name, error) || !mapped.validate(error)) {
+		std::cerr << binary_name << ": " << error << std::endl;
+		return;
+	}
+
+	std::vector<std::string> names;
+
+	for (size_t idx = 0; idx < mapped.size(); idx++)
+		names.push_back(mapped.name(idx));
+
+	tpr::CsrPenaltyFunction<> solver(mapped.view());
+	tpr::CsrModel::VectorT xOpt = solver.solve(tpr::CsrModel::VectorT(mapped.size(), startx));
+	write_model_result(result_name, solver, xOpt, names);
+}
+
+/**
+ * largest difference of F::gradient to central differences of F::apply over random points in [ 1, 200 ]^N,
+ * relative to max( 1, | dF/dx[i] | ). A hand-written gradient that disagrees with apply makes every descent
+ * minimize another function than the model states.
+ */
+template<typename F>
+static double gradient_error(std::mt19937& random, size_t count = 64) {
+	std::uniform_real_distribution<double> value(1.0, 200.0);
+	double rval = 0.0;
+
+	for (size_t point = 0; point < count; point++) {
+		typename F::VectorT x;
+
+		for (double& xi : x)
+			xi = value(random);
+
+		const typename F::VectorT grad = F::gradient(x);
+
+		for (size_t idx = 0; idx < x.size(); idx++) {
+			const double h = 1e-5 * std::max(1.0, std::fabs(x[idx]));
+			typename F::VectorT xp = x, xm = x;
+			xp[idx] += h;
+			xm[idx] -= h;
+			const double difference = (F::apply(xp) - F::apply(xm)) / (2 * h);
+			rval = std::max(rval, std::fabs(grad[idx] - difference) / std::max(1.0, std::fabs(difference)));
+		}
+	}
+
+	return rval;
+}
+
+/**
+ * gradient_error of f and each gi of a model, one line per function, asserts they agree.
+ */
+template<typename FT, typename ... GiFuncTypes>
+static void check_gradients(std::ofstream& out, const std::string& model, std::mt19937& random) {
+	const double errors[] = { gradient_error<FT>(random), gradient_error<GiFuncTypes>(random) ... };
+
+	for (size_t idx = 0; idx < sizeof(errors) / sizeof(errors[0]); idx++) {
+		out << model << ' ' << (idx == 0 ? std::string("f") : "g" + std::to_string(idx)) << ": max relative error " << errors[idx] << '\n';
+		assert(errors[idx] < 1e-5 && "gradient disagrees with apply");
+	}
+}
+
+static void check_model_gradients(std::string result_name) {
+	using namespace tpr;
+	using Cfg17 = subj_17::Config0;
+	using CfgP4 = subj_17_p4::Config0;
+	std::mt19937 random(9);
+	std::ofstream out(result_name.c_str());
+
+	check_gradients<subj_17::Fx, subj_17::G1<Cfg17>, subj_17::G2<Cfg17>, subj_17::G3<Cfg17>, subj_17::G4<Cfg17>, subj_17::G5<Cfg17>,
+		subj_17::G6<Cfg17>, subj_17::G7<Cfg17>, subj_17::G8<Cfg17>, subj_17::G9<Cfg17>>(out, "subj_17", random);
+	check_gradients<subj_17_p4::Fx, subj_17_p4::G1<CfgP4>, subj_17_p4::G2<CfgP4>, subj_17_p4::G3<CfgP4>, subj_17_p4::G4<CfgP4>, subj_17_p4::G5<CfgP4>,
+		subj_17_p4::G6<CfgP4>, subj_17_p4::G7<CfgP4>, subj_17_p4::G8<CfgP4>, subj_17_p4::G9<CfgP4>, subj_17_p4::G10<CfgP4>>(out, "subj_17_p4", random);
+	check_gradients<subj_17_simplified::Fx, subj_17_simplified::G1, subj_17_simplified::G2, subj_17_simplified::G3, subj_17_simplified::G4,
+		subj_17_simplified::G5, subj_17_simplified::G6, subj_17_simplified::G7, subj_17_simplified::G8, subj_17_simplified::G9>(out, "subj_17_simplified", random);
+	check_gradients<TrainingModel::Fx, TrainingModel::G1, TrainingModel::G2, TrainingModel::G3, TrainingModel::G4>(out, "TrainingModel", random);
+}
+
 static void test_doc_example() {
 	using TrainPF = tpr::PenaltyFunction<tpr::TrainingModel::Fx, size_t, tpr::TrainingModel::G1, tpr::TrainingModel::G2, tpr::TrainingModel::G3, tpr::TrainingModel::G4>;
 	TrainPF::VectorT x0T{ 6.0f, 7.0f };
@@ -210,10 +696,30 @@ static void test_doc_example() {
 int main() {
 	
 	// 1. Try to find optimal solution for given constraints.
-	test_subj_17<tpr::subj_17::Config0>("x_opt.txt", 15);
+	test_subj_17<tpr::subj_17::Config0>("x_opt.txt", { 15, 18, 20, 24 });
 	//// 2. Let all resources were incresed 3 times.
-	test_subj_17<tpr::subj_17::Config2ResourceChanged>( "x_opt2.txt" );
+	test_subj_17<tpr::subj_17::Config2ResourceChanged>( "x_opt2.txt", { 15, 18, 20, 24 } );
 	// 3. add 4-th product.
-	test_subj_17_p4<tpr::subj_17_p4::Config0>("x_opt_p4.txt",20);
+	test_subj_17_p4<tpr::subj_17_p4::Config0>("x_opt_p4.txt", { 15, 18, 20, 24 });
+	// 4. what-if: resource 1 of factory 1 against the demand for A.
+	sweep_subj_17("x_sweep.txt");
+	// 5. subj_17 again, loaded from a model file.
+	solve_model("models/subj_17.model", "x_opt_model.txt");
+	// 6. the same model written as a binary file and solved from its mapping.
+	solve_mapped_model("models/subj_17.model", "subj_17.tprm", "x_opt_mapped.txt");
+	// 7. F(x, r[k]) of p4 at many points, one at a time and in batches.
+	batch_subj_17_p4("x_batch.txt");
+	// 8. gradient of every shipped model against differences of its apply.
+	check_model_gradients("x_gradient.txt");
+	// 9. the resources of 2. with x >= 0 by the augmented Lagrangian.
+	test_augmented_lagrangian<tpr::subj_17::Config2ResourceChanged>("x_opt_al.txt", 2490);
+	// 10. x >= 0 kept by projected L-BFGS and conjugate gradients.
+	test_bounded_descents("x_bounded.txt");
+	// 11. the resources of 2. with x >= 0 as barrier terms.
+	test_barrier<tpr::subj_17::Config2ResourceChanged>("x_opt_barrier.txt", 2490);
+	// 12. the same model as a CsrModel by the second-order cone solver.
+	test_cone_solver<tpr::subj_17::Config2ResourceChanged>("x_opt_cone.txt", 2490);
+	// 13. p4 with quantile 0, a linear program, by the simplex method through PenaltyFunction.
+	test_linear_program("x_opt_lp.txt", 3390);
 	return 0;
 }
\ No newline at end of file
@@ -2,64 +2,73 @@
 #include <map>
 #include <array>
 #include <cmath>
+#include <cstring>
 #include <string>
 
+#include "AutoDiff.hpp"
+#include "ChanceConstraint.hpp"
+
 namespace tpr {
 	namespace subj_17_p4 {
 
-		static std::map<int, int> model_index_to_index{
-			{ 111, 0 },
-			{ 112, 1 },
-			{ 121, 2 },
-			{ 122, 3 },
-			{ 131, 4 },
-			{ 132, 5 },
-			{ 141, 6},
-			{ 142, 7},
-			{ 211, 8 },
-			{ 212, 9 },
-			{ 221, 10 },
-			{ 222, 11 },
-			{ 231, 12 },
-			{ 232, 13 },
-			{ 241, 14 },
-			{ 242, 15 },
-			{ 311, 16 },
-			{ 312, 17 },
-			{ 321, 18 },
-			{ 322, 19 },
-			{ 331, 20 },
-			{ 332, 21 },
-			{ 341, 22 },
-			{ 342, 23 },
+		/**
+		 * model index -> position in the variable vector.
+		 * Resolved at compile time, args[ x111 ] is a plain array load.
+		 */
+		enum ModelIndex : size_t {
+			x111 = 0,
+			x112 = 1,
+			x121 = 2,
+			x122 = 3,
+			x131 = 4,
+			x132 = 5,
+			x141 = 6,
+			x142 = 7,
+			x211 = 8,
+			x212 = 9,
+			x221 = 10,
+			x222 = 11,
+			x231 = 12,
+			x232 = 13,
+			x241 = 14,
+			x242 = 15,
+			x311 = 16,
+			x312 = 17,
+			x321 = 18,
+			x322 = 19,
+			x331 = 20,
+			x332 = 21,
+			x341 = 22,
+			x342 = 23,
+			ModelIndexCount
 		};
 
-		static std::map<int, int> index_to_model_index_converter{
-			{ 0, 111 },
-			{ 1, 112 },
-			{ 2, 121 },
-			{ 3, 122 },
-			{ 4, 131 },
-			{ 5, 132 },
-			{ 6, 141 },
-			{ 7, 142 },
-			{ 8, 211 },
-			{ 9, 212 },
-			{ 10, 221 },
-			{ 11, 222 },
-			{ 12, 231 },
-			{ 13, 232 },
-			{ 14, 241 },
-			{ 15, 242 },
-			{ 16, 311 },
-			{ 17, 312 },
-			{ 18, 321 },
-			{ 19, 322 },
-			{ 20, 331 },
-			{ 21, 332 },
-			{ 22, 341 },
-			{ 23, 342 },
-		};
+		static constexpr std::array<int, ModelIndexCount> index_to_model_index_converter{ {
+			111,
+			112,
+			121,
+			122,
+			131,
+			132,
+			141,
+			142,
+			211,
+			212,
+			221,
+			222,
+			231,
+			232,
+			241,
+			242,
+			311,
+			312,
+			321,
+			322,
+			331,
+			332,
+			341,
+			342,
+		} };
 
 		static std::map<int, std::string> model_index_to_description_conv{
 			{ 111, "factory 1, product A, resource 1" },
@@ -174,6 +183,102 @@ namespace tpr {
 			static constexpr size_t NVariables = 24;
 		};
 
+		/**
+		 * what-if scenario: the Config parameters as runtime values.
+		 */
+		struct Scenario {
+			double FLaplassInverse;
+
+			double Resource11;	// R1
+			double Resource12;	// R2
+			double Resource21;	// R3
+			double Resource22;	// R4
+			double Resource31;	// R5
+			double Resource32;	// R6
+
+			double ASum;
+			double BSum;
+			double CSum;
+			double DSum;
+		};
+
+		/**
+		 * Config read at runtime: G1< RuntimeConfig<> > ... see the scenario set by the calling thread,
+		 * so one instantiation covers every scenario and worker threads do not disturb each other.
+		 * Starts out with the values of BaseCfg.
+		 */
+		template<typename BaseCfg = Config0>
+		class RuntimeConfig {
+		public:
+			using Scenario = subj_17_p4::Scenario;
+
+			static thread_local double FLaplassInverse;
+
+			static thread_local double Resource11;
+			static thread_local double Resource12;
+			static thread_local double Resource21;
+			static thread_local double Resource22;
+			static thread_local double Resource31;
+			static thread_local double Resource32;
+
+			static thread_local double ASum;
+			static thread_local double BSum;
+			static thread_local double CSum;
+			static thread_local double DSum;
+
+			static constexpr size_t NVariables = BaseCfg::NVariables;
+
+			static constexpr std::array<double Scenario::*, 11> Parameters{ {
+				&Scenario::FLaplassInverse,
+				&Scenario::Resource11, &Scenario::Resource12,
+				&Scenario::Resource21, &Scenario::Resource22,
+				&Scenario::Resource31, &Scenario::Resource32,
+				&Scenario::ASum, &Scenario::BSum, &Scenario::CSum, &Scenario::DSum
+			} };
+
+			static Scenario base() {
+				return {
+					BaseCfg::FLaplassInverse,
+					double(BaseCfg::Resource11), double(BaseCfg::Resource12),
+					double(BaseCfg::Resource21), double(BaseCfg::Resource22),
+					double(BaseCfg::Resource31), double(BaseCfg::Resource32),
+					double(BaseCfg::ASum), double(BaseCfg::BSum), double(BaseCfg::CSum), double(BaseCfg::DSum)
+				};
+			}
+
+			static Scenario get() {
+				return { FLaplassInverse, Resource11, Resource12, Resource21, Resource22, Resource31, Resource32, ASum, BSum, CSum, DSum };
+			}
+
+			static void set(const Scenario& scenario) {
+				FLaplassInverse = scenario.FLaplassInverse;
+				Resource11 = scenario.Resource11;
+				Resource12 = scenario.Resource12;
+				Resource21 = scenario.Resource21;
+				Resource22 = scenario.Resource22;
+				Resource31 = scenario.Resource31;
+				Resource32 = scenario.Resource32;
+				ASum = scenario.ASum;
+				BSum = scenario.BSum;
+				CSum = scenario.CSum;
+				DSum = scenario.DSum;
+			}
+		};
+
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::FLaplassInverse = BaseCfg::FLaplassInverse;
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::Resource11 = BaseCfg::Resource11;
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::Resource12 = BaseCfg::Resource12;
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::Resource21 = BaseCfg::Resource21;
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::Resource22 = BaseCfg::Resource22;
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::Resource31 = BaseCfg::Resource31;
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::Resource32 = BaseCfg::Resource32;
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::ASum = BaseCfg::ASum;
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::BSum = BaseCfg::BSum;
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::CSum = BaseCfg::CSum;
+		template<typename BaseCfg> thread_local double RuntimeConfig<BaseCfg>::DSum = BaseCfg::DSum;
+		template<typename BaseCfg> constexpr size_t RuntimeConfig<BaseCfg>::NVariables;
+		template<typename BaseCfg> constexpr std::array<double Scenario::*, 11> RuntimeConfig<BaseCfg>::Parameters;
+
 		template<typename T>
 		T sqr(T val) {
 			return val * val;
@@ -182,597 +287,162 @@ namespace tpr {
 		/**
 		 * f(x) = 3x111  + 3x112  + 9x121  + 9x122  + 5x131  + 5x132 + 3x141 + 3x142
 		 *      + 3x211  + 3x212  + 6x221  + 6x222  + 8x231  + 8x232 + 3x241 + 3x242
-		 *		+ 8x311  + 8x312  + 2x321  + 2x322  + 5x331  + 5x332 + 8x341 + 8x342
+		 *		+ 8x311  + 8x312  + 2x321  + 2x322  + 5x331  + 5x332 + 8x341 + 3x342
 		 */
 		struct Fx {
 			static constexpr size_t N = Config0::NVariables;
 			using ValueType = double;
 			using VectorT = std::array<ValueType, N>;
-
-			static ValueType apply(const VectorT& args) {
-				return 3.0 * args[model_index_to_index[111]] + 3.0 * args[model_index_to_index[112]] + 9.0 * args[model_index_to_index[121]] + 9.0 * args[model_index_to_index[122]] + 5.0 * args[model_index_to_index[131]] + 5.0 * args[model_index_to_index[132]] 
-							+ 3.0 * args[model_index_to_index[141]] + 3.0 * args[model_index_to_index[142]]
-					+ 3.0 * args[model_index_to_index[211]] + 3.0 * args[model_index_to_index[212]] + 6.0 * args[model_index_to_index[221]] + 6.0 * args[model_index_to_index[222]] + 8.0 * args[model_index_to_index[231]] + 8.0 * args[model_index_to_index[232]]  
-							+ 3.0 * args[model_index_to_index[241]] + 3.0 * args[model_index_to_index[242]]
-					+ 8.0 * args[model_index_to_index[311]] + 8.0 * args[model_index_to_index[312]] + 2.0 * args[model_index_to_index[321]] + 2.0 * args[model_index_to_index[322]] + 5.0 * args[model_index_to_index[331]] + 5.0 * args[model_index_to_index[332]]  
-							+ 8.0 * args[model_index_to_index[341]] + 3.0 * args[model_index_to_index[342]]
+			static constexpr bool Linear = true;
+
+			template<typename VecT>
+			static auto apply(const VecT& args) {
+				return 3.0 * args[x111] + 3.0 * args[x112] + 9.0 * args[x121] + 9.0 * args[x122] + 5.0 * args[x131] + 5.0 * args[x132] 
+							+ 3.0 * args[x141] + 3.0 * args[x142]
+					+ 3.0 * args[x211] + 3.0 * args[x212] + 6.0 * args[x221] + 6.0 * args[x222] + 8.0 * args[x231] + 8.0 * args[x232]  
+							+ 3.0 * args[x241] + 3.0 * args[x242]
+					+ 8.0 * args[x311] + 8.0 * args[x312] + 2.0 * args[x321] + 2.0 * args[x322] + 5.0 * args[x331] + 5.0 * args[x332]  
+							+ 8.0 * args[x341] + 3.0 * args[x342]
 					;
 			}
 
-			static VectorT gradient(const VectorT&) {
-				VectorT tmp;
-				// first row
-				tmp[model_index_to_index[111]] = 3.0f;
-				tmp[model_index_to_index[112]] = 3.0f;
-				tmp[model_index_to_index[121]] = 9.0f;
-				tmp[model_index_to_index[122]] = 9.0f;
-				tmp[model_index_to_index[131]] = 5.0f;
-				tmp[model_index_to_index[132]] = 5.0f;
-				
-				tmp[model_index_to_index[141]] = 1.0f;
-				tmp[model_index_to_index[142]] = 1.0f;
-
-				//2-nd row
-				tmp[model_index_to_index[211]] = 3.0f;
-				tmp[model_index_to_index[212]] = 3.0f;
-				tmp[model_index_to_index[221]] = 6.0f;
-				tmp[model_index_to_index[222]] = 6.0f;
-				tmp[model_index_to_index[231]] = 8.0f;
-				tmp[model_index_to_index[232]] = 8.0f;
-				
-				tmp[model_index_to_index[241]] = 1.0f;
-				tmp[model_index_to_index[242]] = 1.0f;
-
-				//3-rd row
-				tmp[model_index_to_index[311]] = 8.0f;
-				tmp[model_index_to_index[312]] = 8.0f;
-				tmp[model_index_to_index[321]] = 2.0f;
-				tmp[model_index_to_index[322]] = 2.0f;
-				tmp[model_index_to_index[331]] = 5.0f;
-				tmp[model_index_to_index[332]] = 5.0f;
-				
-				tmp[model_index_to_index[341]] = 1.0f;
-				tmp[model_index_to_index[342]] = 1.0f;
-				return tmp;
+			/**
+			 * c of f(x) = c' * x, by forward mode AD of apply
+			 */
+			static VectorT gradient(const VectorT& xargs) {
+				return AutoGradient<Fx>::gradient(xargs);
 			}
 		};
 
 		/**
-		 * g1(x) = 1.5x111 + 0.75x121 + 2.5*x131 + 1.5x141 + 1.282* sqrt( 0.083 * x111^2 + 0.0208*x121^2 + 0.083*x131^2 + 0.083x141^2 ) - 250 <= 0
+		 * g1(x) = 1.5x111 + 0.75x121 + 2.5x131 + 1.5x141 + 1.282 * sqrt( 0.083x111^2 + 0.0208x121^2 + 0.083x131^2 + 0.083x141^2 ) - R1 <= 0
 		 */
 		template<typename CfgParam>
-		struct G1 {
-			static constexpr size_t N = CfgParam::NVariables;
-			using ValueType = double;
-			using VectorT = std::array<ValueType, N>;
+		struct G1 : ChanceConstraint< G1<CfgParam>, CfgParam::NVariables, IndexList< x111, x121, x131, x141 > > {
+			static constexpr std::array<double, 4> coeffs() {
+				return {{ 1.5, 0.75, 2.5, 1.5 }};
+			}
 
-			// g1(x) = 1.5x111 + 0.75x121 + 2.5*x131 + 1.5x141 + 1.282* sqrt( 0.083 * x111^2 + 0.0208*x121^2 + 0.083*x131^2 + 0.083x141^2 ) - 250 <= 0
-			static ValueType apply(const VectorT& args) {
-				return 1.5 * args[model_index_to_index[111]] 
-					+ 0.75 * args[model_index_to_index[121]] 
-					+ 2.5 * args[model_index_to_index[131]] 
-					+ 1.5 * args[model_index_to_index[141]]
-					+ CfgParam::FLaplassInverse * std::sqrt(
-						0.083 * sqr(args[model_index_to_index[111]])
-						+ 0.0208 * sqr(args[model_index_to_index[121]])
-						+ 0.083 * sqr(args[model_index_to_index[131]])
-						+ 0.083 * sqr(args[model_index_to_index[141]])
-					) - CfgParam::Resource11
-					;
+			static constexpr std::array<double, 4> variances() {
+				return {{ 0.083, 0.0208, 0.083, 0.083 }};
 			}
 
-			/**
-			 * g1(x) = 1.5x111 + 0.75x121 + 2.5*x131 + 1.282* sqrt( 0.083 * x111^2 + 0.0208*x121^2 + 0.083*x131^2 ) - 250 <= 0
-			 * dg1/dx111 = (1.5 + 1.282 * 0.5 * ( 0.083x111^2 + 0.0208x121^2 + 0.083x131^2 + 0.083x141^2 )^(-0.5)) * 2 * 0.083x111
-			 * dg1/dx121 = (0.75 + 1.282 * 0.5 * ( 0.083x111^2 + 0.0208x121^2 + 0.083x131^2 + 0.083x141^2 )^(-0.5)) * 2 * 0.0208x121
-			 * dg1/dx131 = (2.5 + 1.282 * 0.5 * ( 0.083x111^2 + 0.0208x121^2 + 0.083x131^2 + 0.083x141^2 )^(-0.5)) * 2 * 0.083x131
-			 * dg1/dx141 = (1.5 + 1.282 * 0.5 * ( 0.083x111^2 + 0.0208x121^2 + 0.083x131^2 + 0.083x141^2 )^(-0.5)) * 2 * 0.083x141
-			 */
-			static VectorT gradient(const VectorT& xargs) {
-				VectorT tmp;
-				memset(&tmp[0], 0, sizeof(ValueType) * N);
-				//x111
-				// v[0]: dg1/dx111 = (1.5 + 1.282 * 0.5 * ( 0.083x111^2 + 0.0208x121^2 + 0.083x131^2 )^(-0.5)) * 2 * 0.083x111
-				tmp[model_index_to_index[111]] = 1.5 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.083 * sqr(xargs[model_index_to_index[111]]) 
-							+ 0.0208 * sqr(xargs[model_index_to_index[121]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[131]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[141]])
-						),
-						-0.5)
-					* 2 * 0.083 * xargs[model_index_to_index[111]];
-				// 121
-				// v[2]: dg1/dx121 = (0.75 + 1.282 * 0.5 * ( 0.083x111^2 + 0.0208x121^2 + 0.083x131^2 + 0.083 * sqr(xargs[model_index_to_index[141]]) )^(-0.5)) * 2 * 0.0208x121
-				tmp[model_index_to_index[121]] = 0.75 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.083 * sqr(xargs[model_index_to_index[111]]) 
-							+ 0.0208 * sqr(xargs[model_index_to_index[121]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[131]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[141]])
-						),
-						-0.5
-					)
-					* 2 * 0.0208 * xargs[model_index_to_index[121]];
-
-				// 131
-				// v[4]: dg1 / dx131 = (2.5 + 1.282 * 0.5 * (0.083x111 ^ 2 + 0.0208x121 ^ 2 + 0.083x131 ^ 2) ^ (-0.5)) * 2 * 0.083x131
-				tmp[model_index_to_index[131]] = 2.5 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.083 * sqr(xargs[model_index_to_index[111]]) 
-							+ 0.0208 * sqr(xargs[model_index_to_index[121]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[131]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[141]])
-						),
-						-0.5
-					)
-					* 2 * 0.083 * xargs[model_index_to_index[131]];
-
-				//x141
-				// dg1/dx141 = (1.5 + 1.282 * 0.5 * ( 0.083x111^2 + 0.0208x121^2 + 0.083x131^2 )^(-0.5)) * 2 * 0.083x111
-				tmp[model_index_to_index[141]] = 1.5 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.083 * sqr(xargs[model_index_to_index[111]]) 
-							+ 0.0208 * sqr(xargs[model_index_to_index[121]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[131]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[141]])
-						),
-						-0.5
-					)
-					* 2 * 0.083 * xargs[model_index_to_index[141]];
-				
-				return tmp;
+			static double laplassInverse() {
+				return CfgParam::FLaplassInverse;
+			}
+
+			static double resource() {
+				return CfgParam::Resource11;
 			}
 		};
 
 		/**
-		 * g2(x) = 3 * x_112 + 3 * x_122 + 3 * x_132 + 3 * x_142 + ^-1( 0.9 ) *sqrt( 0.33*x_112^2 + 0.33 * x_122^2 + 0.33 * x_132^2 + 0.33 * x_142^2 ) - 150 <= 0
+		 * g2(x) = 3x112 + 3x122 + 3x132 + 3x142 + 1.282 * sqrt( 0.33x112^2 + 0.33x122^2 + 0.33x132^2 + 0.33x142^2 ) - R2 <= 0
 		 */
 		template<typename CfgParam>
-		struct G2 {
-			static constexpr size_t N = CfgParam::NVariables;
-			using ValueType = double;
-			using VectorT = std::array<ValueType, N>;
+		struct G2 : ChanceConstraint< G2<CfgParam>, CfgParam::NVariables, IndexList< x112, x122, x132, x142 > > {
+			static constexpr std::array<double, 4> coeffs() {
+				return {{ 3, 3, 3, 3 }};
+			}
 
-			//g2(x) = 3 * x_112 + 3 * x_122 + 3 * x_132 + 3 * x_142 + ^-1( 0.9 ) *sqrt( 0.33*x_112^2 + 0.33 * x_122^2 + 0.33 * x_132^2 + 0.33 * x_142^2 ) - 150 <= 0
-			static ValueType apply(const VectorT& xargs) {
-				return 3.0 * xargs[model_index_to_index[112]] 
-					+ 3.0 * xargs[model_index_to_index[122]] 
-					+ 3.0 * xargs[model_index_to_index[132]] 
-					+ 3.0 * xargs[model_index_to_index[142]]
-					+ CfgParam::FLaplassInverse * std::sqrt(
-						0.33 * sqr(xargs[model_index_to_index[112]]) 
-						+ 0.33 * sqr(xargs[model_index_to_index[122]]) 
-						+ 0.33 * sqr(xargs[model_index_to_index[132]]) 
-						+ 0.33 * sqr(xargs[model_index_to_index[142]])
-					) - CfgParam::Resource12
-					;
+			static constexpr std::array<double, 4> variances() {
+				return {{ 0.33, 0.33, 0.33, 0.33 }};
 			}
 
-			/**
-			 * g2(x) = 3x112 + 3x122 + 3.0*x132 + 3x142 + 1.282* sqrt( 0.33 * x112^2 + 0.033*x122^2 + 0.33*x132^2 ) - 150 <= 0
-			 * dg2/dx112 = (3.0 + 1.282 * 0.5 * ( 0.33 * x112^2 + 0.33*x122^2 + 0.33*x132^2 + 0.33 * x142^2 )^(-0.5)) * 2 * 0.33x112
-			 * dg2/dx122 = (3.0 + 1.282 * 0.5 * ( 0.33 * x112^2 + 0.33*x122^2 + 0.33*x132^2 + 0.33 * x142^2 )^(-0.5)) * 2 * 0.33x122
-			 * dg2/dx132 = (3.0 + 1.282 * 0.5 * ( 0.33 * x112^2 + 0.33*x122^2 + 0.33*x132^2 + 0.33 * x142^2 )^(-0.5)) * 2 * 0.33x132
-			 * dg2/dx142 = (3.0 + 1.282 * 0.5 * ( 0.33 * x112^2 + 0.33*x122^2 + 0.33*x132^2 + 0.33 * x142^2 )^(-0.5)) * 2 * 0.33x142
-			 */
-			static VectorT gradient(const VectorT& xargs) {
-				VectorT tmp;
-				memset(&tmp[0], 0, sizeof(ValueType) * N);
-				//x112
-				// v[1]: dg1/dx112 = (3.0 + 1.282 * 0.5 * ( 0.33 * x112^2 + 0.33*x122^2 + 0.33*x132^2 + 0.33 * x142^2 )^(-0.5)) * 2 * 0.33x112
-				tmp[model_index_to_index[112]] = 3.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.33 * sqr(xargs[model_index_to_index[112]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[122]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[132]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[142]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[112]];
-				// 122
-				// v[3]: dg1/dx122 = (3.0 + 1.282 * 0.5 * ( 0.33 * x112^2 + 0.33*x122^2 + 0.33*x132^2 + 0.33 * x142^2 )^(-0.5)) * 2 * 0.33x122
-				tmp[model_index_to_index[122]] = 3.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.33 * sqr(xargs[model_index_to_index[112]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[122]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[132]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[142]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[122]];
-
-				// 132
-				// v[5]: dg1/dx132 = (3.0 + 1.282 * 0.5 * ( 0.33 * x112^2 + 0.33*x122^2 + 0.33*x132^2 + 0.33 * x142^2 )^(-0.5)) * 2 * 0.33x132
-				tmp[model_index_to_index[132]] = 3.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.33 * sqr(xargs[model_index_to_index[112]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[122]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[132]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[142]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[132]];
-
-				//x142
-				// dg2/dx142 = (3.0 + 1.282 * 0.5 * ( 0.33 * x112^2 + 0.33*x122^2 + 0.33*x132^2 + 0.33 * x142^2 )^(-0.5)) * 2 * 0.33x142
-				tmp[model_index_to_index[142]] = 3.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.33 * sqr(xargs[model_index_to_index[112]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[122]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[132]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[142]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[142]];
-				return tmp;
+			static double laplassInverse() {
+				return CfgParam::FLaplassInverse;
+			}
+
+			static double resource() {
+				return CfgParam::Resource12;
 			}
 		};
 
 		/**
-		 * g3(x) = 2 * x_211 + 1.25 * x_221 + 4 * x_231 + 2 * x_241 + ^-1( 0.9 ) *sqrt( 0.33*x_211^2 + 0.0208 * x_221^2 + 0.33 * x_231^2 + 0.33 * x_241^2 ) - 100 <= 0
+		 * g3(x) = 2x211 + 1.25x221 + 4x231 + 2x241 + 1.282 * sqrt( 0.33x211^2 + 0.0208x221^2 + 0.33x231^2 + 0.33x241^2 ) - R3 <= 0
 		 */
 		template<typename CfgParam>
-		struct G3 {
-			static constexpr size_t N = CfgParam::NVariables;
-			using ValueType = double;
-			using VectorT = std::array<ValueType, N>;
+		struct G3 : ChanceConstraint< G3<CfgParam>, CfgParam::NVariables, IndexList< x211, x221, x231, x241 > > {
+			static constexpr std::array<double, 4> coeffs() {
+				return {{ 2, 1.25, 4, 2 }};
+			}
 
-			// g3(x) = 2 * x_211 + 1.25 * x_221 + 4 * x_231 + 2 * x_241 + ^-1( 0.9 ) *sqrt( 0.33*x_211^2 + 0.0208 * x_221^2 + 0.33 * x_231^2 + 0.33 * x_241^2 ) - 100 <= 0
-			static ValueType apply(const VectorT& args) {
-				return 2.0 * args[model_index_to_index[211]] 
-					+ 1.25 * args[model_index_to_index[221]] 
-					+ 4.0 * args[model_index_to_index[231]] 
-					+ 2.0 * args[model_index_to_index[241]]
-					+ CfgParam::FLaplassInverse * std::sqrt(
-						0.33 * sqr(args[model_index_to_index[211]])
-						+ 0.0208 * sqr(args[model_index_to_index[221]])
-						+ 0.33 * sqr(args[model_index_to_index[231]])
-						+ 0.33 * sqr(args[model_index_to_index[241]])
-					) - CfgParam::Resource21
-					;
+			static constexpr std::array<double, 4> variances() {
+				return {{ 0.33, 0.0208, 0.33, 0.33 }};
 			}
 
-			/**
-			 * g3(x) = 2 * x_211 + 1.25 * x_221 + 4 * x_231 + 2 * x_241 + ^-1( 0.9 ) *sqrt( 0.33*x_211^2 + 0.0208 * x_221^2 + 0.33 * x_231^2 + 0.33 * x_241^2 ) - 100 <= 0
-			 * dg3/dx211 = 2 + 1.282*0.5*( 0.33x211^2 + 0.0208x221^2 + 0.33x231^2    + 0.33 * x_241^2)^ (-0.5) * 2 * 0.33x211
-			 * dg3/dx221 = 1.25 + 1.282*0.5*( 0.33x211^2 + 0.0208x221^2 + 0.33x231^2 + 0.33 * x_241^2)^ (-0.5) * 2 * 0.0208x221
-			 * dg3/dx231 = 4 + 1.282*0.5*( 0.33x211^2 + 0.0208x221^2 + 0.33x231^2    + 0.33 * x_241^2)^ (-0.5) * 2 * 0.33x231
-			 * dg3/dx241 = 2 + 1.282*0.5*( 0.33x211^2 + 0.0208x221^2 + 0.33x231^2    + 0.33 * x_241^2)^ (-0.5) * 2 * 0.33x241
-			 */
-			static VectorT gradient(const VectorT& xargs) {
-				VectorT tmp;
-				memset(&tmp[0], 0, sizeof(ValueType) * N);
-				// x211
-				// v[6]:  dg3/dx211 = 2 + 1.282*0.5*( 0.33x211^2 + 0.0208x221^2 + 0.33x231^2 + 0.33 * x_241^2 )^ (-0.5) * 2 * 0.33x211
-				tmp[model_index_to_index[211]] = 2.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.33 * sqr(xargs[model_index_to_index[211]])
-							+ 0.0208 * sqr(xargs[model_index_to_index[221]])
-							+ 0.33 * sqr(xargs[model_index_to_index[231]])
-							+ 0.33 * sqr(xargs[model_index_to_index[241]])
-						),
-						-0.5
-					) * 2 * 0.33 * xargs[model_index_to_index[211]];
-				// 221
-				// v[8]:  dg3/dx221 = 1.25 + 1.282*0.5*( 0.33x211^2 + 0.0208x221^2 + 0.33x231^2 + 0.33 * x_241^2 )^ (-0.5) * 2 * 0.0208x221
-				tmp[model_index_to_index[221]] = 1.25 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.33 * sqr(xargs[model_index_to_index[211]])
-							+ 0.0208 * sqr(xargs[model_index_to_index[221]])
-							+ 0.33 * sqr(xargs[model_index_to_index[231]])
-							+ 0.33 * sqr(xargs[model_index_to_index[241]])
-						),
-						-0.5
-					)
-					* 2 * 0.0208 * xargs[model_index_to_index[221]];
-
-				// 231
-				// v[10]: dg3/dx231 = 4 + 1.282*0.5*( 0.33x211^2 + 0.0208x221^2 + 0.33x231^2 + 0.33 * x_241^2 )^ (-0.5) * 2 * 0.33x231
-				tmp[model_index_to_index[231]] = 4.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.33 * sqr(xargs[model_index_to_index[211]])
-							+ 0.0208 * sqr(xargs[model_index_to_index[221]])
-							+ 0.33 * sqr(xargs[model_index_to_index[231]])
-							+ 0.33 * sqr(xargs[model_index_to_index[241]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[231]];
-
-				// x241
-				// dg3/dx241 = 2 + 1.282*0.5*( 0.33x211^2 + 0.0208x221^2 + 0.33x231^2 + 0.33 * x_241^2 )^ (-0.5) * 2 * 0.33x241
-				tmp[model_index_to_index[241]] = 2.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.33 * sqr(xargs[model_index_to_index[211]])
-							+ 0.0208 * sqr(xargs[model_index_to_index[221]])
-							+ 0.33 * sqr(xargs[model_index_to_index[231]])
-							+ 0.33 * sqr(xargs[model_index_to_index[241]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[241]];
-				return tmp;
+			static double laplassInverse() {
+				return CfgParam::FLaplassInverse;
+			}
+
+			static double resource() {
+				return CfgParam::Resource21;
 			}
 		};
 
 		/**
-		 * g4(x) = 5 * x_212 + 1.5 * x_222 + 5 * x_232 + 5 * x_242 + ^-1( 0.9 ) *sqrt( 1.33*x_212^2 + 0.083 * x_222^2 + 0.33 * x_232^2 + 1.33 * x_242^2 ) - 200 <= 0
+		 * g4(x) = 5x212 + 1.5x222 + 5x232 + 5x242 + 1.282 * sqrt( 1.33x212^2 + 0.083x222^2 + 0.33x232^2 + 1.33x242^2 ) - R4 <= 0
 		 */
 		template<typename CfgParam>
-		struct G4 {
-			static constexpr size_t N = CfgParam::NVariables;
-			using ValueType = double;
-			using VectorT = std::array<ValueType, N>;
+		struct G4 : ChanceConstraint< G4<CfgParam>, CfgParam::NVariables, IndexList< x212, x222, x232, x242 > > {
+			static constexpr std::array<double, 4> coeffs() {
+				return {{ 5, 1.5, 5, 5 }};
+			}
 
-			// g4(x) = 5 * x_212 + 1.5 * x_222 + 5 * x_232 + 5 * x_242 + ^-1( 0.9 ) *sqrt( 1.33*x_212^2 + 0.083 * x_222^2 + 0.33 * x_232^2 + 1.33 * x_242^2 ) - 200 <= 0
-			static ValueType apply(const VectorT& args) {
-				return 5.0 * args[model_index_to_index[212]] 
-					+ 1.5 * args[model_index_to_index[222]] 
-					+ 5.0 * args[model_index_to_index[232]] 
-					+ 5.0 * args[model_index_to_index[242]]
-					+ CfgParam::FLaplassInverse * std::sqrt(
-						1.33 * sqr(args[model_index_to_index[212]])
-						+ 0.083 * sqr(args[model_index_to_index[222]])
-						+ 0.33 * sqr(args[model_index_to_index[232]])
-						+ 1.33 * sqr(args[model_index_to_index[242]])
-					) - CfgParam::Resource22;
+			static constexpr std::array<double, 4> variances() {
+				return {{ 1.33, 0.083, 0.33, 1.33 }};
 			}
 
-			/**
-			 * g4(x) = 5 * x_212 + 1.5 * x_222 + 5 * x_232 + 5 * x_242 + ^-1( 0.9 ) *sqrt( 1.33*x_212^2 + 0.083 * x_222^2 + 0.33 * x_232^2 + 1.33 * x_242^2 ) - 200 <= 0
-			 * dg4/dx212 = 5 + 1.282 * 0.5 * ( 1.33 * x212^2 + 0.083*x222^2 + 0.33*x232^2 + 1.33 * x_242^2 )^( -0.5 ) * 2 * 1.33x212
-			 * dg4/dx222 = 1.5 + 1.282 * 0.5 * ( 1.33 * x212^2 + 0.083*x222^2 + 0.33*x232^2 + 1.33 * x_242^2 )^( -0.5 ) * 2 * 0.083x222
-			 * dg4/dx232 = 5 + 1.282 * 0.5 * ( 1.33 * x212^2 + 0.083*x222^2 + 0.33*x232^2  + 1.33 * x_242^2)^( -0.5 ) * 2 * 0.33x232
-			 * dg4/dx242 = 5 + 1.282 * 0.5 * ( 1.33 * x212^2 + 0.083*x222^2 + 0.33*x232^2 + 1.33 * x_242^2 )^( -0.5 ) * 2 * 1.33x242
-			 */
-			static VectorT gradient(const VectorT& xargs) {
-				VectorT grad;
-				memset(&grad[0], 0, sizeof(ValueType) * N);
-				//x212
-				// v[7]:  dg4/dx212 = 5 + 1.282 * 0.5 * ( 1.33 * x212^2 + 0.083*x222^2 + 0.33*x232^2 )^( -0.5 ) * 2 * 1.33x212
-				grad[model_index_to_index[212]] = 5.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							1.33 * sqr(xargs[model_index_to_index[212]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[222]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[232]]) 
-							+ 1.33 * sqr(xargs[model_index_to_index[242]])
-						),
-						-0.5
-					)
-					* 2 * 1.33 * xargs[model_index_to_index[212]];
-				// 222
-				grad[model_index_to_index[222]] = 1.5 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							1.33 * sqr(xargs[model_index_to_index[212]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[222]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[232]]) 
-							+ 1.33 * sqr(xargs[model_index_to_index[242]])
-						),
-						-0.5
-					)
-					* 2 * 0.083 * xargs[model_index_to_index[222]];
-
-				// 232
-				grad[model_index_to_index[232]] = 5.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							1.33 * sqr(xargs[model_index_to_index[212]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[222]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[232]]) 
-							+ 1.33 * sqr(xargs[model_index_to_index[242]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[232]];
-
-				// dg4/dx242 = 5 + 1.282 * 0.5 * ( 1.33 * x212^2 + 0.083*x222^2 + 0.33*x232^2 )^( -0.5 ) * 2 * 1.33x242
-				grad[model_index_to_index[242]] = 5.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							1.33 * sqr(xargs[model_index_to_index[212]]) 
-							+ 0.083 * sqr(xargs[model_index_to_index[222]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[232]]) 
-							/*+ 1.33 * sqr(xargs[model_index_to_index[242]])*/
-						),
-						-0.5
-					)
-					* 2 * 1.33 * xargs[model_index_to_index[242]];
+			static double laplassInverse() {
+				return CfgParam::FLaplassInverse;
+			}
 
-				return grad;
+			static double resource() {
+				return CfgParam::Resource22;
 			}
 		};
 
 		/**
-		 * g5(x) = 2.5 * x_311 + 2 * x_321 + 2 * x_331 + 2.5 * x_341 + ^-1( 0.9 ) *sqrt( 0.75*x_311^2 + 0.33 * x_321^2 + 0.33 * x_331^2 + 0.75 * x_341^2 ) - 240 <= 0
+		 * g5(x) = 2.5x311 + 2x321 + 2x331 + 2.5x341 + 1.282 * sqrt( 0.75x311^2 + 0.33x321^2 + 0.33x331^2 + 0.75x341^2 ) - R5 <= 0
 		 */
 		template<typename CfgParam>
-		struct G5 {
-			static constexpr size_t N = CfgParam::NVariables;
-			using ValueType = double;
-			using VectorT = std::array<ValueType, N>;
+		struct G5 : ChanceConstraint< G5<CfgParam>, CfgParam::NVariables, IndexList< x311, x321, x331, x341 > > {
+			static constexpr std::array<double, 4> coeffs() {
+				return {{ 2.5, 2, 2, 2.5 }};
+			}
 
-			// g5(x) = 2.5 * x_311 + 2 * x_321 + 2 * x_331 + 2.5 * x_341 + ^-1( 0.9 ) *sqrt( 0.75*x_311^2 + 0.33 * x_321^2 + 0.33 * x_331^2 + 0.75 * x_341^2 ) - 240 <= 0
-			static ValueType apply(const VectorT& args) {
-				return 2.5 * args[model_index_to_index[311]] 
-					+ 2.0 * args[model_index_to_index[321]] 
-					+ 2.0 * args[model_index_to_index[331]] 
-					+ 2.5 * args[model_index_to_index[341]]
-					+ CfgParam::FLaplassInverse * std::sqrt(
-						0.75 * sqr(args[model_index_to_index[311]])
-						+ 0.33 * sqr(args[model_index_to_index[321]])
-						+ 0.33 * sqr(args[model_index_to_index[331]])
-						+ 0.75 * sqr(args[model_index_to_index[341]])
-					) - CfgParam::Resource31;
+			static constexpr std::array<double, 4> variances() {
+				return {{ 0.75, 0.33, 0.33, 0.75 }};
 			}
 
-			/**
-			 * g5(x) = 2.5 * x_311 + 2 * x_321 + 2 * x_331 + 2.5 * x_341 + ^-1( 0.9 ) *sqrt( 0.75*x_311^2 + 0.33 * x_321^2 + 0.33 * x_331^2 + 0.75 * x_341^2 ) - 240 <= 0
-			 * dg5/dx311 = 2.5 + 1.282 * 0.5 * ( 0.75 * x311^2 + 0.33*x321^2 + 0.33*x331^2 + 0.75 * x_341^2 )^-0.5 * 2 * 0.75 * x311
-			 * dg5/dx321 = 2.0 + 1.282 * 0.5 * ( 0.75 * x311^2 + 0.33*x321^2 + 0.33*x331^2 + 0.75 * x_341^2)^-0.5 * 2 * 0.33 * x321
-			 * dg5/dx331 = 2.0 + 1.282 * 0.5 * ( 0.75 * x311^2 + 0.33*x321^2 + 0.33*x331^2 + 0.75 * x_341^2)^-0.5 * 2 * 0.33 * x331
-			 * dg5/dx341 = 2.5 + 1.282 * 0.5 * ( 0.75 * x311^2 + 0.33*x321^2 + 0.33*x331^2 + 0.75 * x_341^2 )^-0.5 * 2 * 0.75 * x341
-			 */
-			static VectorT gradient(const VectorT& xargs) {
-				VectorT grad;
-				memset(&grad[0], 0, sizeof(ValueType) * N);
-				//x311
-				grad[model_index_to_index[311]] = 2.5 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.75 * sqr(xargs[model_index_to_index[311]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[321]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[331]]) 
-							+ 0.75 * sqr(xargs[model_index_to_index[341]])
-						),
-						-0.5
-					)
-					* 2 * 0.75 * xargs[model_index_to_index[311]];
-				// 321
-				grad[model_index_to_index[321]] = 2.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.75 * sqr(xargs[model_index_to_index[311]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[321]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[331]]) 
-							+ 0.75 * sqr(xargs[model_index_to_index[341]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[321]];
-
-				// 331
-				grad[model_index_to_index[331]] = 2.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.75 * sqr(xargs[model_index_to_index[311]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[321]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[331]]) 
-							+ 0.75 * sqr(xargs[model_index_to_index[341]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[331]];
-
-				//x341
-				grad[model_index_to_index[341]] = 2.5 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							0.75 * sqr(xargs[model_index_to_index[311]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[321]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[331]]) 
-							/*+ 0.75 * sqr(xargs[model_index_to_index[341]])*/
-						),
-						-0.5
-					)
-					* 2 * 0.75 * xargs[model_index_to_index[341]];
-				
-				return grad;
+			static double laplassInverse() {
+				return CfgParam::FLaplassInverse;
+			}
+
+			static double resource() {
+				return CfgParam::Resource31;
 			}
 		};
 
 		/**
-		 * g6(x) = 4 * x_312 + 4 * x_322 + 7 * x_332 + 4 * x_342 + ^-1( 0.9 ) *sqrt( 1.33*x_312^2 + 0.33 * x_322^2 + 0.33 * x_332^2 + 1.33 * x_342^2 ) - 300 <= 0
+		 * g6(x) = 4x312 + 4x322 + 7x332 + 4x342 + 1.282 * sqrt( 1.33x312^2 + 0.33x322^2 + 0.33x332^2 + 1.33x342^2 ) - R6 <= 0
 		 */
 		template<typename CfgParam>
-		struct G6 {
-			static constexpr size_t N = CfgParam::NVariables;
-			using ValueType = double;
-			using VectorT = std::array<ValueType, N>;
+		struct G6 : ChanceConstraint< G6<CfgParam>, CfgParam::NVariables, IndexList< x312, x322, x332, x342 > > {
+			static constexpr std::array<double, 4> coeffs() {
+				return {{ 4, 4, 7, 4 }};
+			}
 
-			// g6(x) = 4 * x_312 + 4 * x_322 + 7 * x_332 + 4 * x_342 + ^-1( 0.9 ) *sqrt( 1.33*x_312^2 + 0.33 * x_322^2 + 0.33 * x_332^2 + 1.33 * x_342^2 ) - 300 <= 0
-			static ValueType apply(const VectorT& args) {
-				return 4.0 * args[model_index_to_index[312]] 
-					+ 4.0 * args[model_index_to_index[322]] 
-					+ 7.0 * args[model_index_to_index[332]] 
-					+ 4.0 * args[model_index_to_index[342]]
-					+ CfgParam::FLaplassInverse * std::sqrt(
-						1.33 * sqr(args[model_index_to_index[312]])
-						+ 0.33 * sqr(args[model_index_to_index[322]])
-						+ 0.33 * sqr(args[model_index_to_index[332]])
-						+ 1.33 * sqr(args[model_index_to_index[342]])
-					) - CfgParam::Resource32;
+			static constexpr std::array<double, 4> variances() {
+				return {{ 1.33, 0.33, 0.33, 1.33 }};
 			}
 
-			/**
-			 * g6(x) = 4 * x_312 + 4 * x_322 + 7 * x_332 + 4 * x_342 + ^-1( 0.9 ) *sqrt( 1.33*x_312^2 + 0.33 * x_322^2 + 0.33 * x_332^2 + 1.33 * x_342^2 ) - 300 <= 0
-			 * dg6/dx312 = 4 + 1.282 * 0.5 * ( 1.33 * x312^2 + 0.33*x322^2 + 0.33*x332^2 + 1.33 * x_342^2) ^ -0.5 * 2 * 1.33 * x312
-			 * dg6/dx322 = 4 + 1.282 * 0.5 * ( 1.33 * x312^2 + 0.33*x322^2 + 0.33*x332^2 + 1.33 * x_342^2) ^ -0.5 * 2 * 0.33 * x322
-			 * dg6/dx332 = 7 + 1.282 * 0.5 * ( 1.33 * x312^2 + 0.33*x322^2 + 0.33*x332^2 + 1.33 * x_342^2) ^ -0.5 * 2 * 0.33 * x332
-			 * dg6/dx342 = 4 + 1.282 * 0.5 * ( 1.33 * x312^2 + 0.33*x322^2 + 0.33*x332^2 + 1.33 * x_342^2) ^ -0.5 * 2 * 1.33 * x342
-			 */
-			static VectorT gradient(const VectorT& xargs) {
-				VectorT grad;
-				memset(&grad[0], 0, sizeof(ValueType) * N);
-				//x312
-				grad[model_index_to_index[312]] = 4.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							1.33 * sqr(xargs[model_index_to_index[312]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[322]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[332]]) 
-							+ 1.33 * sqr(xargs[model_index_to_index[342]])
-						),
-						-0.5
-					)
-					* 2 * 1.33 * xargs[model_index_to_index[312]];
-				// 322
-				grad[model_index_to_index[322]] = 4.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							1.33 * sqr(xargs[model_index_to_index[312]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[322]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[332]]) 
-							+ 1.33 * sqr(xargs[model_index_to_index[342]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[322]];
-
-				// 332
-				grad[model_index_to_index[332]] = 7.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							1.33 * sqr(xargs[model_index_to_index[312]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[322]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[332]]) 
-							+ 1.33 * sqr(xargs[model_index_to_index[342]])
-						),
-						-0.5
-					)
-					* 2 * 0.33 * xargs[model_index_to_index[332]];
-
-				//x342
-				grad[model_index_to_index[342]] = 4.0 + CfgParam::FLaplassInverse * 0.5
-					* std::pow(
-						(
-							1.33 * sqr(xargs[model_index_to_index[312]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[322]]) 
-							+ 0.33 * sqr(xargs[model_index_to_index[332]]) 
-							/*+ 1.33 * sqr(xargs[model_index_to_index[342]])*/
-						),
-						-0.5
-					)
-					* 2 * 1.33 * xargs[model_index_to_index[342]];
-				return grad;
+			static double laplassInverse() {
+				return CfgParam::FLaplassInverse;
+			}
+
+			static double resource() {
+				return CfgParam::Resource32;
 			}
 		};
 
@@ -781,34 +451,31 @@ namespace tpr {
 			static constexpr size_t N = CfgParam::NVariables;
 			using ValueType = double;
 			using VectorT = std::array<ValueType, N>;
+			static constexpr bool Linear = true;
+			using Sparsity = IndexList< x111, x112, x211, x212, x311, x312 >;
+			using SparseVectorT = std::array<ValueType, Sparsity::Size>;
 
 			// g7(x) = 300 - x111 - x112 - x211 - x212 - x311 - x312 <= 0
-			static ValueType apply(const VectorT& args) {
-				return CfgParam::ASum - args[model_index_to_index[111]] - args[model_index_to_index[112]]
-					- args[model_index_to_index[211]] - args[model_index_to_index[212]]
-					- args[model_index_to_index[311]] - args[model_index_to_index[312]];
+			template<typename VecT>
+			static auto apply(const VecT& args) {
+				return CfgParam::ASum - args[x111] - args[x112]
+					- args[x211] - args[x212]
+					- args[x311] - args[x312];
 			}
 
-			/**
-			 * g7(x) = 300 - x111 - x112 - x211 - x212 - x311 - x312 <= 0
-			 * v[0]:  dg7/dx111 = -1
-			 * v[1]:  dg7/dx112 = -1
-			 * v[6]:  dg7/dx211 = -1
-			 * v[7]:  dg7/dx212 = -1
-			 * v[12]: dg7/dx311 = -1
-			 * v[13]: dg7/dx312 = -1
-			 */
-			static VectorT gradient(const VectorT&) {
+			static VectorT gradient(const VectorT& xargs) {
+				ValueType value;
 				VectorT grad;
-				memset(&grad[0], 0, sizeof(ValueType) * N);
-				grad[model_index_to_index[111]] = -1.0;
-				grad[model_index_to_index[112]] = -1.0;
-				grad[model_index_to_index[211]] = -1.0;
-				grad[model_index_to_index[212]] = -1.0;
-				grad[model_index_to_index[311]] = -1.0;
-				grad[model_index_to_index[312]] = -1.0;
+				Evaluator<G7>::evaluate(xargs, value, grad);
 				return grad;
 			}
+
+			/**
+			 * g7(x) and its nonzero gradient entries in Sparsity order, by forward mode AD of apply
+			 */
+			static void evaluate_sparse(const VectorT& xargs, ValueType& value, SparseVectorT& grad) {
+				AutoGradient<G7>::evaluate_sparse(xargs, value, grad);
+			}
 		};
 
 		/**
@@ -819,34 +486,31 @@ namespace tpr {
 			static constexpr size_t N = CfgParam::NVariables;
 			using ValueType = double;
 			using VectorT = std::array<ValueType, N>;
+			static constexpr bool Linear = true;
+			using Sparsity = IndexList< x121, x122, x221, x222, x321, x322 >;
+			using SparseVectorT = std::array<ValueType, Sparsity::Size>;
 
 			// g8(x) = 170 - x121 - x122 - x221 - x222 - x321 - x322 <= 0
-			static ValueType apply(const VectorT& args) {
-				return CfgParam::BSum - args[model_index_to_index[121]] - args[model_index_to_index[122]]
-					- args[model_index_to_index[221]] - args[model_index_to_index[222]]
-					- args[model_index_to_index[321]] - args[model_index_to_index[322]];
+			template<typename VecT>
+			static auto apply(const VecT& args) {
+				return CfgParam::BSum - args[x121] - args[x122]
+					- args[x221] - args[x222]
+					- args[x321] - args[x322];
 			}
 
-			/**
-			 * g8(x) = 170 - x121 - x122 - x221 - x222 - x321 - x322 <= 0
-			 * grad[2]:  dg8/dx121 = -1
-			 * grad[3]:  dg8/dx122 = -1
-			 * grad[8]:  dg8/dx221 = -1
-			 * grad[9]:  dg8/dx222 = -1
-			 * grad[14]: dg8/dx321 = -1
-			 * grad[15]: dg8/dx322 = -1
-			 */
-			static VectorT gradient(const VectorT&) {
+			static VectorT gradient(const VectorT& xargs) {
+				ValueType value;
 				VectorT grad;
-				memset(&grad[0], 0, sizeof(ValueType) * N);
-				grad[model_index_to_index[121]] = -1.0;
-				grad[model_index_to_index[122]] = -1.0;
-				grad[model_index_to_index[221]] = -1.0;
-				grad[model_index_to_index[222]] = -1.0;
-				grad[model_index_to_index[321]] = -1.0;
-				grad[model_index_to_index[322]] = -1.0;
+				Evaluator<G8>::evaluate(xargs, value, grad);
 				return grad;
 			}
+
+			/**
+			 * g8(x) and its nonzero gradient entries in Sparsity order, by forward mode AD of apply
+			 */
+			static void evaluate_sparse(const VectorT& xargs, ValueType& value, SparseVectorT& grad) {
+				AutoGradient<G8>::evaluate_sparse(xargs, value, grad);
+			}
 		};
 
 		/**
@@ -857,34 +521,31 @@ namespace tpr {
 			static constexpr size_t N = CfgParam::NVariables;
 			using ValueType = double;
 			using VectorT = std::array<ValueType, N>;
+			static constexpr bool Linear = true;
+			using Sparsity = IndexList< x131, x132, x231, x232, x331, x332 >;
+			using SparseVectorT = std::array<ValueType, Sparsity::Size>;
 
 			// g9(x) = 250 - x131 - x132 - x231 - x232 - x331 - x332 <= 0
-			static ValueType apply(const VectorT& args) {
-				return CfgParam::CSum - args[model_index_to_index[131]] - args[model_index_to_index[132]]
-					- args[model_index_to_index[231]] - args[model_index_to_index[232]]
-					- args[model_index_to_index[331]] - args[model_index_to_index[332]];
+			template<typename VecT>
+			static auto apply(const VecT& args) {
+				return CfgParam::CSum - args[x131] - args[x132]
+					- args[x231] - args[x232]
+					- args[x331] - args[x332];
 			}
 
-			/**
-			 * g9(x) = 250 - x131 - x132 - x231 - x232 - x331 - x332 <= 0
-			 * grad[4]:  dg9/dx131 = -1
-			 * grad[5]:  dg9/dx132 = -1
-			 * grad[10]:  dg9/dx231 = -1
-			 * grad[11]:  dg9/dx232 = -1
-			 * grad[16]: dg9/dx331 = -1
-			 * grad[17]: dg9/dx332 = -1
-			 */
-			static VectorT gradient(const VectorT&) {
+			static VectorT gradient(const VectorT& xargs) {
+				ValueType value;
 				VectorT grad;
-				memset(&grad[0], 0, sizeof(ValueType) * N);
-				grad[model_index_to_index[131]] = -1.0;
-				grad[model_index_to_index[132]] = -1.0;
-				grad[model_index_to_index[231]] = -1.0;
-				grad[model_index_to_index[232]] = -1.0;
-				grad[model_index_to_index[331]] = -1.0;
-				grad[model_index_to_index[332]] = -1.0;
+				Evaluator<G9>::evaluate(xargs, value, grad);
 				return grad;
 			}
+
+			/**
+			 * g9(x) and its nonzero gradient entries in Sparsity order, by forward mode AD of apply
+			 */
+			static void evaluate_sparse(const VectorT& xargs, ValueType& value, SparseVectorT& grad) {
+				AutoGradient<G9>::evaluate_sparse(xargs, value, grad);
+			}
 		};
 
 		/**
@@ -895,34 +556,31 @@ namespace tpr {
 			static constexpr size_t N = CfgParam::NVariables;
 			using ValueType = double;
 			using VectorT = std::array<ValueType, N>;
+			static constexpr bool Linear = true;
+			using Sparsity = IndexList< x141, x142, x241, x242, x341, x342 >;
+			using SparseVectorT = std::array<ValueType, Sparsity::Size>;
 
 			// g9(x) = 250 - x131 - x132 - x231 - x232 - x331 - x332 <= 0
-			static ValueType apply(const VectorT& args) {
-				return CfgParam::DSum - args[model_index_to_index[141]] - args[model_index_to_index[142]]
-					- args[model_index_to_index[241]] - args[model_index_to_index[242]]
-					- args[model_index_to_index[341]] - args[model_index_to_index[342]];
+			template<typename VecT>
+			static auto apply(const VecT& args) {
+				return CfgParam::DSum - args[x141] - args[x142]
+					- args[x241] - args[x242]
+					- args[x341] - args[x342];
 			}
 
-			/**
-			 * g9(x) = 250 - x131 - x132 - x231 - x232 - x331 - x332 <= 0
-			 * grad[4]:  dg9/dx131 = -1
-			 * grad[5]:  dg9/dx132 = -1
-			 * grad[10]:  dg9/dx231 = -1
-			 * grad[11]:  dg9/dx232 = -1
-			 * grad[16]: dg9/dx331 = -1
-			 * grad[17]: dg9/dx332 = -1
-			 */
-			static VectorT gradient(const VectorT&) {
+			static VectorT gradient(const VectorT& xargs) {
+				ValueType value;
 				VectorT grad;
-				memset(&grad[0], 0, sizeof(ValueType) * N);
-				grad[model_index_to_index[141]] = -1.0;
-				grad[model_index_to_index[142]] = -1.0;
-				grad[model_index_to_index[241]] = -1.0;
-				grad[model_index_to_index[242]] = -1.0;
-				grad[model_index_to_index[341]] = -1.0;
-				grad[model_index_to_index[342]] = -1.0;
+				Evaluator<G10>::evaluate(xargs, value, grad);
 				return grad;
 			}
+
+			/**
+			 * g10(x) and its nonzero gradient entries in Sparsity order, by forward mode AD of apply
+			 */
+			static void evaluate_sparse(const VectorT& xargs, ValueType& value, SparseVectorT& grad) {
+				AutoGradient<G10>::evaluate_sparse(xargs, value, grad);
+			}
 		};
 	}// namespace subj_17_p4
 